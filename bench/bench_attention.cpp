@@ -0,0 +1,207 @@
+// Google Benchmark suite for attention_forward.
+//
+// One family, BM_AttentionForward, over a grid of
+// (engine, B, H, N, D, causal, masked, threads). Every run reports:
+//
+//   FLOPS        2*D multiply-adds for QK^T plus 2*D for PV per visible
+//                (query, key) pair, per second (causal / padding shrink it)
+//   bytes        compulsory traffic per call: Q, K, V read once, O written
+//                once, plus the packed padding bits
+//   bytes_per_second
+//   s_per_token  wall time per query token (B*N tokens per call)
+//
+// JSON for bench/compare.py:
+//   bench --benchmark_format=json --benchmark_out=run.json
+// Narrow the grid with --benchmark_filter, e.g. 'engine:1/.*/N:2048'.
+//
+// BM_LongContext times one causal stream (B=1) of N_q queries over N_k
+// keys with split-K off and automatic, the flash-decoding case.
+//
+// BM_PackedKeys times repeated scoring against fixed keys: row-major K/V
+// (packed:0) against K/V prepared once with pack_kv (packed:1).
+//
+// BM_StatsOverhead times one tiled call with opts.stats unset (stats:0),
+// counters on (stats:1) and counters plus trace events (stats:2); the ratio
+// of the rows is the instrumentation overhead. Build with
+// -DFA_ENABLE_STATS=OFF to compare against the compiled-out layer.
+#include "fa/attention.hpp"
+#include "fa/mask.hpp"
+#include "fa/stats.hpp"
+#include "fa/tensor.hpp"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using namespace fa;
+
+namespace {
+
+enum Arg { kEngine, kB, kH, kN, kD, kCausal, kMasked, kThreads };
+
+// Padded batches keep 3/4 of the keys of odd batch entries.
+std::vector<int> key_lengths(int B, int N, bool masked) {
+  std::vector<int> len(B, N);
+  if (masked) for (int b=1; b<B; b+=2) len[b] = N*3/4;
+  if (masked && B == 1) len[0] = N*3/4;
+  return len;
+}
+
+// Visible (query, key) pairs of one head.
+double visible_pairs(int N, bool causal, int keys) {
+  if (!causal) return (double)N*keys;
+  // query i sees keys [0, min(i+1, keys))
+  double s = (double)keys*(keys+1)/2;
+  return s + (double)(N - keys)*keys;
+}
+
+void BM_AttentionForward(benchmark::State& state) {
+  const auto engine = state.range(kEngine) ? AttentionEngine::Tiled : AttentionEngine::Reference;
+  const int B = (int)state.range(kB), H = (int)state.range(kH);
+  const int N = (int)state.range(kN), D = (int)state.range(kD);
+  const bool causal = state.range(kCausal) != 0, masked = state.range(kMasked) != 0;
+
+  Tensor Q = Tensor::randn({B,H,N,D}, 1, 0);
+  Tensor K = Tensor::randn({B,H,N,D}, 2, 0);
+  Tensor V = Tensor::randn({B,H,N,D}, 3, 0);
+  const std::vector<int> len = key_lengths(B, N, masked);
+  const PaddingBitmask pad = PaddingBitmask::from_lengths(len, N);
+  AttentionMask mask;
+  if (masked) mask.padding = &pad;
+
+  AttentionOpts opts;
+  opts.engine = engine;
+  opts.causal = causal;
+  opts.num_threads = (int)state.range(kThreads);
+
+  for (auto _ : state) {
+    Tensor O = attention_forward(Q.view(), K.view(), V.view(), mask, opts);
+    benchmark::DoNotOptimize(O.data());
+    benchmark::ClobberMemory();
+  }
+
+  double pairs = 0.0;
+  for (int b=0; b<B; ++b) pairs += H*visible_pairs(N, causal, len[b]);
+  const double bytes = 4.0*sizeof(float)*B*H*N*D + (masked ? (double)B*pad.words_per_row()*8 : 0.0);
+  state.counters["FLOPS"] = benchmark::Counter(4.0*D*pairs, benchmark::Counter::kIsIterationInvariantRate,
+                                               benchmark::Counter::kIs1000);
+  state.counters["bytes"] = bytes;
+  state.counters["s_per_token"] = benchmark::Counter((double)B*N,
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+  state.SetBytesProcessed((int64_t)(bytes*state.iterations()));
+  state.SetLabel(engine == AttentionEngine::Tiled ? "tiled" : "reference");
+}
+
+// The reference engine is O(N^2) scalar work per head; keep it to N <= 512
+// so a full run stays in minutes. Thread scaling is only timed at the
+// largest N, which keeps the family under Google Benchmark's 100-input limit.
+void grid(benchmark::internal::Benchmark* b) {
+  for (int engine : {0, 1})
+  for (int B : {1, 4})
+  for (int N : {128, 512, 2048})
+  for (int D : {64, 128})
+  for (int causal : {0, 1})
+  for (int masked : {0, 1})
+  for (int threads : {1, 0}) {
+    if (engine == 0 && N > 512) continue;
+    if (threads != 1 && (engine == 0 || N < 2048)) continue;
+    b->Args({engine, B, 8, N, D, causal, masked, threads});
+  }
+}
+
+// Single-stream long context: a short query chunk over N_k keys, with
+// split-K off (kv_splits:1) or automatic (kv_splits:0).
+void BM_LongContext(benchmark::State& state) {
+  const int Nq = (int)state.range(0), Nk = (int)state.range(1), D = 128, H = 8;
+  Tensor Q = Tensor::randn({1,H,Nq,D}, 1, 0);
+  Tensor K = Tensor::randn({1,H,Nk,D}, 2, 0);
+  Tensor V = Tensor::randn({1,H,Nk,D}, 3, 0);
+  AttentionOpts opts;
+  opts.engine = AttentionEngine::Tiled;
+  opts.causal = true;
+  opts.kv_splits = (int)state.range(2);
+  opts.num_threads = 0;
+
+  for (auto _ : state) {
+    Tensor O = attention_forward(Q.view(), K.view(), V.view(), AttentionMask{}, opts);
+    benchmark::DoNotOptimize(O.data());
+    benchmark::ClobberMemory();
+  }
+  state.counters["s_per_token"] = benchmark::Counter((double)Nq,
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+  state.SetBytesProcessed((int64_t)(2.0*sizeof(float)*H*Nk*D*state.iterations()));
+}
+
+// Short query chunks against the same N_k keys; packing is outside the loop.
+void BM_PackedKeys(benchmark::State& state) {
+  const int Nq = (int)state.range(0), Nk = (int)state.range(1), D = 128, H = 8;
+  const bool packed = state.range(2) != 0;
+  Tensor Q = Tensor::randn({1,H,Nq,D}, 1, 0);
+  Tensor K = Tensor::randn({1,H,Nk,D}, 2, 0);
+  Tensor V = Tensor::randn({1,H,Nk,D}, 3, 0);
+  const PackedKV kv = pack_kv(K.view(), V.view());
+  AttentionOpts opts;
+  opts.engine = AttentionEngine::Tiled;
+  opts.num_threads = 0;
+
+  for (auto _ : state) {
+    Tensor O = packed ? attention_forward_packed(Q.view(), kv, AttentionMask{}, opts)
+                      : attention_forward(Q.view(), K.view(), V.view(), AttentionMask{}, opts);
+    benchmark::DoNotOptimize(O.data());
+    benchmark::ClobberMemory();
+  }
+  state.counters["s_per_token"] = benchmark::Counter((double)Nq,
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+  state.SetBytesProcessed((int64_t)(2.0*sizeof(float)*H*Nk*D*state.iterations()));
+}
+
+// Same call with the instrumentation off, counting, and tracing.
+void BM_StatsOverhead(benchmark::State& state) {
+  const int mode = (int)state.range(0), B = 2, H = 8, N = 512, D = 64;
+  Tensor Q = Tensor::randn({B,H,N,D}, 1, 0);
+  Tensor K = Tensor::randn({B,H,N,D}, 2, 0);
+  Tensor V = Tensor::randn({B,H,N,D}, 3, 0);
+  AttentionStats st;
+  st.record_trace = mode == 2;
+  AttentionOpts opts;
+  opts.engine = AttentionEngine::Tiled;
+  opts.causal = true;
+  opts.num_threads = (int)state.range(1);
+  if (mode > 0) opts.stats = &st;
+
+  for (auto _ : state) {
+    Tensor O = attention_forward(Q.view(), K.view(), V.view(), AttentionMask{}, opts);
+    benchmark::DoNotOptimize(O.data());
+    benchmark::ClobberMemory();
+    st.reset();   // keep the trace from growing across iterations
+  }
+  state.counters["s_per_token"] = benchmark::Counter((double)B*N,
+      benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+  state.SetLabel(stats_compiled_in() ? "stats compiled in" : "stats compiled out");
+}
+
+} // namespace
+
+BENCHMARK(BM_StatsOverhead)
+    ->ArgNames({"stats", "threads"})
+    ->ArgsProduct({{0, 1, 2}, {1, 0}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_PackedKeys)
+    ->ArgNames({"Nq", "Nk", "packed"})
+    ->ArgsProduct({{1, 16}, {4096, 32768}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_LongContext)
+    ->ArgNames({"Nq", "Nk", "kv_splits"})
+    ->ArgsProduct({{1, 16}, {16384, 131072}, {1, 0}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_AttentionForward)
+    ->ArgNames({"engine", "B", "H", "N", "D", "causal", "masked", "threads"})
+    ->Apply(grid)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
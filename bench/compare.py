@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Compare attention benchmark runs and flag regressions.
+
+Two builds (same benchmark names in both files):
+    compare.py builds base.json new.json [--threshold 0.05]
+
+Two engines from one run (same shape, engine:0 vs engine:1):
+    compare.py engines run.json [--base 0 --contender 1] [--threshold 0.05]
+
+Both files come from `bench --benchmark_format=json --benchmark_out=FILE`.
+Repeated runs (--benchmark_repetitions) are reduced to their median. A
+benchmark regresses when the contender's real time exceeds the base's by
+more than the threshold; the exit status is 1 if any did.
+"""
+import argparse
+import json
+import re
+import statistics
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        runs = json.load(f)["benchmarks"]
+    times = {}
+    for r in runs:
+        if r.get("run_type") == "aggregate" or "error_occurred" in r:
+            continue
+        times.setdefault(r["run_name"], []).append(r["real_time"])
+    return {name: statistics.median(t) for name, t in times.items()}
+
+
+def report(pairs, threshold):
+    regressions = 0
+    width = max((len(n) for n, _, _ in pairs), default=0)
+    print(f"{'benchmark':<{width}}  {'base':>12}  {'contender':>12}  {'change':>8}")
+    for name, base, new in pairs:
+        change = new / base - 1.0
+        flag = ""
+        if change > threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        print(f"{name:<{width}}  {base:12.2f}  {new:12.2f}  {change:+8.1%}{flag}")
+    print(f"\n{len(pairs)} compared, {regressions} regressed by more than {threshold:.0%}")
+    return 1 if regressions else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    common = argparse.ArgumentParser(add_help=False)
+    common.add_argument("--threshold", type=float, default=0.05, help="allowed slowdown (0.05 = 5%%)")
+    sub = ap.add_subparsers(dest="mode", required=True)
+    b = sub.add_parser("builds", parents=[common])
+    b.add_argument("base")
+    b.add_argument("contender")
+    e = sub.add_parser("engines", parents=[common])
+    e.add_argument("run")
+    e.add_argument("--base", default="0", help="engine arg of the baseline (0 = reference)")
+    e.add_argument("--contender", default="1", help="engine arg compared against it (1 = tiled)")
+    args = ap.parse_args()
+
+    if args.mode == "builds":
+        base, new = load(args.base), load(args.contender)
+        pairs = [(n, base[n], new[n]) for n in base if n in new]
+    else:
+        times = load(args.run)
+        pairs = []
+        for name, t in times.items():
+            if f"/engine:{args.base}/" not in name:
+                continue
+            other = re.sub(r"/engine:\d+/", f"/engine:{args.contender}/", name)
+            if other in times:
+                pairs.append((name.replace(f"/engine:{args.base}/", "/"), t, times[other]))
+    if not pairs:
+        print("no matching benchmarks", file=sys.stderr)
+        return 2
+    return report(pairs, args.threshold)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
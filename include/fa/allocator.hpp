@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace fa::mem {
+
+// Cache-line alignment; also covers AVX-512 vector loads.
+constexpr std::size_t kAlignment = 64;
+
+// Pluggable storage allocator for Tensor (and other library buffers).
+// Implementations must be thread-safe.
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+    virtual void* allocate(std::size_t bytes, std::size_t alignment) = 0;
+    virtual void deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept = 0;
+};
+
+// Straight aligned operator new/delete, no caching.
+class AlignedAllocator final : public Allocator {
+public:
+    void* allocate(std::size_t bytes, std::size_t alignment) override;
+    void deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept override;
+};
+
+// Power-of-two size classes from 64 B to max_block bytes, each with its own
+// lock and intrusive free list. Freed blocks are kept for reuse until the
+// cache holds max_cached bytes; bigger requests go straight to the system.
+// Repeated calls with the same shapes therefore stop hitting malloc.
+class PoolAllocator final : public Allocator {
+public:
+    struct Stats {
+        std::size_t hits = 0;          // served from a free list
+        std::size_t misses = 0;        // went to the system allocator
+        std::size_t cached_bytes = 0;  // currently parked in free lists
+    };
+
+    explicit PoolAllocator(std::size_t max_block = std::size_t(1) << 26,
+                           std::size_t max_cached = std::size_t(1) << 28);
+    ~PoolAllocator() override;
+
+    void* allocate(std::size_t bytes, std::size_t alignment) override;
+    void deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept override;
+
+    Stats stats() const;
+    void release();   // return every cached block to the system
+
+private:
+    struct Impl;
+    Impl* impl_;
+};
+
+// Allocator used when a Tensor is created without an explicit one. Starts as
+// a process-wide PoolAllocator. The allocator must outlive every tensor made
+// with it; passing nullptr restores the built-in pool. Returns the previous.
+Allocator& default_allocator();
+Allocator* set_default_allocator(Allocator* a);
+
+// The process-wide pool installed by default (stats, release()).
+PoolAllocator& builtin_pool();
+
+// std::allocator adapter over an fa::mem::Allocator. construct() without
+// arguments default-initializes, so std::vector<float, ...>::resize leaves
+// storage uninitialized; callers that need zeros must ask for them.
+template <class T>
+struct StlAllocator {
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    Allocator* alloc;
+
+    StlAllocator() noexcept : alloc(&default_allocator()) {}
+    explicit StlAllocator(Allocator* a) noexcept : alloc(a ? a : &default_allocator()) {}
+    template <class U>
+    StlAllocator(const StlAllocator<U>& o) noexcept : alloc(o.alloc) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(alloc->allocate(n * sizeof(T), kAlignment));
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        alloc->deallocate(p, n * sizeof(T), kAlignment);
+    }
+
+    template <class U>
+    void construct(U* p) noexcept(noexcept(::new (static_cast<void*>(p)) U)) {
+        ::new (static_cast<void*>(p)) U;
+    }
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <class U>
+    bool operator==(const StlAllocator<U>& o) const noexcept { return alloc == o.alloc; }
+    template <class U>
+    bool operator!=(const StlAllocator<U>& o) const noexcept { return alloc != o.alloc; }
+};
+
+} // namespace fa::mem
@@ -1,14 +1,247 @@
 #pragma once
 #include "fa/types.hpp"
 #include "fa/tensor.hpp"
+#include "fa/kv_cache.hpp"
+#include "fa/kv_stream.hpp"
+#include "fa/mask.hpp"
+#include "fa/packed_kv.hpp"
+#include "fa/quantize.hpp"
+#include "fa/stats.hpp"
+#include "fa/tensor_view.hpp"
+#include "fa/workspace.hpp"
+#include <vector>
 
 namespace fa {
 
-// Forward declaration of the public API. Base commit throws NYI.
+// Scaled dot-product attention over (B,H,N,D) inputs. The kernel is selected
+// by opts.engine; every engine validates its inputs the same way. K and V may
+// have fewer heads than Q (grouped-query / multi-query attention): with H_kv
+// dividing H_q, query head h uses K/V head h / (H_q / H_kv). K/V are read in
+// place, and the tiled engine loads each K/V tile once per group.
+//
+// K/V may also be longer or shorter than Q (cross-attention, chunked
+// prefill): Q is (B,H,N_q,D), K/V are (B,H_kv,N_k,D) and padding masks have
+// one entry per key. Query i sits at key position i + N_k - N_q (bottom-right
+// alignment), so with opts.causal it sees keys j <= i + N_k - N_q and a query
+// chunk attending to its whole prefix gets the same rows as full prefill.
+// opts.window is measured from the same position.
+//
+// For training, pass lse to also get the (B,H,N) per-row log-sum-exp of the
+// scaled logits (-inf for rows with no visible key). It is all that
+// attention_backward needs besides the output, so the N x N probabilities
+// are never stored.
 Tensor attention_forward(const Tensor& Q,
                          const Tensor& K,
                          const Tensor& V,
                          const Tensor* mask,
+                         const AttentionOpts& opts,
+                         Tensor* lse = nullptr);
+
+// Same, reading Q/K/V/mask through strided views (no copy). Views only need a
+// (B,H,N,D) shape; e.g. a (B,N,H,D) buffer can be passed as
+// TensorView(ptr, {B,N,H,D}).transpose(1,2). The tiled engine reads rows in
+// place when the D stride is 1 and packs a contiguous copy otherwise.
+Tensor attention_forward(const ConstTensorView& Q,
+                         const ConstTensorView& K,
+                         const ConstTensorView& V,
+                         const ConstTensorView* mask,
+                         const AttentionOpts& opts,
+                         Tensor* lse = nullptr);
+
+// Same, with compact masks (fa/mask.hpp): a packed padding bitmask and/or a
+// block-sparse tile layout. The tiled engine tests masks per key tile and
+// never loads tiles that are fully masked; with a block-sparse layout its
+// tiles are the layout's blocks (opts.block_q/block_k are ignored). Float
+// masks passed to the other overloads are packed to bits once per call.
+Tensor attention_forward(const ConstTensorView& Q,
+                         const ConstTensorView& K,
+                         const ConstTensorView& V,
+                         const AttentionMask& mask,
+                         const AttentionOpts& opts,
+                         Tensor* lse = nullptr);
+
+// Allocation-free form for serving loops: the result is written into out (Q's
+// shape, D stride 1, any other strides) and tile scratch comes from ws, so
+// once ws is large enough (attention_workspace_size) a call does no heap
+// allocation. Q/K/V should have D stride 1 too, or a packed copy is made.
+// Always the tiled engine, whatever opts.engine says; out equals
+// attention_forward(..) with AttentionEngine::Tiled, bitwise.
+void attention_forward(const ConstTensorView& Q,
+                       const ConstTensorView& K,
+                       const ConstTensorView& V,
+                       const AttentionMask& mask,
+                       const AttentionOpts& opts,
+                       const TensorView& out,
+                       AttentionWorkspace& ws);
+
+// Workspace bytes the overload above needs for these shapes and options
+// (tile sizes and opts.num_threads included).
+size_t attention_workspace_size(const ConstTensorView& Q,
+                                const ConstTensorView& K,
+                                const AttentionMask& mask,
+                                const AttentionOpts& opts);
+
+// One independent problem for attention_forward_batch: its own shapes
+// (GQA allowed), compact mask and options. Views and masks must outlive the
+// call.
+struct AttentionProblem {
+    ConstTensorView Q, K, V;
+    AttentionMask mask;
+    AttentionOpts opts;
+};
+
+// Many independent attention_forward problems in one call, e.g. the
+// requests of one serving step. Problems are grouped into buckets of equal
+// (D, Br, Bc); each bucket gets one scratch set per worker, and the work
+// items of all problems go to the thread pool as a single loop, so short
+// problems do not leave workers idle between calls. Result k equals
+// attention_forward(problems[k]) with the tiled engine and opts.kv_splits = 1,
+// bitwise: batches are not split along the keys, so kv_splits 0 runs
+// unsplit and kv_splits > 1 throws std::invalid_argument.
+// opts.engine and opts.num_threads of the problems are ignored; num_threads
+// here sizes the pool (0 = hardware concurrency). If stats is set it gets
+// the totals of the whole batch (opts.stats of the problems is ignored).
+std::vector<Tensor> attention_forward_batch(const std::vector<AttentionProblem>& problems,
+                                            int num_threads = 1,
+                                            AttentionStats* stats = nullptr);
+
+// Gradients of attention_forward: dQ has Q's shape, dK/dV have K/V's (with
+// GQA/MQA each is summed over the query heads sharing the K/V head).
+struct AttentionGrads {
+    Tensor dQ, dK, dV;
+};
+
+// Backward pass for the fp32 forward: O and lse are what the forward call
+// returned, dO is the gradient of the loss w.r.t. O, and mask / opts must be
+// the forward's (causal, window, temperature, and dropout_prob with the same
+// dropout_seed, so the same entries are dropped). Probabilities are
+// recomputed tile by tile from lse; memory is O(B*H*N*D) for any N. Always
+// tiled, whatever opts.engine says: dK/dV are accumulated per (b, K/V head,
+// key block) and dQ per (b, head, query block), so no two work items write
+// the same row and results are bitwise identical for any opts.num_threads.
+AttentionGrads attention_backward(const Tensor& Q,
+                                  const Tensor& K,
+                                  const Tensor& V,
+                                  const Tensor& O,
+                                  const Tensor& dO,
+                                  const Tensor& lse,
+                                  const Tensor* mask,
+                                  const AttentionOpts& opts);
+AttentionGrads attention_backward(const ConstTensorView& Q,
+                                  const ConstTensorView& K,
+                                  const ConstTensorView& V,
+                                  const ConstTensorView& O,
+                                  const ConstTensorView& dO,
+                                  const ConstTensorView& lse,
+                                  const ConstTensorView* mask,
+                                  const AttentionOpts& opts);
+AttentionGrads attention_backward(const ConstTensorView& Q,
+                                  const ConstTensorView& K,
+                                  const ConstTensorView& V,
+                                  const ConstTensorView& O,
+                                  const ConstTensorView& dO,
+                                  const ConstTensorView& lse,
+                                  const AttentionMask& mask,
+                                  const AttentionOpts& opts);
+
+// Reduced-precision storage: Q/K/V hold bf16 or fp16 (all three the same
+// type), every dot product and softmax sum is accumulated in fp32 and the
+// result is fp32. The tiled engine widens each Q block and K/V tile into fp32
+// scratch once (F16C / AVX-512 conversions); the reference engine widens the
+// whole inputs first. The mask stays fp32.
+Tensor attention_forward(const TensorViewT<const bf16>& Q,
+                         const TensorViewT<const bf16>& K,
+                         const TensorViewT<const bf16>& V,
+                         const ConstTensorView* mask,
+                         const AttentionOpts& opts);
+Tensor attention_forward(const TensorViewT<const fp16>& Q,
+                         const TensorViewT<const fp16>& K,
+                         const TensorViewT<const fp16>& V,
+                         const ConstTensorView* mask,
                          const AttentionOpts& opts);
 
+// Same, rounding each normalized output row back to the storage type.
+TensorBF16 attention_forward_bf16(const TensorViewT<const bf16>& Q,
+                                  const TensorViewT<const bf16>& K,
+                                  const TensorViewT<const bf16>& V,
+                                  const ConstTensorView* mask,
+                                  const AttentionOpts& opts);
+TensorF16 attention_forward_f16(const TensorViewT<const fp16>& Q,
+                                const TensorViewT<const fp16>& K,
+                                const TensorViewT<const fp16>& V,
+                                const ConstTensorView* mask,
+                                const AttentionOpts& opts);
+
+// Int8 K/V (fa/quantize.hpp) with fp32 Q and output. Always tiled
+// (opts.engine is ignored): Q rows are quantized on the fly so QK^T runs as
+// int8 dot products (VNNI where available) and the K/V scales are applied to
+// the int32 logits and to the softmax weights. For unit-variance inputs with
+// 1/sqrt(D) temperature, expect ~2e-3 mean / ~3e-2 max absolute error versus
+// the fp32 engines.
+Tensor attention_forward_int8(const ConstTensorView& Q,
+                              const QuantizedTensor& K,
+                              const QuantizedTensor& V,
+                              const ConstTensorView* mask,
+                              const AttentionOpts& opts);
+
+// K (and V) prepared once with pack_kv (fa/packed_kv.hpp), for keys scored
+// by many calls: same shapes, masks, alignment and options as
+// attention_forward, to rounding. The first form needs K/V packed together;
+// the second reads V from a view (D stride 1 avoids a copy). Always tiled
+// (opts.engine is ignored); key tiles are rounded up to whole K panels, and a
+// block-sparse layout's block_k must be a multiple of simd::kPanelKeys.
+Tensor attention_forward_packed(const ConstTensorView& Q,
+                                const PackedKV& KV,
+                                const AttentionMask& mask,
+                                const AttentionOpts& opts,
+                                Tensor* lse = nullptr);
+Tensor attention_forward_packed(const ConstTensorView& Q,
+                                const PackedKV& K,
+                                const ConstTensorView& V,
+                                const AttentionMask& mask,
+                                const AttentionOpts& opts,
+                                Tensor* lse = nullptr);
+
+// Incremental decoding: Q is (B,H,T,D) for T new tokens (typically 1) and
+// attends over all cache.length(b) cached keys of its batch row, so a step
+// costs O(T * cached_len * D) per head. Always tiled, one cache page per key
+// tile. With opts.causal the new tokens must already be appended: query t
+// sees cached keys [0, length(b) - T + t]. Rows of an empty cache give zeros.
+// The cache may hold fewer heads than Q (GQA/MQA), as for attention_forward.
+Tensor attention_decode(const ConstTensorView& Q,
+                        const KVCache& cache,
+                        const AttentionOpts& opts);
+
+// Out-of-core attention for K/V larger than memory: source delivers key rows
+// in blocks of block_keys (0 = 4096, rounded up to whole key tiles) and the
+// result is attention_forward(Q, K, V, mask, opts, lse) to rounding, with the
+// same bottom-right alignment, masks and dropout. The next block is read on
+// a background thread while the current one is computed, and only two blocks
+// plus O(B*H*N_q*D) softmax state are held, however long the stream is.
+// Always tiled (opts.engine is ignored); bitwise identical for any
+// opts.num_threads. Exceptions thrown by the source propagate.
+Tensor attention_forward_stream(const ConstTensorView& Q,
+                                KVSource& source,
+                                const AttentionMask& mask,
+                                const AttentionOpts& opts,
+                                int block_keys = 0,
+                                Tensor* lse = nullptr);
+
+// Packed variable-length batch: Q/K/V are (total, H, D), the tokens of all
+// sequences concatenated, and sequence s is rows [cu_seqlens[s],
+// cu_seqlens[s+1]). cu_seqlens starts at 0, is non-decreasing and ends at
+// total. Each sequence attends only over its own keys (opts.causal applies
+// within the sequence), so padding is never computed; the result equals
+// attention_forward on each sequence alone. Dropout is the exception: keep
+// decisions are keyed by (dropout_seed, s, h, i, j) with i, j positions in
+// the sequence (sequence s draws the stream of batch entry s), so the result
+// equals the padded (S, H, N_max, D) batch with a padding mask rather than
+// sequence s run alone as batch entry 0. Output is (total, H, D). K/V may
+// be (total, H_kv, D) with H_kv dividing H. Always tiled; no padding mask.
+Tensor attention_forward_varlen(const ConstTensorView& Q,
+                                const ConstTensorView& K,
+                                const ConstTensorView& V,
+                                const std::vector<int>& cu_seqlens,
+                                const AttentionOpts& opts);
+
 } // namespace fa
@@ -0,0 +1,48 @@
+#pragma once
+#include "fa/types.hpp"
+#include <string>
+#include <vector>
+
+namespace fa::tune {
+
+struct TileConfig {
+    int block_q = 64;   // Br
+    int block_k = 64;   // Bc
+};
+
+struct AutotuneOpts {
+    std::vector<int> candidates_q = {16, 32, 64, 128};
+    std::vector<int> candidates_k = {16, 32, 64, 128, 256};
+    int repeats = 3;            // best-of timing per candidate
+    std::string cache_path;     // empty = default_cache_path()
+};
+
+// Times every (Br,Bc) candidate with the tiled engine on a (1,1,N,D) problem,
+// records the fastest in the process-wide table and rewrites the on-disk cache
+// so later processes start from the tuned value.
+TileConfig autotune_tiles(int N, int D, const AutotuneOpts& opts = {});
+
+// Tile sizes the tiled engine will use: explicit opts.block_q/block_k win,
+// then a cached tuned entry for (N,D), then default_tiles(). Zero fields are
+// resolved independently. The default cache file is loaded lazily once.
+TileConfig resolve_tiles(const AttentionOpts& opts, int N, int D);
+
+// Cross-attention / chunked prefill: N_q queries over N_k keys. Tuned and
+// default entries are looked up by (N_k, D), since the key loop dominates;
+// block_q is then clamped to N_q so a skinny query chunk is one block.
+TileConfig resolve_tiles(const AttentionOpts& opts, int Nq, int Nk, int D);
+
+TileConfig default_tiles(int N, int D);
+bool lookup_tiles(int N, int D, TileConfig* out);
+
+// $FA_TILE_CACHE if set, else $XDG_CACHE_HOME/fa_tiles.txt or
+// $HOME/.cache/fa_tiles.txt; empty if none of these is available.
+std::string default_cache_path();
+
+// Merge entries from a cache file into the process table (missing file is
+// not an error). save_tile_cache writes the whole table.
+void load_tile_cache(const std::string& path);
+void save_tile_cache(const std::string& path);
+void clear_tile_cache();
+
+} // namespace fa::tune
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace fa {
+
+// 16-bit storage types. Arithmetic always happens in float32: convert on load,
+// accumulate in fp32, convert on store. Scalar conversions round to nearest
+// even and preserve inf/NaN; bulk conversions use the SIMD kernels.
+
+inline float bf16_bits_to_f32(uint16_t b) {
+    const uint32_t u = uint32_t(b) << 16;
+    float f;
+    std::memcpy(&f, &u, sizeof f);
+    return f;
+}
+
+inline uint16_t f32_to_bf16_bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof u);
+    if ((u & 0x7FFFFFFFu) > 0x7F800000u) return uint16_t((u >> 16) | 0x40u);   // quiet NaN
+    u += 0x7FFFu + ((u >> 16) & 1u);
+    return uint16_t(u >> 16);
+}
+
+inline float f16_bits_to_f32(uint16_t h) {
+    const uint32_t sign = uint32_t(h & 0x8000u) << 16;
+    uint32_t exp = (h >> 10) & 0x1Fu;
+    uint32_t man = h & 0x3FFu;
+    uint32_t bits;
+    if (exp == 0) {
+        if (man == 0) {
+            bits = sign;
+        } else {                                  // subnormal: renormalize
+            exp = 127 - 15 + 1;
+            while (!(man & 0x400u)) { man <<= 1; --exp; }
+            bits = sign | (exp << 23) | ((man & 0x3FFu) << 13);
+        }
+    } else if (exp == 31) {
+        bits = sign | 0x7F800000u | (man << 13);
+    } else {
+        bits = sign | ((exp + 112) << 23) | (man << 13);
+    }
+    float f;
+    std::memcpy(&f, &bits, sizeof f);
+    return f;
+}
+
+inline uint16_t f32_to_f16_bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof u);
+    const uint16_t sign = uint16_t((u >> 16) & 0x8000u);
+    u &= 0x7FFFFFFFu;
+    if (u > 0x7F800000u) return uint16_t(sign | 0x7E00u);     // NaN
+    if (u >= 0x477FF000u) return uint16_t(sign | 0x7C00u);    // rounds past 65504
+    if (u < 0x38800000u) {                                    // half subnormal / zero
+        if (u < 0x33000000u) return sign;
+        const uint32_t e = u >> 23;
+        const uint32_t m = (u & 0x7FFFFFu) | 0x800000u;
+        const uint32_t shift = 126 - e;
+        uint32_t half = m >> shift;
+        const uint32_t rem = m & ((1u << shift) - 1u);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rem > halfway || (rem == halfway && (half & 1u))) ++half;
+        return uint16_t(sign | half);
+    }
+    uint32_t r = u - (112u << 23);
+    r += 0xFFFu + ((r >> 13) & 1u);
+    return uint16_t(sign | (r >> 13));
+}
+
+struct bf16 {
+    uint16_t bits = 0;
+    bf16() = default;
+    explicit bf16(float f) : bits(f32_to_bf16_bits(f)) {}
+    explicit operator float() const { return bf16_bits_to_f32(bits); }
+    static bf16 from_bits(uint16_t b) { bf16 v; v.bits = b; return v; }
+};
+
+struct fp16 {
+    uint16_t bits = 0;
+    fp16() = default;
+    explicit fp16(float f) : bits(f32_to_f16_bits(f)) {}
+    explicit operator float() const { return f16_bits_to_f32(bits); }
+    static fp16 from_bits(uint16_t b) { fp16 v; v.bits = b; return v; }
+};
+
+static_assert(sizeof(bf16) == 2 && sizeof(fp16) == 2, "16-bit storage types must be packed");
+
+enum class DType { F32, BF16, F16 };
+
+template <class T> struct dtype_of;
+template <> struct dtype_of<float> { static constexpr DType value = DType::F32; };
+template <> struct dtype_of<bf16>  { static constexpr DType value = DType::BF16; };
+template <> struct dtype_of<fp16>  { static constexpr DType value = DType::F16; };
+
+inline std::size_t dtype_size(DType t) { return t == DType::F32 ? 4 : 2; }
+
+// Bulk conversions (dispatch to F16C / AVX-512 / AVX512_BF16 where the CPU
+// has them; results match the scalar functions above for normal values).
+void convert(const bf16* src, float* dst, std::size_t n);
+void convert(const fp16* src, float* dst, std::size_t n);
+void convert(const float* src, bf16* dst, std::size_t n);
+void convert(const float* src, fp16* dst, std::size_t n);
+template <class T>
+inline void convert(const T* src, T* dst, std::size_t n) {
+    if (src != dst) std::memcpy(dst, src, n * sizeof(T));
+}
+
+} // namespace fa
@@ -0,0 +1,66 @@
+#pragma once
+#include "fa/allocator.hpp"
+#include "fa/tensor_view.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace fa {
+
+// Paged K/V store for incremental (autoregressive) decoding.
+//
+// Every batch row b holds a sequence of length(b) cached tokens for all H
+// heads. Tokens live in fixed-size pages of page_size rows; one page stores
+// the K rows and then the V rows of all heads, each head's rows contiguous
+// (H x page_size x D floats per tensor). Appending fills the last page and
+// takes new pages from a free list, so existing rows are never copied and a
+// step costs O(T * H * D) for T new tokens. reset()/clear() return pages to
+// the free list; the memory goes back to the allocator when the cache dies.
+//
+// Not thread-safe for concurrent appends; concurrent reads (decode calls) are
+// fine while nobody appends.
+class KVCache {
+public:
+    KVCache(int batch, int heads, int head_dim, int page_size = 64,
+            mem::Allocator* alloc = nullptr);
+    ~KVCache();
+    KVCache(const KVCache&) = delete;
+    KVCache& operator=(const KVCache&) = delete;
+
+    int batch() const { return batch_; }
+    int heads() const { return heads_; }
+    int head_dim() const { return dim_; }
+    int page_size() const { return page_size_; }
+    int length(int b) const { return lengths_.at(b); }
+    int max_length() const;
+
+    // Append T tokens to every batch row; K and V are (B,H,T,D) views.
+    void append(const ConstTensorView& K, const ConstTensorView& V);
+    // Append T tokens to batch row b only; K and V are (1,H,T,D) views.
+    void append(int b, const ConstTensorView& K, const ConstTensorView& V);
+
+    void reset(int b);   // forget row b's tokens
+    void clear();        // forget everything
+
+    // Page p of row b: K rows of head h start at k_page(b,p) + h*page_size*D,
+    // token p*page_size + r at row r. V likewise.
+    const float* k_page(int b, int p) const { return pages_.at(b).at(p); }
+    const float* v_page(int b, int p) const { return pages_.at(b).at(p) + page_floats(); }
+
+    std::size_t pages_in_use() const;
+    std::size_t bytes_reserved() const { return blocks_.size()*page_bytes(); }
+
+private:
+    int batch_, heads_, dim_, page_size_;
+    mem::Allocator* alloc_;
+    std::vector<int> lengths_;
+    std::vector<std::vector<float*>> pages_;   // per batch row
+    std::vector<float*> free_;
+    std::vector<float*> blocks_;               // every page ever allocated
+
+    std::size_t page_floats() const { return (std::size_t)heads_*page_size_*dim_; }
+    std::size_t page_bytes() const { return 2*page_floats()*sizeof(float); }
+    float* take_page();
+    void append_row(int b, const ConstTensorView& K, const ConstTensorView& V, int kb);
+};
+
+} // namespace fa
@@ -0,0 +1,83 @@
+#pragma once
+#include "fa/tensor_file.hpp"
+#include "fa/tensor_view.hpp"
+#include <functional>
+#include <string>
+
+namespace fa {
+
+// K/V delivered a block of key rows at a time, for attention_forward_stream
+// over contexts whose K/V do not fit in memory. A source describes a
+// (B, H_kv, N_kv, D) pair of K and V tensors and copies any range of key
+// rows on request; the engine asks for ascending, non-overlapping ranges,
+// one call at a time, from a prefetch thread (so read() must not touch
+// state the caller uses concurrently).
+class KVSource {
+public:
+    virtual ~KVSource() = default;
+
+    virtual int batch() const = 0;
+    virtual int heads() const = 0;      // H_kv
+    virtual int length() const = 0;     // N_kv, all keys of the stream
+    virtual int head_dim() const = 0;
+
+    // Key and value rows [j0, j0+n) of every (b, h) into k and v, each a
+    // contiguous (B, H_kv, n, D) buffer. Errors are reported by throwing.
+    virtual void read(int j0, int n, float* k, float* v) = 0;
+};
+
+// (B, H_kv, N_kv, D) views of any strides: tensors in memory or views into a
+// MappedTensorFile. The views must outlive the source.
+class ViewKVSource : public KVSource {
+public:
+    ViewKVSource(const ConstTensorView& K, const ConstTensorView& V);
+
+    int batch() const override { return K_.dim(0); }
+    int heads() const override { return K_.dim(1); }
+    int length() const override { return K_.dim(2); }
+    int head_dim() const override { return K_.dim(3); }
+    void read(int j0, int n, float* k, float* v) override;
+
+private:
+    ConstTensorView K_, V_;
+};
+
+// fp32 records of a tensor file (fa/tensor_file.hpp), mapped read-only. Rows
+// are paged in as blocks are read and, being clean file pages, can be
+// evicted again, so resident memory stays bounded by the OS, not by N_kv.
+class FileKVSource : public KVSource {
+public:
+    explicit FileKVSource(const std::string& path, const std::string& k_name = "K",
+                          const std::string& v_name = "V");
+
+    int batch() const override { return views_.batch(); }
+    int heads() const override { return views_.heads(); }
+    int length() const override { return views_.length(); }
+    int head_dim() const override { return views_.head_dim(); }
+    void read(int j0, int n, float* k, float* v) override { views_.read(j0, n, k, v); }
+
+private:
+    io::MappedTensorFile file_;
+    ViewKVSource views_;
+};
+
+// Shape plus a function that fills blocks (network, decompression, another
+// process); it is called with read()'s arguments.
+class CallbackKVSource : public KVSource {
+public:
+    using ReadFn = std::function<void(int j0, int n, float* k, float* v)>;
+
+    CallbackKVSource(int batch, int heads, int length, int head_dim, ReadFn fn);
+
+    int batch() const override { return batch_; }
+    int heads() const override { return heads_; }
+    int length() const override { return length_; }
+    int head_dim() const override { return dim_; }
+    void read(int j0, int n, float* k, float* v) override { fn_(j0, n, k, v); }
+
+private:
+    int batch_, heads_, length_, dim_;
+    ReadFn fn_;
+};
+
+} // namespace fa
@@ -1,25 +1,105 @@
 #pragma once
 #include "fa/tensor.hpp"
+#include "fa/tensor_view.hpp"
+#include <cstdint>
 #include <vector>
 
 namespace fa {
 
-// Mask is expected to be broadcastable boolean-like (0/1) of shape (B,1,1,N).
-// Base commit provides declarations only.
+// 1-bit packed padding mask over (B, N) keys: bit j of row b set means key j
+// is kept. Rows are whole 64-bit words, so a key tile is tested with a few
+// popcounts instead of one float load per key per query row.
+class PaddingBitmask {
+public:
+    PaddingBitmask() = default;
+    PaddingBitmask(int batch, int keys, bool keep = true);
+
+    // From a float (B,1,1,N) mask; nonzero keeps the key.
+    static PaddingBitmask from_tensor(const ConstTensorView& M);
+    // Row b keeps keys [0, lengths[b]).
+    static PaddingBitmask from_lengths(const std::vector<int>& lengths, int keys);
+
+    int batch() const { return batch_; }
+    int keys() const { return keys_; }
+    int words_per_row() const { return words_; }
+
+    bool keep(int b, int j) const { return (row(b)[j >> 6] >> (j & 63)) & 1u; }
+    void set(int b, int j, bool keep);
+    const uint64_t* row(int b) const { return bits_.data() + (size_t)b*words_; }
+
+    // Kept keys among [j0, j0+n) of row b.
+    int count(int b, int j0, int n) const;
+
+private:
+    int batch_ = 0, keys_ = 0, words_ = 0;
+    std::vector<uint64_t> bits_;
+};
+
+// Block-sparse layout over (query block, key block) tiles of
+// block_q x block_k, shared by every batch entry and head. Tiles that are
+// not active are never computed; inside active tiles every key is visible
+// (combine with causal / window / padding for finer masks). Stored as a
+// per-query-block sorted list of active key blocks.
+class BlockSparseMask {
+public:
+    BlockSparseMask() = default;
+    // layout is q_blocks x k_blocks, row-major; nonzero marks an active tile.
+    BlockSparseMask(int block_q, int block_k, int q_blocks, int k_blocks,
+                    const std::vector<uint8_t>& layout);
+
+    int block_q() const { return block_q_; }
+    int block_k() const { return block_k_; }
+    int q_blocks() const { return q_blocks_; }
+    int k_blocks() const { return k_blocks_; }
+
+    bool active(int qb, int kb) const;
+    // Active key blocks of query block qb, ascending: [begin, end).
+    const int* begin(int qb) const { return cols_.data() + offsets_[qb]; }
+    const int* end(int qb) const { return cols_.data() + offsets_[qb + 1]; }
+    // Fraction of tiles that are active.
+    double density() const;
+
+private:
+    int block_q_ = 0, block_k_ = 0, q_blocks_ = 0, k_blocks_ = 0;
+    std::vector<int> offsets_;   // q_blocks + 1
+    std::vector<int> cols_;
+};
+
+// Compact masks for attention_forward. Either pointer may be null; both
+// must outlive the call. Local-window attention is opts.window.
+struct AttentionMask {
+    const PaddingBitmask* padding = nullptr;   // (B, N) keys
+    const BlockSparseMask* blocks = nullptr;
+};
+
+// Mask one row of N logits: mask_row is a (B,1,1,N) float mask and
+// key_row_index picks its batch row b; logits whose mask entry is zero
+// become -inf. The bitmask form does the same from a packed row.
 void apply_logits_mask_inplace(float* row_logits, int N, const Tensor& mask_row, int key_row_index);
+void apply_logits_mask_inplace(float* row_logits, int N, const PaddingBitmask& mask, int key_row_index);
 
 } // namespace fa
 
 
 namespace fa::mask {
 
-// Validate mask is (B,1,1,N) matching Q/K/V (B,*,N,*)
-void validate_padding_mask_b11n(const Tensor& Q, const Tensor& M);
+// Validate mask is (B,1,1,N_kv) matching K/V (B,*,N_kv,*): one entry per
+// key, so with cross-attention (N_q != N_kv) pass K, not Q.
+void validate_padding_mask_b11n(const Tensor& K, const Tensor& M);
+void validate_padding_mask_b11n(const ConstTensorView& K, const ConstTensorView& M);
+// Shape-only form: B batch entries, N keys.
+void validate_padding_mask_b11n(int B, int N, const ConstTensorView& M);
+// Compact masks against B batch entries, Nq queries and Nk keys.
+void validate_attention_mask(int B, int Nq, int Nk, const AttentionMask& M);
 
 // Apply mask to logits in-place: M[b,0,0,j] == 0 -> logits[j] = -inf
 void apply_padding_mask_logits(std::vector<float>& logits,
                                const Tensor& M,
                                int b /*batch*/,
                                int N /*seq_len*/);
+void apply_padding_mask_logits(std::vector<float>& logits,
+                               const ConstTensorView& M,
+                               int b /*batch*/,
+                               int N /*seq_len*/);
 
 } // namespace fa::mask
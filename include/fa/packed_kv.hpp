@@ -0,0 +1,47 @@
+#pragma once
+#include "fa/allocator.hpp"
+#include "fa/simd.hpp"
+#include "fa/tensor_view.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace fa {
+
+// K (and optionally V) of a (B,H,N,D) pair repacked once for the tiled
+// engine, for keys that are scored many times (decode steps against a fixed
+// prefix, reranking many queries against one document):
+//
+//   K: per (b,h), ceil(N / simd::kPanelKeys) panels of D x kPanelKeys
+//      floats, panel row d holding element d of the panel's keys and the
+//      last panel zero-padded. QK^T then broadcasts q[d] against one panel
+//      row per FMA (simd::MicroKernels::qk_panels): keys are the vector
+//      lanes, K is read with unit stride and no horizontal sums are needed.
+//   V: per (b,h), N contiguous rows of D floats, so every key tile is one
+//      contiguous Bc x D block whatever V's original strides were.
+//
+// Packing costs one pass over K/V; attention_forward_packed reuses it.
+struct PackedKV {
+    std::vector<int> shape;                              // (B,H,N,D)
+    std::vector<float, mem::StlAllocator<float>> k;      // panels, (b,h)-major
+    std::vector<float, mem::StlAllocator<float>> v;      // rows, if has_v
+    bool has_v = false;
+
+    int dim(int i) const { return shape.at(i); }
+    int panels_per_head() const { return (shape.at(2) + simd::kPanelKeys - 1) / simd::kPanelKeys; }
+
+    // Panel p of (b,h): keys [p*kPanelKeys, p*kPanelKeys + kPanelKeys).
+    const float* k_panel(int b, int h, int p) const {
+        return k.data() + (((std::size_t)b*dim(1) + h)*panels_per_head() + p)*dim(3)*simd::kPanelKeys;
+    }
+    const float* v_row(int b, int h, int n) const {
+        return v.data() + (((std::size_t)b*dim(1) + h)*dim(2) + n)*dim(3);
+    }
+    std::size_t bytes() const { return (k.size() + v.size())*sizeof(float); }
+};
+
+// Packs K into panels and, if V is given, V into rows. Views of any strides.
+// Throws std::invalid_argument for non-4D input or K/V of different shapes.
+PackedKV pack_kv(const ConstTensorView& K, const ConstTensorView* V = nullptr);
+inline PackedKV pack_kv(const ConstTensorView& K, const ConstTensorView& V) { return pack_kv(K, &V); }
+
+} // namespace fa
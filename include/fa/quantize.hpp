@@ -0,0 +1,45 @@
+#pragma once
+#include "fa/allocator.hpp"
+#include "fa/tensor.hpp"
+#include "fa/tensor_view.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace fa {
+
+// Symmetric int8 copy of a (B,H,N,D) tensor, meant for K and V:
+//   x[b,h,n,d] ~= scale(b,h,n) * values[b,h,n,d],  values in [-127, 127].
+// The N rows of each (b,h) are grouped into blocks of block_rows tokens that
+// share one scale; block_rows == N gives one scale per head. Storage is one
+// byte per element plus one float per block (about 4x less than fp32).
+struct QuantizedTensor {
+    std::vector<int> shape;                                  // (B,H,N,D)
+    int block_rows = 0;
+    std::vector<int8_t, mem::StlAllocator<int8_t>> values;   // row-major (B,H,N,D)
+    std::vector<float> scales;                               // (B,H,blocks_per_head())
+
+    int dim(int i) const { return shape.at(i); }
+    int blocks_per_head() const { return (shape.at(2) + block_rows - 1) / block_rows; }
+
+    float scale(int b, int h, int n) const {
+        return scales[((size_t)b*dim(1) + h)*blocks_per_head() + n/block_rows];
+    }
+    const int8_t* row(int b, int h, int n) const {
+        return values.data() + (((size_t)b*dim(1) + h)*dim(2) + n)*dim(3);
+    }
+    std::size_t bytes() const { return values.size() + scales.size()*sizeof(float); }
+};
+
+// Absmax quantization per block: scale = max|x| / 127 over the block, values
+// rounded to nearest even. block_rows = 0 means one block per head. Throws
+// std::invalid_argument for non-4D input, negative block_rows or non-finite x.
+QuantizedTensor quantize_int8(const ConstTensorView& X, int block_rows = 0);
+inline QuantizedTensor quantize_int8(const Tensor& X, int block_rows = 0) {
+    return quantize_int8(X.view(), block_rows);
+}
+
+// fp32 reconstruction scale * values (tests, debugging).
+Tensor dequantize(const QuantizedTensor& X);
+
+} // namespace fa
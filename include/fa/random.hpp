@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace fa::rnd {
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+// 3"): a stateless map from a 128-bit counter and a 64-bit key to four
+// uniform 32-bit words. Any element of a stream can be produced directly
+// from its index, so parallel fills and in-kernel dropout give the same bits
+// for any thread count or tile order.
+inline std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> c, uint64_t key) {
+    uint32_t k0 = static_cast<uint32_t>(key), k1 = static_cast<uint32_t>(key >> 32);
+    for (int round = 0; round < 10; ++round) {
+        const uint64_t p0 = uint64_t(0xD2511F53u) * c[0];
+        const uint64_t p1 = uint64_t(0xCD9E8D57u) * c[2];
+        c = {uint32_t(p1 >> 32) ^ c[1] ^ k0, uint32_t(p1),
+             uint32_t(p0 >> 32) ^ c[3] ^ k1, uint32_t(p0)};
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return c;
+}
+
+// Uniform float in [0, 1) from the top 24 bits of x.
+inline float to_unit(uint32_t x) { return float(x >> 8) * (1.0f / 16777216.0f); }
+
+// Attention dropout decisions keyed by (seed, b, h, i, j): probability
+// (i, j) of head (b, h) is kept iff its Philox word is >= the threshold, so
+// the mask is never stored and every engine, tile size and thread count
+// drops the same entries. One Philox call covers four consecutive keys.
+class DropoutRng {
+public:
+    DropoutRng(uint64_t seed, float p)
+        : seed_(seed),
+          threshold_(p <= 0.0f ? 0 : uint32_t(std::min(double(p) * 4294967296.0, 4294967295.0))),
+          scale_(p < 1.0f ? 1.0f / (1.0f - p) : 0.0f) {}
+
+    float scale() const { return scale_; }
+
+    bool keep(int b, int h, int i, int j) const {
+        return draw(b, h, i, j >> 2)[j & 3] >= threshold_;
+    }
+
+    // s[c] holds the softmax weight of key j0 + c for query i; dropped
+    // weights become 0 and kept ones are scaled by 1 / (1 - p).
+    void apply(int b, int h, int i, int j0, int n, float* s) const {
+        int c = 0;
+        while (c < n) {
+            const int j = j0 + c;
+            const std::array<uint32_t, 4> r = draw(b, h, i, j >> 2);
+            const int end = std::min(n, c + 4 - (j & 3));
+            for (int lane = j & 3; c < end; ++c, ++lane)
+                s[c] = r[lane] >= threshold_ ? s[c]*scale_ : 0.0f;
+        }
+    }
+
+private:
+    std::array<uint32_t, 4> draw(int b, int h, int i, int jq) const {
+        return philox4x32({uint32_t(jq), uint32_t(i), uint32_t(h), uint32_t(b)}, seed_);
+    }
+
+    uint64_t seed_;
+    uint32_t threshold_;
+    float scale_;
+};
+
+// n standard normal floats; element k depends only on (seed, k), so the
+// result is the same for any num_threads (0 = hardware concurrency).
+// Box-Muller on Philox words: one counter yields four values.
+void fill_randn(float* data, long long n, uint64_t seed, int num_threads = 1);
+
+// n uniform floats in [0, 1), same counter scheme as fill_randn.
+void fill_uniform(float* data, long long n, uint64_t seed, int num_threads = 1);
+
+} // namespace fa::rnd
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace fa {
+struct bf16;
+struct fp16;
+} // namespace fa
+
+namespace fa::simd {
+
+// Keys per K panel (fa/packed_kv.hpp): one 512-bit register, two 256-bit ones.
+constexpr int kPanelKeys = 16;
+
+enum class Isa {
+    Scalar,
+    AVX2,     // AVX2 + FMA + F16C
+    AVX512,   // AVX-512 F/BW/DQ/VL (+ AVX512_BF16 / VNNI kernels when present)
+};
+
+// Inner-loop micro-kernels used by the tiled engines. Row pointers are
+// unaligned-safe; ld* are row strides in elements.
+struct MicroKernels {
+    Isa isa;
+    const char* name;
+
+    // out[c] = dot(q, k + c*ldk) over D elements, for c in [0, nk).
+    void (*qk)(const float* q, const float* k, std::ptrdiff_t ldk, int nk, int D, float* out);
+    // acc[0:D] += sum_c p[c] * v[c*ldv + 0:D], for c in [0, nk).
+    void (*pv)(const float* p, const float* v, std::ptrdiff_t ldv, int nk, int D, float* acc);
+    float (*dot)(const float* x, const float* y, int n);
+    void (*axpy)(float a, const float* x, float* y, int n);   // y += a*x
+    void (*scale)(float a, float* x, int n);                  // x *= a
+
+    // Softmax primitives; every exp here has fa::math::fast_exp accuracy.
+    void (*exp)(const float* x, float* y, int n);             // y = exp(x)
+    float (*max)(const float* x, int n);                      // -inf if n == 0
+    // x[i] = exp(x[i] - m) in place and returns their sum. m must be finite.
+    float (*exp_sum)(float* x, int n, float m);
+    // One read of x: *m = max(x), *s = sum(exp(x - *m)); *s = 0 if all -inf.
+    void (*max_sumexp)(const float* x, int n, float* m, float* s);
+    // w[i] = exp(x[i] - m) * scale. m must be finite.
+    void (*exp_scale)(const float* x, int n, float m, float scale, float* w);
+
+    // 16-bit storage conversions (fa/dtype.hpp). Narrowing rounds to nearest
+    // even; the native AVX512_BF16 store also flushes fp32 subnormals to zero.
+    void (*bf16_to_f32)(const bf16* x, float* y, int n);
+    void (*f32_to_bf16)(const float* x, bf16* y, int n);
+    void (*f16_to_f32)(const fp16* x, float* y, int n);
+    void (*f32_to_f16)(const float* x, fp16* y, int n);
+
+    // int8 K/V (fa/quantize.hpp); every int8 value must lie in [-127, 127].
+    // out[c] = exact int32 dot(q, k + c*ldk) over D elements, c in [0, nk).
+    void (*qk_i8)(const int8_t* q, const int8_t* k, std::ptrdiff_t ldk, int nk, int D, int32_t* out);
+    // acc[0:D] += sum_c p[c] * float(v[c*ldv + 0:D]), for c in [0, nk).
+    void (*pv_i8)(const float* p, const int8_t* v, std::ptrdiff_t ldv, int nk, int D, float* acc);
+
+    // Packed K: kt holds ceil(nk / kPanelKeys) panels of D x kPanelKeys
+    // floats, panel row d holding element d of the panel's keys (zero-padded
+    // past nk). out[c] = dot(q, key c) for c in [0, nk); the keys of a panel
+    // are the vector lanes, so no horizontal sums are needed.
+    void (*qk_panels)(const float* q, const float* kt, int nk, int D, float* out);
+};
+
+// Best ISA this CPU supports (CPUID), limited to what the build compiled in.
+Isa detected_isa();
+bool isa_supported(Isa isa);
+const char* isa_name(Isa isa);
+
+// Active kernel table. Resolved once at load time from detected_isa(); the
+// FA_ISA environment variable (scalar|avx2|avx512) can lower the choice.
+const MicroKernels& kernels();
+
+// Kernel table for a specific ISA. Throws std::invalid_argument if the ISA is
+// not compiled in or not supported by this CPU.
+const MicroKernels& kernels_for(Isa isa);
+
+// Switch the active table (tests, benchmarks). Not meant to race with running
+// attention calls. Returns the previously active ISA.
+Isa select_isa(Isa isa);
+
+} // namespace fa::simd
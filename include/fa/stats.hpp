@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace fa {
+
+// One work item (a query block of a group of heads) as run by one worker.
+// Times are steady_clock nanoseconds.
+struct TraceEvent {
+    int worker = 0;
+    int b = 0, h = 0;      // batch entry, first query head
+    int row = 0;           // first query row
+    int64_t start_ns = 0, dur_ns = 0;
+};
+
+// Hot-path counters for attention calls, filled when opts.stats points here
+// and the library was built with FA_ENABLE_STATS (stats_compiled_in()).
+// Calls add to the fields, so one object can cover many calls; reset()
+// clears it. Phase times are summed over workers, so with several threads
+// they exceed the wall time. Bytes count compulsory traffic: every Q row
+// and every visited K/V tile read once, every output row written once.
+struct AttentionStats {
+    int64_t calls = 0;
+    int64_t qk_ns = 0;         // logits: Q K^T and temperature
+    int64_t mask_ns = 0;       // causal / window / padding masking of logits
+    int64_t softmax_ns = 0;    // online max / exp / rescale (and dropout)
+    int64_t pv_ns = 0;         // probabilities times V
+    int64_t tiles_visited = 0;
+    int64_t tiles_skipped = 0;       // key tiles never loaded (masks, causal, sparsity)
+    int64_t rows_fully_masked = 0;   // output rows with no visible key
+    int64_t bytes_read = 0;
+    int64_t bytes_written = 0;
+
+    // Also record one TraceEvent per work item (tiled engines).
+    bool record_trace = false;
+    std::vector<TraceEvent> trace;
+
+    void reset() {
+        const bool rt = record_trace;
+        *this = AttentionStats{};
+        record_trace = rt;
+    }
+};
+
+// Whether the instrumentation was compiled in; without it opts.stats is
+// ignored and the engines carry no timing code at all.
+bool stats_compiled_in();
+
+// Chrome trace-event JSON ("X" events, one row per worker) of stats.trace,
+// loadable in chrome://tracing or Perfetto. The totals go in as metadata.
+std::string chrome_trace_json(const AttentionStats& stats);
+void write_chrome_trace(const AttentionStats& stats, const std::string& path);
+
+} // namespace fa
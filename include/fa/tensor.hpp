@@ -4,34 +4,66 @@
 #include <string>
 #include <initializer_list>
 #include <cstddef>
-#include <random>
+#include <type_traits>
 #include <algorithm>
 #include <numeric>
+#include "fa/allocator.hpp"
+#include "fa/dtype.hpp"
+#include "fa/random.hpp"
+#include "fa/tensor_view.hpp"
 
 namespace fa {
 
-// Simple owning float32 tensor. Contiguous storage, row-major.
-class Tensor {
+// Tag for constructing a Tensor whose contents are about to be overwritten.
+struct Uninitialized {};
+inline constexpr Uninitialized uninitialized{};
+
+// Simple owning tensor. Contiguous storage, row-major. T is the element
+// type: float (Tensor), or the 16-bit storage types bf16 / fp16.
+// Storage is 64-byte aligned and comes from an fa::mem::Allocator (the
+// process-wide pool unless one is passed), so same-shape temporaries reuse
+// freed blocks instead of going back to malloc.
+template <class T>
+class TensorT {
 public:
-    Tensor() = default;
-    explicit Tensor(const std::vector<int>& shape)
-        : shape_(shape) {
+    using value_type = T;
+
+    TensorT() = default;
+    explicit TensorT(const std::vector<int>& shape, mem::Allocator* alloc = nullptr)
+        : shape_(shape), data_(mem::StlAllocator<T>(alloc)) {
         validate_shape();
-        data_.assign(static_cast<size_t>(numel()), 0.0f);
+        data_.assign(static_cast<size_t>(numel()), T{});
         compute_strides();
     }
 
-    static Tensor zeros(const std::vector<int>& shape) {
-        Tensor t(shape);
-        std::fill(t.data_.begin(), t.data_.end(), 0.0f);
-        return t;
+    // Storage left uninitialized (no zero fill).
+    TensorT(const std::vector<int>& shape, Uninitialized, mem::Allocator* alloc = nullptr)
+        : shape_(shape), data_(mem::StlAllocator<T>(alloc)) {
+        validate_shape();
+        data_.resize(static_cast<size_t>(numel()));
+        compute_strides();
     }
 
-    static Tensor randn(const std::vector<int>& shape, uint64_t seed) {
-        Tensor t(shape);
-        std::mt19937 rng(static_cast<uint32_t>(seed));
-        std::normal_distribution<float> dist(0.0f, 1.0f);
-        for (auto& x : t.data_) x = dist(rng);
+    static TensorT zeros(const std::vector<int>& shape) {
+        return TensorT(shape);
+    }
+
+    static TensorT empty(const std::vector<int>& shape) {
+        return TensorT(shape, uninitialized);
+    }
+
+    // Same float draws for every T (rounded on store), so a bf16 randn tensor
+    // is the rounded fp32 randn tensor with the same seed. Counter-based
+    // (fa::rnd::fill_randn), so the values do not depend on num_threads.
+    static TensorT randn(const std::vector<int>& shape, uint64_t seed, int num_threads = 1) {
+        TensorT t(shape, uninitialized);
+        if constexpr (std::is_same_v<T, float>) {
+            rnd::fill_randn(t.data(), t.numel(), seed, num_threads);
+        } else {
+            std::vector<float> tmp(t.data_.size());
+            rnd::fill_randn(tmp.data(), (long long)tmp.size(), seed, num_threads);
+            for (size_t k = 0; k < tmp.size(); ++k) t.data_[k] = T(tmp[k]);
+        }
         return t;
     }
 
@@ -46,21 +78,21 @@ public:
         return n;
     }
 
-    float* data() { return data_.data(); }
-    const float* data() const { return data_.data(); }
+    T* data() { return data_.data(); }
+    const T* data() const { return data_.data(); }
 
     // Flattened index access with bounds check.
-    float& at_index(long long idx) {
+    T& at_index(long long idx) {
         if (idx < 0 || idx >= numel()) throw std::out_of_range("Tensor index out of range");
         return data_[static_cast<size_t>(idx)];
     }
-    const float& at_index(long long idx) const {
+    const T& at_index(long long idx) const {
         if (idx < 0 || idx >= numel()) throw std::out_of_range("Tensor index out of range");
         return data_[static_cast<size_t>(idx)];
     }
 
     // 4D convenience accessor (B,H,N,D). Throws if ndim != 4.
-    float& at(int b, int h, int n, int d) {
+    T& at(int b, int h, int n, int d) {
         require_ndim(4);
         long long idx = ((long long)b * strides_[0]) +
                         ((long long)h * strides_[1]) +
@@ -68,7 +100,7 @@ public:
                         ((long long)d * strides_[3]);
         return at_index(idx);
     }
-    const float& at(int b, int h, int n, int d) const {
+    const T& at(int b, int h, int n, int d) const {
         require_ndim(4);
         long long idx = ((long long)b * strides_[0]) +
                         ((long long)h * strides_[1]) +
@@ -77,6 +109,27 @@ public:
         return at_index(idx);
     }
 
+    // Non-owning views of this tensor's storage (valid while it is alive).
+    TensorViewT<T> view() { return TensorViewT<T>(data(), shape_); }
+    TensorViewT<const T> view() const { return TensorViewT<const T>(data(), shape_); }
+
+    // Contiguous copy of an arbitrary strided view.
+    static TensorT from(const TensorViewT<const T>& v) {
+        TensorT t(v.shape(), uninitialized);
+        const int nd = v.ndim();
+        std::vector<int> idx(nd, 0);
+        for (long long i = 0; i < t.numel(); ++i) {
+            long long off = 0;
+            for (int k = 0; k < nd; ++k) off += idx[k] * v.stride(k);
+            t.data_[static_cast<size_t>(i)] = v.data()[off];
+            for (int k = nd - 1; k >= 0; --k) {
+                if (++idx[k] < v.dim(k)) break;
+                idx[k] = 0;
+            }
+        }
+        return t;
+    }
+
     bool contiguous() const {
         std::vector<int> st(shape_.size());
         int nd = ndim();
@@ -91,7 +144,7 @@ public:
 private:
     std::vector<int> shape_;
     std::vector<int> strides_;
-    std::vector<float> data_;
+    std::vector<T, mem::StlAllocator<T>> data_;
 
     void validate_shape() const {
         if (shape_.empty()) throw std::invalid_argument("Tensor shape cannot be empty");
@@ -115,4 +168,25 @@ private:
     }
 };
 
+using Tensor = TensorT<float>;
+using TensorBF16 = TensorT<bf16>;
+using TensorF16 = TensorT<fp16>;
+
+// Contiguous copy of v converted to element type To (round to nearest even
+// when narrowing). Contiguous sources go through the bulk SIMD conversions.
+template <class To, class From>
+TensorT<To> cast(const TensorViewT<const From>& v) {
+    if (v.contiguous()) {
+        TensorT<To> t(v.shape(), uninitialized);
+        convert(v.data(), t.data(), static_cast<std::size_t>(t.numel()));
+        return t;
+    }
+    return cast<To, From>(TensorT<From>::from(v).view());
+}
+
+template <class To, class From>
+TensorT<To> cast(const TensorT<From>& t) {
+    return cast<To, From>(t.view());
+}
+
 } // namespace fa
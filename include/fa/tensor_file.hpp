@@ -0,0 +1,151 @@
+#pragma once
+#include "fa/allocator.hpp"
+#include "fa/dtype.hpp"
+#include "fa/tensor.hpp"
+#include "fa/tensor_view.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace fa::io {
+
+// Binary tensor file, version 1 (little-endian). A 64-byte file header:
+//
+//   char magic[8] "FATENSR"   u32 version   u32 alignment   u32 0x01020304
+//
+// then one record per tensor, each starting on an `alignment` boundary:
+//
+//   char tag[4] "TNSR"  u32 dtype  u32 ndim  u32 name_len
+//   u64 payload_offset  u64 payload_bytes      (offset from file start)
+//   i64 shape[ndim]     i64 strides[ndim]      (strides in elements)
+//   name bytes, zero padding up to the aligned payload, the payload, and
+//   zero padding up to the next record.
+//
+// Payloads are aligned, so a mapped file is read in place: K/V caches and
+// benchmark inputs load without a copy. Records are self-describing, so a
+// writer can stream tensors one after another without an index.
+enum class DType : uint32_t { F32 = 1, BF16 = 2, F16 = 3, I8 = 4 };
+
+std::size_t dtype_size(DType t);
+
+template <class T> struct DTypeOf;
+template <> struct DTypeOf<float>  { static constexpr DType value = DType::F32; };
+template <> struct DTypeOf<bf16>   { static constexpr DType value = DType::BF16; };
+template <> struct DTypeOf<fp16>   { static constexpr DType value = DType::F16; };
+template <> struct DTypeOf<int8_t> { static constexpr DType value = DType::I8; };
+
+constexpr uint32_t kTensorFileVersion = 1;
+
+// One tensor of a file: where its payload sits and how to index it.
+struct TensorRecord {
+    std::string name;
+    DType dtype;
+    std::vector<int> shape;
+    std::vector<long long> strides;
+    std::size_t offset = 0;   // payload, from file start
+    std::size_t bytes = 0;
+};
+
+// Streams records to a file: begin() writes the header of one row-major
+// tensor, append() its payload in any number of pieces (so tensors larger
+// than memory never need a full buffer), end() pads to the next record.
+// write() does all three for a view of any strides. Throws
+// std::runtime_error on I/O errors, std::invalid_argument on misuse.
+class TensorFileWriter {
+public:
+    explicit TensorFileWriter(const std::string& path, std::size_t alignment = mem::kAlignment);
+    ~TensorFileWriter();   // closes; call close() to see errors
+    TensorFileWriter(const TensorFileWriter&) = delete;
+    TensorFileWriter& operator=(const TensorFileWriter&) = delete;
+
+    void begin(const std::string& name, DType dtype, const std::vector<int>& shape);
+    void append(const void* data, std::size_t bytes);
+    void end();
+
+    template <class T>
+    void write(const std::string& name, const TensorViewT<const T>& v);
+    template <class T>
+    void write(const std::string& name, const TensorT<T>& t) { write(name, t.view()); }
+    template <class T>
+    void write(const std::string& name, const TensorViewT<T>& v) { write(name, TensorViewT<const T>(v)); }
+
+    void close();
+
+private:
+    void pad_to_alignment();
+
+    std::string path_;
+    std::ofstream out_;
+    std::size_t align_;
+    std::size_t pos_ = 0;
+    std::size_t pending_ = 0;   // payload bytes still owed by the open record
+    bool open_record_ = false;
+};
+
+// Read-only memory map of a tensor file. view() returns a view straight into
+// the mapping (no copy); views stay valid while the MappedTensorFile lives.
+// Throws std::runtime_error for unreadable or malformed files and
+// std::invalid_argument for a missing name or wrong element type.
+class MappedTensorFile {
+public:
+    explicit MappedTensorFile(const std::string& path);
+    ~MappedTensorFile();
+    MappedTensorFile(MappedTensorFile&&) noexcept;
+    MappedTensorFile& operator=(MappedTensorFile&&) noexcept;
+    MappedTensorFile(const MappedTensorFile&) = delete;
+    MappedTensorFile& operator=(const MappedTensorFile&) = delete;
+
+    uint32_t version() const;
+    std::size_t alignment() const;
+    const std::vector<TensorRecord>& records() const;
+    const TensorRecord& record(const std::string& name) const;
+    bool contains(const std::string& name) const;
+
+    template <class T>
+    TensorViewT<const T> view(const std::string& name) const {
+        const TensorRecord& r = record(name);
+        if (r.dtype != DTypeOf<T>::value)
+            throw std::invalid_argument("MappedTensorFile: tensor '" + name + "' has another dtype");
+        return TensorViewT<const T>(reinterpret_cast<const T*>(base() + r.offset), r.shape, r.strides);
+    }
+
+private:
+    const char* base() const;
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+template <class T>
+void TensorFileWriter::write(const std::string& name, const TensorViewT<const T>& v) {
+    begin(name, DTypeOf<T>::value, v.shape());
+    if (v.contiguous()) {
+        append(v.data(), sizeof(T)*(std::size_t)v.numel());
+        end();
+        return;
+    }
+    // Row by row over every index but the last; strided rows are gathered.
+    const int nd = v.ndim();
+    const int inner = v.dim(nd - 1);
+    std::vector<T> row(inner);
+    std::vector<int> idx(nd, 0);
+    for (long long done = 0; done < v.numel(); done += inner) {
+        long long off = 0;
+        for (int k = 0; k < nd - 1; ++k) off += idx[k]*v.stride(k);
+        const T* p = v.data() + off;
+        if (v.stride(nd - 1) == 1) {
+            append(p, sizeof(T)*inner);
+        } else {
+            for (int c = 0; c < inner; ++c) row[c] = p[c*v.stride(nd - 1)];
+            append(row.data(), sizeof(T)*inner);
+        }
+        for (int k = nd - 2; k >= 0 && ++idx[k] == v.dim(k); --k) idx[k] = 0;
+    }
+    end();
+}
+
+} // namespace fa::io
@@ -0,0 +1,143 @@
+#pragma once
+#include <vector>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <cstddef>
+#include <utility>
+
+namespace fa {
+
+// Non-owning strided view over external memory. Strides and offset are in
+// elements; element (i0,i1,...) lives at base()[offset + sum(ik*stride[k])].
+// Slicing, transposing and permuting only rewrite shape/strides/offset, so
+// e.g. a (B,N,H,D) buffer can be passed as (B,H,N,D) without a copy.
+// T is the element type; TensorViewT<const float> is the read-only form.
+template <class T>
+class TensorViewT {
+public:
+    using value_type = T;
+
+    TensorViewT() = default;
+
+    TensorViewT(T* data, std::vector<int> shape, std::vector<long long> strides,
+                long long offset = 0)
+        : data_(data), shape_(std::move(shape)), strides_(std::move(strides)), offset_(offset) {
+        validate();
+    }
+
+    // Row-major contiguous view.
+    TensorViewT(T* data, std::vector<int> shape)
+        : data_(data), shape_(std::move(shape)) {
+        strides_.assign(shape_.size(), 0);
+        long long stride = 1;
+        for (int i = ndim() - 1; i >= 0; --i) {
+            strides_[i] = stride;
+            stride *= shape_[i];
+        }
+        validate();
+    }
+
+    // Mutable -> read-only conversion.
+    template <class U, class = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+    TensorViewT(const TensorViewT<U>& o)
+        : data_(o.base()), shape_(o.shape()), strides_(o.strides()), offset_(o.offset()) {}
+
+    int ndim() const { return static_cast<int>(shape_.size()); }
+    int dim(int i) const { return shape_.at(i); }
+    long long stride(int i) const { return strides_.at(i); }
+    const std::vector<int>& shape() const { return shape_; }
+    const std::vector<long long>& strides() const { return strides_; }
+    long long offset() const { return offset_; }
+    bool empty() const { return data_ == nullptr; }
+
+    long long numel() const {
+        long long n = 1;
+        for (int s : shape_) n *= s;
+        return n;
+    }
+
+    T* base() const { return data_; }            // unshifted pointer
+    T* data() const { return data_ + offset_; }  // element (0,...,0)
+
+    bool contiguous() const {
+        long long stride = 1;
+        for (int i = ndim() - 1; i >= 0; --i) {
+            if (shape_[i] != 1 && strides_[i] != stride) return false;
+            stride *= shape_[i];
+        }
+        return true;
+    }
+
+    // 4D convenience accessor (B,H,N,D) with per-dimension bounds checks.
+    T& at(int b, int h, int n, int d) const {
+        if (ndim() != 4) throw std::invalid_argument("TensorView requires ndim=4");
+        const int idx[4] = {b, h, n, d};
+        long long off = offset_;
+        for (int k = 0; k < 4; ++k) {
+            if (idx[k] < 0 || idx[k] >= shape_[k]) throw std::out_of_range("TensorView index out of range");
+            off += idx[k] * strides_[k];
+        }
+        return data_[off];
+    }
+
+    // [start, start+length) along one dimension.
+    TensorViewT slice(int axis, int start, int length) const {
+        check_axis(axis);
+        if (start < 0 || length <= 0 || start + length > shape_[axis])
+            throw std::out_of_range("TensorView slice out of range");
+        TensorViewT v = *this;
+        v.offset_ += start * strides_[axis];
+        v.shape_[axis] = length;
+        return v;
+    }
+
+    TensorViewT transpose(int a, int b) const {
+        check_axis(a);
+        check_axis(b);
+        TensorViewT v = *this;
+        std::swap(v.shape_[a], v.shape_[b]);
+        std::swap(v.strides_[a], v.strides_[b]);
+        return v;
+    }
+
+    // Result dimension k is this view's dimension order[k].
+    TensorViewT permute(const std::vector<int>& order) const {
+        if ((int)order.size() != ndim()) throw std::invalid_argument("TensorView permute: rank mismatch");
+        std::vector<bool> seen(ndim(), false);
+        TensorViewT v = *this;
+        for (int k = 0; k < ndim(); ++k) {
+            check_axis(order[k]);
+            if (seen[order[k]]) throw std::invalid_argument("TensorView permute: repeated axis");
+            seen[order[k]] = true;
+            v.shape_[k] = shape_[order[k]];
+            v.strides_[k] = strides_[order[k]];
+        }
+        return v;
+    }
+
+private:
+    T* data_ = nullptr;
+    std::vector<int> shape_;
+    std::vector<long long> strides_;
+    long long offset_ = 0;
+
+    void validate() const {
+        if (!data_) throw std::invalid_argument("TensorView data cannot be null");
+        if (shape_.empty()) throw std::invalid_argument("TensorView shape cannot be empty");
+        if (strides_.size() != shape_.size())
+            throw std::invalid_argument("TensorView strides must match shape rank");
+        for (int s : shape_) {
+            if (s <= 0) throw std::invalid_argument("TensorView dims must be positive");
+        }
+    }
+
+    void check_axis(int a) const {
+        if (a < 0 || a >= ndim()) throw std::out_of_range("TensorView axis " + std::to_string(a) + " out of range");
+    }
+};
+
+using TensorView = TensorViewT<float>;
+using ConstTensorView = TensorViewT<const float>;
+
+} // namespace fa
@@ -1,12 +1,51 @@
 // include/fa/types.hpp
 #pragma once
+#include <cstdint>
 
 namespace fa {
 
+struct AttentionStats;   // fa/stats.hpp
+
+// Which forward kernel attention_forward dispatches to.
+enum class AttentionEngine {
+    Reference,  // per-row logits + two-pass softmax (src/attention_ref.cpp)
+    Tiled,      // K/V blocks with online softmax (src/attention_tiled.cpp)
+};
+
 struct AttentionOpts {
     bool  causal      = false;
     float temperature = 1.0f; 
 	float dropout_prob  = 0.0f;
+    // Dropout on the attention probabilities, applied inside the kernels.
+    // Whether (b, h, i, j) is dropped is a pure function of this seed and
+    // the indices (fa/random.hpp), so results do not depend on the engine,
+    // tile sizes or num_threads. Kept weights are scaled by 1/(1-p).
+    uint64_t dropout_seed = 0;
+    AttentionEngine engine = AttentionEngine::Reference;
+    // Local attention: when > 0, query i only sees keys j with |i - j| <
+    // window (with causal, i - window < j <= i). Engines skip key tiles
+    // outside the band, so cost is O(N * window) rather than O(N^2).
+    int   window      = 0;
+    // Tile sizes for the tiled engine (Br query rows x Bc keys). 0 means
+    // "use the autotuned value for this (N,D) if cached, else a default";
+    // see fa/autotune.hpp.
+    int   block_q     = 0;
+    int   block_k     = 0;
+    // Worker threads for the tiled engine, counting the caller. 1 runs
+    // serially; 0 uses std::thread::hardware_concurrency(). Output does not
+    // depend on this value for a fixed tile size.
+    int   num_threads = 1;
+    // Split-K (flash-decoding) for the tiled and decode engines: the key
+    // axis is cut into this many chunks that run as separate work items and
+    // are merged with a log-sum-exp combine. 0 chooses automatically (split
+    // when B*H*ceil(N_q/Br) is below the machine's core count and the keys
+    // span enough tiles), 1 never splits. The automatic choice does not look
+    // at num_threads, so output still does not depend on it.
+    int   kv_splits   = 0;
+    // Instrumentation (fa/stats.hpp): when set, the call adds its per-phase
+    // times, tile/row counters and traffic here. Ignored unless the library
+    // is built with FA_ENABLE_STATS.
+    AttentionStats* stats = nullptr;
 };
 
 } // namespace fa
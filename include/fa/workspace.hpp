@@ -0,0 +1,43 @@
+#pragma once
+#include "fa/allocator.hpp"
+#include <cstddef>
+#include <memory>
+
+namespace fa {
+
+class AttentionWorkspace;
+
+namespace detail {
+class TileScratchSet;
+TileScratchSet& workspace_scratch(AttentionWorkspace& ws, int workers, int rows, int bc, int d,
+                                  std::size_t extra = 0, char** extra_out = nullptr);
+} // namespace detail
+
+// Scratch memory for the allocation-free attention_forward overload: one
+// 64-byte aligned arena, carved per call into the tile buffers of every
+// worker. Size it with attention_workspace_size() (fa/attention.hpp); a call
+// that needs more grows it once, and it never shrinks, so steady-state calls
+// of a fixed set of shapes do no heap allocation. One workspace serves one
+// call at a time.
+class AttentionWorkspace {
+public:
+    AttentionWorkspace();
+    explicit AttentionWorkspace(std::size_t bytes, mem::Allocator* alloc = nullptr);
+    ~AttentionWorkspace();
+    AttentionWorkspace(AttentionWorkspace&&) noexcept;
+    AttentionWorkspace& operator=(AttentionWorkspace&&) noexcept;
+    AttentionWorkspace(const AttentionWorkspace&) = delete;
+    AttentionWorkspace& operator=(const AttentionWorkspace&) = delete;
+
+    // Grow the arena to at least bytes (contents are not kept).
+    void reserve(std::size_t bytes);
+    std::size_t capacity() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+    friend detail::TileScratchSet& detail::workspace_scratch(AttentionWorkspace&, int, int, int, int,
+                                                             std::size_t, char**);
+};
+
+} // namespace fa
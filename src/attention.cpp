@@ -0,0 +1,400 @@
+#include "attention_impl.hpp"
+#include "fa/mask.hpp"
+#include <stdexcept>
+#include <string>
+#include <cmath>
+#include <type_traits>
+
+namespace fa {
+
+namespace detail {
+
+static void validate_core(const std::vector<int>& Q, const std::vector<int>& K, const std::vector<int>& V) {
+  if (Q.size()!=4 || K.size()!=4 || V.size()!=4)
+    throw std::invalid_argument("attention_forward: Q,K,V must be 4D (B,H,N,D)");
+  if (Q[0]!=K[0] || Q[0]!=V[0]) throw std::invalid_argument("B mismatch");
+  // GQA/MQA: K/V may have fewer heads, each shared by H_q / H_kv query heads
+  if (K[1]!=V[1] || K[1]<=0 || Q[1]%K[1]!=0)
+    throw std::invalid_argument("H mismatch: H_q must be a multiple of H_kv (K and V equal)");
+  // cross-attention: N_q may differ from N_kv (K and V equal)
+  if (K[2]!=V[2]) throw std::invalid_argument("N mismatch: K and V must have the same length");
+  if (Q[3]!=K[3] || Q[3]!=V[3]) throw std::invalid_argument("D mismatch");
+}
+
+static void validate_opts(const AttentionOpts& opts) {
+  if (std::isnan(opts.dropout_prob) || opts.dropout_prob < 0.0f || opts.dropout_prob > 1.0f)
+    throw std::invalid_argument("attention_forward: dropout_prob must be between 0 and 1 and not NaN");
+  if (!(opts.temperature > 0.0f))
+    throw std::invalid_argument("attention_forward: temperature must be positive");
+  if (opts.block_q < 0 || opts.block_k < 0)
+    throw std::invalid_argument("attention_forward: block sizes must be non-negative");
+  if (opts.num_threads < 0)
+    throw std::invalid_argument("attention_forward: num_threads must be non-negative");
+  if (opts.kv_splits < 0)
+    throw std::invalid_argument("attention_forward: kv_splits must be non-negative");
+  if (opts.window < 0)
+    throw std::invalid_argument("attention_forward: window must be non-negative");
+}
+
+void validate_attention_inputs(const std::vector<int>& Q,
+                               const std::vector<int>& K,
+                               const std::vector<int>& V,
+                               const ConstTensorView* mask,
+                               const AttentionOpts& opts)
+{
+  validate_opts(opts);
+  validate_core(Q,K,V);
+  if (mask) fa::mask::validate_padding_mask_b11n(Q[0], K[2], *mask);   // one bit per key
+}
+
+// A float (B,1,1,N) mask packed to keep bits once per call; the engines
+// only ever see the compact form.
+struct PackedMask {
+  PaddingBitmask bits;
+  AttentionMask mask;
+
+  explicit PackedMask(const ConstTensorView* m) {
+    if (m) {
+      bits = PaddingBitmask::from_tensor(*m);
+      mask.padding = &bits;
+    }
+  }
+  PackedMask(const PackedMask&) = delete;
+  PackedMask& operator=(const PackedMask&) = delete;
+};
+
+static Tensor forward_f32(const ConstTensorView& Q,
+                          const ConstTensorView& K,
+                          const ConstTensorView& V,
+                          const AttentionMask& mask,
+                          const AttentionOpts& opts,
+                          Tensor* lse)
+{
+  float* lse_out = nullptr;
+  if (lse) {
+    *lse = Tensor::empty({Q.dim(0), Q.dim(1), Q.dim(2)});   // every row is written
+    lse_out = lse->data();
+  }
+  switch (opts.engine) {
+    case AttentionEngine::Reference: return attention_forward_ref(Q, K, V, mask, opts, lse_out);
+    case AttentionEngine::Tiled:     return attention_forward_tiled<float, float>(Q, K, V, mask, opts, lse_out);
+  }
+  throw std::invalid_argument("attention_forward: unknown engine");
+}
+
+// 16-bit inputs: the tiled engine widens tile by tile; the reference engine
+// widens whole tensors and runs the fp32 oracle.
+template <class T, class OutT>
+static TensorT<OutT> forward_lowp(const TensorViewT<const T>& Q,
+                                  const TensorViewT<const T>& K,
+                                  const TensorViewT<const T>& V,
+                                  const ConstTensorView* mask,
+                                  const AttentionOpts& opts)
+{
+  validate_attention_inputs(Q.shape(), K.shape(), V.shape(), mask, opts);
+  const PackedMask packed(mask);
+  switch (opts.engine) {
+    case AttentionEngine::Reference: {
+      Tensor O = attention_forward_ref(cast<float>(Q).view(), cast<float>(K).view(),
+                                       cast<float>(V).view(), packed.mask, opts);
+      if constexpr (std::is_same_v<OutT, float>) return O;
+      else return cast<OutT>(O);
+    }
+    case AttentionEngine::Tiled: return attention_forward_tiled<T, OutT>(Q, K, V, packed.mask, opts);
+  }
+  throw std::invalid_argument("attention_forward: unknown engine");
+}
+
+static void validate_quantized(const QuantizedTensor& X, const char* name) {
+  const bool ok = X.shape.size() == 4 && X.block_rows > 0 &&
+                  X.values.size() == (size_t)X.dim(0)*X.dim(1)*X.dim(2)*X.dim(3) &&
+                  X.scales.size() == (size_t)X.dim(0)*X.dim(1)*X.blocks_per_head();
+  if (!ok) throw std::invalid_argument(std::string("attention_forward_int8: malformed quantized ") + name);
+}
+
+static void validate_packed(const PackedKV& K) {
+  const bool ok = K.shape.size() == 4 &&
+                  K.k.size() == (size_t)K.dim(0)*K.dim(1)*K.panels_per_head()*K.dim(3)*simd::kPanelKeys &&
+                  (!K.has_v || K.v.size() == (size_t)K.dim(0)*K.dim(1)*K.dim(2)*K.dim(3));
+  if (!ok) throw std::invalid_argument("attention_forward_packed: malformed PackedKV");
+}
+
+// O / dO / lse of a backward call against the forward's Q.
+static void validate_backward(const ConstTensorView& Q, const ConstTensorView& O,
+                              const ConstTensorView& dO, const ConstTensorView& lse) {
+  if (O.shape()!=Q.shape() || dO.shape()!=Q.shape())
+    throw std::invalid_argument("attention_backward: O and dO must have Q's shape");
+  if (lse.ndim()!=3 || lse.dim(0)!=Q.dim(0) || lse.dim(1)!=Q.dim(1) || lse.dim(2)!=Q.dim(2))
+    throw std::invalid_argument("attention_backward: lse must be (B,H,N)");
+}
+
+} // namespace detail
+
+Tensor attention_forward(const Tensor& Q,
+                         const Tensor& K,
+                         const Tensor& V,
+                         const Tensor* mask,
+                         const AttentionOpts& opts,
+                         Tensor* lse)
+{
+  const ConstTensorView mv = mask ? mask->view() : ConstTensorView();
+  return attention_forward(Q.view(), K.view(), V.view(), mask ? &mv : nullptr, opts, lse);
+}
+
+Tensor attention_forward(const ConstTensorView& Q,
+                         const ConstTensorView& K,
+                         const ConstTensorView& V,
+                         const ConstTensorView* mask,
+                         const AttentionOpts& opts,
+                         Tensor* lse)
+{
+  detail::validate_attention_inputs(Q.shape(), K.shape(), V.shape(), mask, opts);
+  const detail::PackedMask packed(mask);
+  return detail::forward_f32(Q, K, V, packed.mask, opts, lse);
+}
+
+Tensor attention_forward(const ConstTensorView& Q,
+                         const ConstTensorView& K,
+                         const ConstTensorView& V,
+                         const AttentionMask& mask,
+                         const AttentionOpts& opts,
+                         Tensor* lse)
+{
+  detail::validate_attention_inputs(Q.shape(), K.shape(), V.shape(), nullptr, opts);
+  fa::mask::validate_attention_mask(Q.dim(0), Q.dim(2), K.dim(2), mask);
+  return detail::forward_f32(Q, K, V, mask, opts, lse);
+}
+
+void attention_forward(const ConstTensorView& Q,
+                       const ConstTensorView& K,
+                       const ConstTensorView& V,
+                       const AttentionMask& mask,
+                       const AttentionOpts& opts,
+                       const TensorView& out,
+                       AttentionWorkspace& ws)
+{
+  detail::validate_attention_inputs(Q.shape(), K.shape(), V.shape(), nullptr, opts);
+  fa::mask::validate_attention_mask(Q.dim(0), Q.dim(2), K.dim(2), mask);
+  if (out.shape() != Q.shape()) throw std::invalid_argument("attention_forward: out must have Q's shape");
+  if (out.stride(3) != 1) throw std::invalid_argument("attention_forward: out must have D stride 1");
+  detail::attention_forward_tiled_into(Q, K, V, mask, opts, out, ws);
+}
+
+size_t attention_workspace_size(const ConstTensorView& Q,
+                                const ConstTensorView& K,
+                                const AttentionMask& mask,
+                                const AttentionOpts& opts)
+{
+  if (Q.ndim() != 4 || K.ndim() != 4)
+    throw std::invalid_argument("attention_workspace_size: Q and K must be 4D (B,H,N,D)");
+  return detail::tiled_workspace_bytes(Q.shape(), K.shape(), mask, opts);
+}
+
+std::vector<Tensor> attention_forward_batch(const std::vector<AttentionProblem>& problems,
+                                            int num_threads,
+                                            AttentionStats* stats)
+{
+  if (num_threads < 0)
+    throw std::invalid_argument("attention_forward_batch: num_threads must be non-negative");
+  for (size_t k=0; k<problems.size(); ++k) {
+    const AttentionProblem& p = problems[k];
+    try {
+      detail::validate_attention_inputs(p.Q.shape(), p.K.shape(), p.V.shape(), nullptr, p.opts);
+      fa::mask::validate_attention_mask(p.Q.dim(0), p.Q.dim(2), p.K.dim(2), p.mask);
+      if (p.opts.kv_splits > 1)
+        throw std::invalid_argument("kv_splits > 1 is not supported in a batch");
+    } catch (const std::invalid_argument& e) {
+      throw std::invalid_argument("attention_forward_batch: problem " + std::to_string(k) + ": " + e.what());
+    }
+  }
+  return detail::attention_forward_batch(problems, num_threads, stats);
+}
+
+AttentionGrads attention_backward(const Tensor& Q,
+                                  const Tensor& K,
+                                  const Tensor& V,
+                                  const Tensor& O,
+                                  const Tensor& dO,
+                                  const Tensor& lse,
+                                  const Tensor* mask,
+                                  const AttentionOpts& opts)
+{
+  const ConstTensorView mv = mask ? mask->view() : ConstTensorView();
+  return attention_backward(Q.view(), K.view(), V.view(), O.view(), dO.view(), lse.view(),
+                            mask ? &mv : nullptr, opts);
+}
+
+AttentionGrads attention_backward(const ConstTensorView& Q,
+                                  const ConstTensorView& K,
+                                  const ConstTensorView& V,
+                                  const ConstTensorView& O,
+                                  const ConstTensorView& dO,
+                                  const ConstTensorView& lse,
+                                  const ConstTensorView* mask,
+                                  const AttentionOpts& opts)
+{
+  detail::validate_attention_inputs(Q.shape(), K.shape(), V.shape(), mask, opts);
+  detail::validate_backward(Q, O, dO, lse);
+  const detail::PackedMask packed(mask);
+  return detail::attention_backward(Q, K, V, O, dO, lse, packed.mask, opts);
+}
+
+AttentionGrads attention_backward(const ConstTensorView& Q,
+                                  const ConstTensorView& K,
+                                  const ConstTensorView& V,
+                                  const ConstTensorView& O,
+                                  const ConstTensorView& dO,
+                                  const ConstTensorView& lse,
+                                  const AttentionMask& mask,
+                                  const AttentionOpts& opts)
+{
+  detail::validate_attention_inputs(Q.shape(), K.shape(), V.shape(), nullptr, opts);
+  fa::mask::validate_attention_mask(Q.dim(0), Q.dim(2), K.dim(2), mask);
+  detail::validate_backward(Q, O, dO, lse);
+  return detail::attention_backward(Q, K, V, O, dO, lse, mask, opts);
+}
+
+Tensor attention_forward(const TensorViewT<const bf16>& Q,
+                         const TensorViewT<const bf16>& K,
+                         const TensorViewT<const bf16>& V,
+                         const ConstTensorView* mask,
+                         const AttentionOpts& opts)
+{
+  return detail::forward_lowp<bf16, float>(Q, K, V, mask, opts);
+}
+
+Tensor attention_forward(const TensorViewT<const fp16>& Q,
+                         const TensorViewT<const fp16>& K,
+                         const TensorViewT<const fp16>& V,
+                         const ConstTensorView* mask,
+                         const AttentionOpts& opts)
+{
+  return detail::forward_lowp<fp16, float>(Q, K, V, mask, opts);
+}
+
+TensorBF16 attention_forward_bf16(const TensorViewT<const bf16>& Q,
+                                  const TensorViewT<const bf16>& K,
+                                  const TensorViewT<const bf16>& V,
+                                  const ConstTensorView* mask,
+                                  const AttentionOpts& opts)
+{
+  return detail::forward_lowp<bf16, bf16>(Q, K, V, mask, opts);
+}
+
+TensorF16 attention_forward_f16(const TensorViewT<const fp16>& Q,
+                                const TensorViewT<const fp16>& K,
+                                const TensorViewT<const fp16>& V,
+                                const ConstTensorView* mask,
+                                const AttentionOpts& opts)
+{
+  return detail::forward_lowp<fp16, fp16>(Q, K, V, mask, opts);
+}
+
+Tensor attention_forward_int8(const ConstTensorView& Q,
+                              const QuantizedTensor& K,
+                              const QuantizedTensor& V,
+                              const ConstTensorView* mask,
+                              const AttentionOpts& opts)
+{
+  detail::validate_quantized(K, "K");
+  detail::validate_quantized(V, "V");
+  detail::validate_attention_inputs(Q.shape(), K.shape, V.shape, mask, opts);
+  const detail::PackedMask packed(mask);
+  return detail::attention_forward_int8(Q, K, V, packed.mask, opts);
+}
+
+Tensor attention_forward_packed(const ConstTensorView& Q,
+                                const PackedKV& KV,
+                                const AttentionMask& mask,
+                                const AttentionOpts& opts,
+                                Tensor* lse)
+{
+  detail::validate_packed(KV);
+  if (!KV.has_v) throw std::invalid_argument("attention_forward_packed: V was not packed; pass V as a view");
+  const ConstTensorView V(KV.v.data(), KV.shape);
+  return attention_forward_packed(Q, KV, V, mask, opts, lse);
+}
+
+Tensor attention_forward_packed(const ConstTensorView& Q,
+                                const PackedKV& K,
+                                const ConstTensorView& V,
+                                const AttentionMask& mask,
+                                const AttentionOpts& opts,
+                                Tensor* lse)
+{
+  detail::validate_packed(K);
+  detail::validate_attention_inputs(Q.shape(), K.shape, V.shape(), nullptr, opts);
+  if (K.shape != V.shape()) throw std::invalid_argument("attention_forward_packed: K and V shapes differ");
+  fa::mask::validate_attention_mask(Q.dim(0), Q.dim(2), K.dim(2), mask);
+  if (mask.blocks && mask.blocks->block_k() % simd::kPanelKeys != 0)
+    throw std::invalid_argument("attention_forward_packed: block-sparse block_k must be a multiple of the K panel width");
+  float* lse_out = nullptr;
+  if (lse) {
+    *lse = Tensor::empty({Q.dim(0), Q.dim(1), Q.dim(2)});   // every row is written
+    lse_out = lse->data();
+  }
+  return detail::attention_forward_packed(Q, K, V, mask, opts, lse_out);
+}
+
+Tensor attention_decode(const ConstTensorView& Q,
+                        const KVCache& cache,
+                        const AttentionOpts& opts)
+{
+  detail::validate_opts(opts);
+  if (Q.ndim()!=4) throw std::invalid_argument("attention_decode: Q must be 4D (B,H,T,D)");
+  if (Q.dim(0)!=cache.batch()) throw std::invalid_argument("attention_decode: B mismatch");
+  if (Q.dim(1)%cache.heads()!=0)
+    throw std::invalid_argument("attention_decode: H mismatch: H_q must be a multiple of the cache heads");
+  if (Q.dim(3)!=cache.head_dim()) throw std::invalid_argument("attention_decode: D mismatch");
+  if (opts.causal) {
+    for (int b=0; b<cache.batch(); ++b)
+      if (cache.length(b) < Q.dim(2))
+        throw std::invalid_argument("attention_decode: causal decode needs the T new tokens appended first");
+  }
+  return detail::attention_decode(Q, cache, opts);
+}
+
+Tensor attention_forward_stream(const ConstTensorView& Q,
+                                KVSource& source,
+                                const AttentionMask& mask,
+                                const AttentionOpts& opts,
+                                int block_keys,
+                                Tensor* lse)
+{
+  detail::validate_opts(opts);
+  if (Q.ndim()!=4) throw std::invalid_argument("attention_forward_stream: Q must be 4D (B,H,N,D)");
+  if (Q.dim(0)!=source.batch()) throw std::invalid_argument("attention_forward_stream: B mismatch");
+  if (source.heads()<=0 || Q.dim(1)%source.heads()!=0)
+    throw std::invalid_argument("attention_forward_stream: H mismatch: H_q must be a multiple of the source heads");
+  if (Q.dim(3)!=source.head_dim()) throw std::invalid_argument("attention_forward_stream: D mismatch");
+  if (source.length() < 0) throw std::invalid_argument("attention_forward_stream: negative source length");
+  if (block_keys < 0) throw std::invalid_argument("attention_forward_stream: block_keys must be non-negative");
+  fa::mask::validate_attention_mask(Q.dim(0), Q.dim(2), source.length(), mask);
+  float* lse_out = nullptr;
+  if (lse) {
+    *lse = Tensor::empty({Q.dim(0), Q.dim(1), Q.dim(2)});   // every row is written
+    lse_out = lse->data();
+  }
+  return detail::attention_forward_stream(Q, source, mask, opts, block_keys, lse_out);
+}
+
+Tensor attention_forward_varlen(const ConstTensorView& Q,
+                                const ConstTensorView& K,
+                                const ConstTensorView& V,
+                                const std::vector<int>& cu_seqlens,
+                                const AttentionOpts& opts)
+{
+  detail::validate_opts(opts);
+  if (Q.ndim()!=3 || K.ndim()!=3 || V.ndim()!=3)
+    throw std::invalid_argument("attention_forward_varlen: Q,K,V must be 3D (total,H,D)");
+  if (K.shape()!=V.shape() || Q.dim(0)!=K.dim(0) || Q.dim(2)!=K.dim(2) || Q.dim(1)%K.dim(1)!=0)
+    throw std::invalid_argument("attention_forward_varlen: Q,K,V shape mismatch (H_q must be a multiple of H_kv)");
+  if (cu_seqlens.size() < 2 || cu_seqlens.front() != 0 || cu_seqlens.back() != Q.dim(0))
+    throw std::invalid_argument("attention_forward_varlen: cu_seqlens must run from 0 to total");
+  for (size_t s=1; s<cu_seqlens.size(); ++s)
+    if (cu_seqlens[s] < cu_seqlens[s-1])
+      throw std::invalid_argument("attention_forward_varlen: cu_seqlens must be non-decreasing");
+  return detail::attention_forward_varlen(Q, K, V, cu_seqlens, opts);
+}
+
+} // namespace fa
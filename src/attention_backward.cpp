@@ -0,0 +1,201 @@
+#include "attention_impl.hpp"
+#include "attention_tile.hpp"
+#include "cpu/thread_pool.hpp"
+#include "fa/math.hpp"
+#include "fa/random.hpp"
+#include "fa/simd.hpp"
+#include "fa/tensor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Backward pass with recomputation (FlashAttention-2 style).
+//
+// With S = QK^T / temperature, P = softmax(S) and O = dropout(P) V, the
+// forward saved only lse = log(sum_j exp(S_ij)) per row, so any tile of P is
+// exp(S - lse) again. With Delta_i = dO_i . O_i:
+//
+//   dV_j = sum_i P'_ij dO_i                 (P' = dropped, rescaled P)
+//   dP_ij = dropout(dO_i . V_j)             (same keep bits and 1/(1-p))
+//   dS_ij = P_ij (dP_ij - Delta_i)
+//   dQ_i = sum_j dS_ij K_j / temperature,   dK_j = sum_i dS_ij Q_i / temperature
+//
+// dK/dV and dQ are produced by two passes that each recompute P instead of
+// one pass with atomic dQ updates: work items of the first pass are (b, K/V
+// head, key block) and own their dK/dV rows, summing over every query head of
+// the group and every query row that can see the block; work items of the
+// second are (b, head, query block) and own their dQ rows. No row has two
+// writers and the summation order is fixed, so results are bitwise
+// identical for any opts.num_threads. Scratch is O(Bc*D) per worker.
+//
+// Masking is the forward's: causal / window spans, padding bits and the
+// block-sparse tile list (its blocks are the tile grid), each applied to the
+// recomputed logits, so masked entries get zero gradient. With N_q != N_k
+// query i sits at key position i + N_k - N_q, as in the forward.
+
+namespace fa::detail {
+
+namespace {
+
+struct BackwardScratch {
+  std::vector<float> p, dp, pd;   // Bc probabilities, dP, dropped probabilities
+  std::vector<float> dk, dv;      // Bc x D key-block accumulators
+  std::vector<float> dq;          // D
+
+  BackwardScratch(int bc, int d)
+    : p(bc), dp(bc), pd(bc), dk((size_t)bc*d), dv((size_t)bc*d), dq(d) {}
+};
+
+} // namespace
+
+AttentionGrads attention_backward(const ConstTensorView& Q_in, const ConstTensorView& K_in,
+                                  const ConstTensorView& V_in, const ConstTensorView& O_in,
+                                  const ConstTensorView& dO_in, const ConstTensorView& lse,
+                                  const AttentionMask& mask, const AttentionOpts& opts)
+{
+  Tensor q_copy, k_copy, v_copy, o_copy, do_copy;
+  const ConstTensorView Q = unit_inner(Q_in, q_copy);
+  const ConstTensorView K = unit_inner(K_in, k_copy);
+  const ConstTensorView V = unit_inner(V_in, v_copy);
+  const ConstTensorView O = unit_inner(O_in, o_copy);
+  const ConstTensorView dO = unit_inner(dO_in, do_copy);
+
+  const int B=Q.dim(0), H=Q.dim(1), N=Q.dim(2), D=Q.dim(3);
+  const int Hkv = K.dim(1), G = H / Hkv, Nk = K.dim(2);
+  const int off = Nk - N;
+  const fa::tune::TileConfig tiles = block_sparse_tiles(mask, opts, N, Nk, D);
+  const int Br = tiles.block_q;
+  const int Bc = tiles.block_k;
+  const int nqb = (N + Br - 1) / Br;
+  const int nkb = (Nk + Bc - 1) / Bc;
+  const float ninf = fa::math::neg_inf();
+  const float inv_temp = 1.0f / opts.temperature;
+  const int W = opts.window;
+  const bool drop = opts.dropout_prob > 0.0f;
+  const fa::rnd::DropoutRng dropout(opts.dropout_seed, opts.dropout_prob);
+
+  AttentionGrads g{Tensor::empty({B,H,N,D}), Tensor::empty({B,Hkv,Nk,D}), Tensor::empty({B,Hkv,Nk,D})};
+  Tensor delta = Tensor::empty({B,H,N});
+
+  const simd::MicroKernels& kern = simd::kernels();
+  cpu::ThreadPool& pool = cpu::ThreadPool::instance(opts.num_threads);
+  std::vector<BackwardScratch> scratch(pool.size(), BackwardScratch(Bc, D));
+
+  auto row = [](const ConstTensorView& X, int b, int h, int i) {
+    return X.data() + b*X.stride(0) + h*X.stride(1) + (std::ptrdiff_t)i*X.stride(2);
+  };
+  auto lse_at = [&](int b, int h, int i) {
+    return lse.data()[b*lse.stride(0) + h*lse.stride(1) + (std::ptrdiff_t)i*lse.stride(2)];
+  };
+  // Visible keys of query i: [lo(i), hi(i)), as in forward_query_block.
+  auto lo = [&](int i) { return W > 0 ? std::max(0, i + off - W + 1) : 0; };
+  auto hi = [&](int i) {
+    int h = Nk;
+    i += off;
+    if (opts.causal) h = std::min(h, i + 1);
+    if (W > 0) h = std::min(h, i + W);
+    return h;
+  };
+
+  // Keys [j0+a, j0+n) of query i in head (b,h): ws.p = P, ws.dp = dP (both
+  // after dropout's 1/(1-p) where it applies), ws.pd = P'. Indexed from j0.
+  auto recompute = [&](int b, int h, int i, int j0, int a, int n, BackwardScratch& ws) {
+    const int hk = h / G;
+    float* p = ws.p.data();
+    float* dp = ws.dp.data();
+    kern.qk(row(Q,b,h,i), row(K,b,hk,j0+a), K.stride(2), n-a, D, p + a);
+    const float l = lse_at(b,h,i);
+    for (int c=a; c<n; ++c) p[c] = p[c]*inv_temp - l;
+    if (mask.padding) {
+      for (int c=a; c<n; ++c) if (!mask.padding->keep(b, j0 + c)) p[c] = ninf;
+    }
+    kern.exp(p + a, p + a, n - a);
+    kern.qk(row(dO,b,h,i), row(V,b,hk,j0+a), V.stride(2), n-a, D, dp + a);
+    std::copy(p + a, p + n, ws.pd.data() + a);
+    if (drop) {
+      dropout.apply(b, h, i + off, j0 + a, n - a, ws.pd.data() + a);
+      dropout.apply(b, h, i + off, j0 + a, n - a, dp + a);
+    }
+  };
+
+  // Delta_i = dO_i . O_i
+  pool.parallel_for(B*H, [&](int t, int) {
+    const int b = t / H, h = t % H;
+    float* out = delta.data() + (size_t)t*N;
+    for (int i=0; i<N; ++i) out[i] = kern.dot(row(dO,b,h,i), row(O,b,h,i), D);
+  });
+
+  // dK, dV: one key block of one K/V head, all G query heads that share it.
+  pool.parallel_for(B*Hkv*nkb, [&](int t, int worker) {
+    BackwardScratch& ws = scratch[worker];
+    const int kb = query_block_order(t % nkb, nkb, opts.causal);
+    const int b = t / nkb / Hkv, hk = t / nkb % Hkv;
+    const int j0 = kb*Bc, bc = std::min(Bc, Nk - j0);
+    std::fill(ws.dk.begin(), ws.dk.end(), 0.0f);
+    std::fill(ws.dv.begin(), ws.dv.end(), 0.0f);
+
+    // Queries that can see some key of the block.
+    const int i_lo = std::max({0, opts.causal ? j0 - off : 0, W > 0 ? j0 - W + 1 - off : 0});
+    const int i_hi = W > 0 ? std::min(N, j0 + bc - 1 + W - off) : N;
+    const bool any_kept = !mask.padding || mask.padding->count(b, j0, bc) > 0;
+
+    for (int h = hk*G; any_kept && h < (hk+1)*G; ++h) {
+      const float* dl = delta.data() + ((size_t)b*H + h)*N;
+      for (int i = i_lo; i < i_hi; ++i) {
+        if (mask.blocks && !mask.blocks->active(i / Br, kb)) continue;
+        const int a = std::max(0, lo(i) - j0);
+        const int n = std::min(bc, hi(i) - j0);
+        if (n <= a || std::isinf(lse_at(b,h,i))) continue;
+        recompute(b, h, i, j0, a, n, ws);
+        const float* q_i = row(Q,b,h,i);
+        const float* do_i = row(dO,b,h,i);
+        for (int c=a; c<n; ++c) {
+          const float ds = ws.p[c]*(ws.dp[c] - dl[i])*inv_temp;
+          if (ws.pd[c] != 0.0f) kern.axpy(ws.pd[c], do_i, ws.dv.data() + (size_t)c*D, D);
+          if (ds != 0.0f) kern.axpy(ds, q_i, ws.dk.data() + (size_t)c*D, D);
+        }
+      }
+    }
+    for (int c=0; c<bc; ++c) {
+      const size_t at = (((size_t)b*Hkv + hk)*Nk + j0 + c)*D;
+      std::copy(ws.dk.data() + (size_t)c*D, ws.dk.data() + (size_t)(c+1)*D, g.dK.data() + at);
+      std::copy(ws.dv.data() + (size_t)c*D, ws.dv.data() + (size_t)(c+1)*D, g.dV.data() + at);
+    }
+  });
+
+  // dQ: one query block of one head, key tiles visited as in the forward.
+  pool.parallel_for(B*H*nqb, [&](int t, int worker) {
+    BackwardScratch& ws = scratch[worker];
+    const int qb = query_block_order(t % nqb, nqb, opts.causal);
+    const int b = t / nqb / H, h = t / nqb % H, hk = h / G;
+    const float* dl = delta.data() + ((size_t)b*H + h)*N;
+    float* dq = ws.dq.data();
+
+    auto visit = [&](int i, int j0) {
+      const int bc = std::min(Bc, Nk - j0);
+      const int a = std::max(0, lo(i) - j0);
+      const int n = std::min(bc, hi(i) - j0);
+      if (n <= a) return;
+      if (mask.padding && mask.padding->count(b, j0, bc) == 0) return;
+      recompute(b, h, i, j0, a, n, ws);
+      for (int c=a; c<n; ++c) ws.p[c] = ws.p[c]*(ws.dp[c] - dl[i])*inv_temp;   // dS
+      kern.pv(ws.p.data() + a, row(K,b,hk,j0+a), K.stride(2), n - a, D, dq);
+    };
+
+    for (int i = qb*Br; i < std::min(N, qb*Br + Br); ++i) {
+      std::fill(dq, dq + D, 0.0f);
+      if (!std::isinf(lse_at(b,h,i))) {
+        if (mask.blocks) {
+          for (const int* kt = mask.blocks->begin(qb); kt != mask.blocks->end(qb); ++kt)
+            if (*kt * Bc < Nk) visit(i, *kt * Bc);
+        } else {
+          for (int j0 = lo(i) / Bc * Bc; j0 < hi(i); j0 += Bc) visit(i, j0);
+        }
+      }
+      std::copy(dq, dq + D, g.dQ.data() + (((size_t)b*H + h)*N + i)*D);
+    }
+  });
+  return g;
+}
+
+} // namespace fa::detail
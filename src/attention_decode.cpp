@@ -0,0 +1,115 @@
+#include "attention_impl.hpp"
+#include "attention_tile.hpp"
+#include "cpu/thread_pool.hpp"
+#include "fa/kv_cache.hpp"
+#include "fa/simd.hpp"
+#include <algorithm>
+#include <vector>
+
+// Decode step over a paged KVCache (same query-block loop as the tiled
+// engine). The key tile is exactly one cache page, so the K/V rows of a tile
+// are contiguous and are read in place; a step with T new queries costs
+// O(T * cached_len * D) per head instead of re-running the whole prefix.
+// With opts.causal, the T queries are taken to be the last T cached tokens
+// (append first, then decode): query t sees keys j <= length(b) - T + t.
+// With fewer cache heads than query heads (GQA/MQA), every query head of a
+// group reads the same pages, and one work item covers the group.
+//
+// A single long-context stream has only B*H*ceil(T/Br) items, usually fewer
+// than cores; split-K (kv_split) then cuts the pages into chunks that run in
+// parallel and are merged by combine_kv_splits.
+
+namespace fa::detail {
+
+namespace {
+
+struct PagedTiles {
+  RowSlice q_in;             // first query head of the group
+  std::ptrdiff_t q_gs;
+  const KVCache& cache;
+  int b, h, D;               // h is the cache (K/V) head
+  const simd::MicroKernels& kern;
+  QueryRows q{};
+  RowSlice k{}, v{};
+
+  void load_queries(int i0, int br) { q = QueryRows{q_in.row(i0), q_in.rs, q_gs, br}; }
+  void load_keys(int j0, int) {
+    const int P = cache.page_size();
+    const std::ptrdiff_t head = (std::ptrdiff_t)h*P*D;
+    k = RowSlice{cache.k_page(b, j0 / P) + head, (std::ptrdiff_t)D};
+    v = RowSlice{cache.v_page(b, j0 / P) + head, (std::ptrdiff_t)D};
+  }
+  void logits(int r, int bc, float* s) { kern.qk(q.row(r), k.row(0), k.rs, bc, D, s); }
+  void accumulate(int bc, float* p, float* acc) { kern.pv(p, v.row(0), v.rs, bc, D, acc); }
+};
+
+} // namespace
+
+Tensor attention_decode(const ConstTensorView& Q_in, const KVCache& cache, const AttentionOpts& opts)
+{
+  Tensor q_copy;
+  if (Q_in.stride(3) != 1) q_copy = Tensor::from(Q_in);
+  const ConstTensorView Q = Q_in.stride(3) == 1 ? Q_in : q_copy.view();
+
+  const int B=Q.dim(0), H=Q.dim(1), T=Q.dim(2), D=Q.dim(3);
+  const int Br = std::min(T, opts.block_q > 0 ? opts.block_q : 64);
+  const int Bc = cache.page_size();
+
+  Tensor O = Tensor::empty({B,H,T,D});
+  const size_t slice = (size_t)T*D;
+  const int nqb = (T + Br - 1) / Br;
+  const int Hkv = cache.heads();
+
+  const simd::MicroKernels& kern = simd::kernels();
+  cpu::ThreadPool& pool = cpu::ThreadPool::instance(opts.num_threads);
+  const KvSplit kv = kv_split(opts, (long long)B*H*nqb, (cache.max_length() + Bc - 1) / Bc);
+  const int S = kv.count;
+  const int G = heads_per_item(B*Hkv*nqb*S, H / Hkv, pool.size());
+  const int splits = H / Hkv / G;
+  const int tasks = B*Hkv*splits*nqb*S;
+  TileScratchSet scratch(pool.size(), G*Br, Bc, D);
+  // chunk c of row (b,h,t): part + ((c*B + b)*H + h)*T*D, lse in plse
+  std::vector<float> part(S > 1 ? (size_t)S*B*H*T*D : 0), plse(S > 1 ? (size_t)S*B*H*T : 0);
+
+  pool.parallel_for(tasks, [&](int t, int worker) {
+    const int c = t % S;
+    const int qb = query_block_order(t / S % nqb, nqb, opts.causal);
+    const int item = t / S / nqb;
+    const int b = item / (Hkv*splits);
+    const int hk = item / splits % Hkv;
+    const int h0 = (hk*splits + item % splits)*G;
+    const int L = cache.length(b);
+    const int i0 = qb*Br;
+    PagedTiles tiles{RowSlice{Q.data() + b*Q.stride(0) + h0*Q.stride(1), (std::ptrdiff_t)Q.stride(2)},
+                     (std::ptrdiff_t)Q.stride(1), cache, b, hk, D, kern};
+    KeyMask km = key_mask(AttentionMask{}, b, h0, 0);
+    if (S == 1) {
+      forward_query_block(tiles, km, O.data() + ((size_t)b*H + h0)*slice, D, (std::ptrdiff_t)slice,
+                          L, D, i0, std::min(Br, T-i0), G, Bc, L - T, opts, kern, scratch[worker]);
+      return;
+    }
+    km.j_begin = c*kv.tiles*Bc;
+    km.j_end = km.j_begin + kv.tiles*Bc;
+    const size_t head = ((size_t)c*B + b)*H + h0;
+    forward_query_block(tiles, km, part.data() + head*slice, D, (std::ptrdiff_t)slice,
+                        L, D, i0, std::min(Br, T-i0), G, Bc, L - T, opts, kern, scratch[worker],
+                        plse.data() + head*T, (std::ptrdiff_t)T);
+  });
+
+  if (S > 1) {
+    pool.parallel_for(B*H, [&](int t, int worker) {
+      TileScratch& w = scratch[worker];
+      StatsSink* st = stats_sink(opts, w.stats);
+      for (int i=0; i<T; ++i) {
+        const size_t row = (size_t)t*T + i;
+        if (!combine_kv_splits(part.data() + row*D, (std::ptrdiff_t)B*H*slice, plse.data() + row,
+                               (std::ptrdiff_t)B*H*T, S, D, kern, w.acc, O.data() + row*D, (float*)nullptr) && st)
+          ++st->rows_fully_masked;
+      }
+    });
+  }
+  merge_stats(opts, scratch, (int64_t)D*sizeof(float), 2*(int64_t)D*sizeof(float), (int64_t)D*sizeof(float));
+  return O;
+}
+
+} // namespace fa::detail
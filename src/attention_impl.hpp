@@ -0,0 +1,71 @@
+#pragma once
+// Internal engine entry points shared by the attention translation units.
+// Not installed; include/fa/attention.hpp is the public surface.
+#include "fa/attention.hpp"
+#include <vector>
+
+namespace fa::detail {
+
+// Shape/option checks common to every engine and element type. Takes the
+// Q/K/V shapes so 16-bit views share it. Throws std::invalid_argument.
+void validate_attention_inputs(const std::vector<int>& q_shape,
+                               const std::vector<int>& k_shape,
+                               const std::vector<int>& v_shape,
+                               const ConstTensorView* mask,
+                               const AttentionOpts& opts);
+
+// Engines assume validate_attention_inputs has already passed. They take
+// masks in compact form only; float (B,1,1,N) masks are packed into a
+// PaddingBitmask once per call by the public entry points. A non-null lse is
+// a contiguous (B,H,N) buffer that receives each row's log-sum-exp.
+Tensor attention_forward_ref(const ConstTensorView& Q, const ConstTensorView& K,
+                             const ConstTensorView& V, const AttentionMask& mask,
+                             const AttentionOpts& opts, float* lse = nullptr);
+
+// T is the Q/K/V storage type, OutT the output type. Instantiated in
+// attention_tiled.cpp for float->float, bf16->{float,bf16}, fp16->{float,fp16}.
+template <class T, class OutT>
+TensorT<OutT> attention_forward_tiled(const TensorViewT<const T>& Q, const TensorViewT<const T>& K,
+                                      const TensorViewT<const T>& V, const AttentionMask& mask,
+                                      const AttentionOpts& opts, float* lse = nullptr);
+
+// fp32 tiled engine writing into a caller view (unit D stride) with tile
+// buffers from ws; see the allocation-free attention_forward overload.
+void attention_forward_tiled_into(const ConstTensorView& Q, const ConstTensorView& K,
+                                  const ConstTensorView& V, const AttentionMask& mask,
+                                  const AttentionOpts& opts, const TensorView& out,
+                                  AttentionWorkspace& ws);
+
+// Arena bytes attention_forward_tiled_into needs for these shapes.
+std::size_t tiled_workspace_bytes(const std::vector<int>& q_shape, const std::vector<int>& k_shape,
+                                  const AttentionMask& mask, const AttentionOpts& opts);
+
+Tensor attention_forward_int8(const ConstTensorView& Q, const QuantizedTensor& K,
+                              const QuantizedTensor& V, const AttentionMask& mask,
+                              const AttentionOpts& opts);
+
+// V has K's shape (packed rows or the caller's view).
+Tensor attention_forward_packed(const ConstTensorView& Q, const PackedKV& K, const ConstTensorView& V,
+                                const AttentionMask& mask, const AttentionOpts& opts, float* lse);
+
+Tensor attention_decode(const ConstTensorView& Q, const KVCache& cache, const AttentionOpts& opts);
+
+// Validated by attention_forward_stream; lse as for the other engines.
+Tensor attention_forward_stream(const ConstTensorView& Q, KVSource& source, const AttentionMask& mask,
+                                const AttentionOpts& opts, int block_keys, float* lse);
+
+// Every problem already validated; see attention_forward_batch.
+std::vector<Tensor> attention_forward_batch(const std::vector<AttentionProblem>& problems,
+                                            int num_threads, AttentionStats* stats);
+
+// Gradients from the saved lse; validated by attention_backward.
+AttentionGrads attention_backward(const ConstTensorView& Q, const ConstTensorView& K,
+                                  const ConstTensorView& V, const ConstTensorView& O,
+                                  const ConstTensorView& dO, const ConstTensorView& lse,
+                                  const AttentionMask& mask, const AttentionOpts& opts);
+
+Tensor attention_forward_varlen(const ConstTensorView& Q, const ConstTensorView& K,
+                                const ConstTensorView& V, const std::vector<int>& cu_seqlens,
+                                const AttentionOpts& opts);
+
+} // namespace fa::detail
@@ -0,0 +1,148 @@
+#include "attention_impl.hpp"
+#include "attention_tile.hpp"
+#include "cpu/thread_pool.hpp"
+#include "fa/autotune.hpp"
+#include "fa/quantize.hpp"
+#include "fa/simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Tiled engine over int8 K/V (same query-block loop as attention_tiled.cpp).
+//
+// Each Q row is quantized on load (symmetric, absmax/127) so QK^T is an exact
+// int32 dot product of int8 rows (maddubs, or vpdpbusd with AVX512_VNNI);
+// the int32 result is dequantized with one multiply by q_scale * k_scale.
+// For PV the int8 V tile is widened (scale applied) once into an L1-sized fp32
+// tile shared by all Br query rows; a single-row block (decode) instead folds
+// the V scale into the softmax weights and widens inside the FMA loop. K and V
+// stay int8 in memory either way.
+
+namespace fa::detail {
+
+namespace {
+
+struct Int8Scratch {
+  std::vector<int8_t> q8;     // rows x D quantized query block
+  std::vector<float> qs;      // per-row query scales
+  std::vector<int32_t> dots;  // Bc raw QK dot products
+  std::vector<float> ks, vs;  // Bc per-key K / V scales of the current tile
+  std::vector<float> vw;      // Bc x D scaled fp32 V tile (multi-row query blocks)
+
+  Int8Scratch(int rows, int bc, int d)
+    : q8((size_t)rows*d), qs(rows), dots(bc), ks(bc), vs(bc), vw((size_t)bc*d) {}
+};
+
+struct Int8Tiles {
+  RowSlice q_in;             // first query head of the group
+  std::ptrdiff_t q_gs;       // query head stride
+  int group;
+  const int8_t* k;           // (N,D) rows of this (b, K/V head)
+  const int8_t* v;
+  const float* k_scales;     // blocks of this (b, K/V head)
+  const float* v_scales;
+  int k_block, v_block;
+  int D;
+  const simd::MicroKernels& kern;
+  Int8Scratch& ws;
+  int j0 = 0;
+  bool widen_v = false;
+
+  void load_queries(int i0, int br) {
+    const QueryRows rows{q_in.row(i0), q_in.rs, q_gs, br};
+    widen_v = br*group > 1;
+    for (int r=0; r<br*group; ++r) {
+      const float* q = rows.row(r);
+      float amax = 0.0f;
+      for (int d=0; d<D; ++d) amax = std::max(amax, std::fabs(q[d]));
+      const float inv = amax > 0.0f ? 127.0f / amax : 0.0f;
+      ws.qs[r] = amax / 127.0f;
+      int8_t* q8 = ws.q8.data() + (size_t)r*D;
+      for (int d=0; d<D; ++d) q8[d] = static_cast<int8_t>(std::clamp(std::nearbyint(q[d]*inv), -127.0f, 127.0f));
+    }
+  }
+
+  void load_keys(int j, int bc) {
+    j0 = j;
+    for (int c=0; c<bc; ++c) {
+      ws.ks[c] = k_scales[(j0 + c)/k_block];
+      ws.vs[c] = v_scales[(j0 + c)/v_block];
+    }
+    if (widen_v) {
+      for (int c=0; c<bc; ++c) {
+        float* vr = ws.vw.data() + (size_t)c*D;
+        std::fill(vr, vr + D, 0.0f);
+        kern.pv_i8(&ws.vs[c], v + (size_t)(j0 + c)*D, D, 1, D, vr);
+      }
+    }
+  }
+
+  void logits(int r, int bc, float* s) {
+    kern.qk_i8(ws.q8.data() + (size_t)r*D, k + (size_t)j0*D, D, bc, D, ws.dots.data());
+    const float qs = ws.qs[r];
+    for (int c=0; c<bc; ++c) s[c] = float(ws.dots[c]) * (qs*ws.ks[c]);
+  }
+
+  void accumulate(int bc, float* p, float* acc) {
+    if (widen_v) {
+      kern.pv(p, ws.vw.data(), D, bc, D, acc);
+      return;
+    }
+    for (int c=0; c<bc; ++c) p[c] *= ws.vs[c];
+    kern.pv_i8(p, v + (size_t)j0*D, D, bc, D, acc);
+  }
+};
+
+} // namespace
+
+Tensor attention_forward_int8(const ConstTensorView& Q_in,
+                              const QuantizedTensor& K,
+                              const QuantizedTensor& V,
+                              const AttentionMask& mask,
+                              const AttentionOpts& opts)
+{
+  Tensor q_copy;
+  if (Q_in.stride(3) != 1) q_copy = Tensor::from(Q_in);
+  const ConstTensorView Q = Q_in.stride(3) == 1 ? Q_in : q_copy.view();
+
+  const int B=Q.dim(0), H=Q.dim(1), N=Q.dim(2), D=Q.dim(3);
+  const int Hkv = K.dim(1), Nk = K.dim(2);
+  const fa::tune::TileConfig tiles = block_sparse_tiles(mask, opts, N, Nk, D);
+  const int Br = tiles.block_q;
+  const int Bc = tiles.block_k;
+
+  Tensor O = Tensor::empty({B,H,N,D});
+  const size_t slice = (size_t)N*D;
+  const int nqb = (N + Br - 1) / Br;
+  const int kbh = K.blocks_per_head(), vbh = V.blocks_per_head();
+
+  const simd::MicroKernels& kern = simd::kernels();
+  cpu::ThreadPool& pool = cpu::ThreadPool::instance(opts.num_threads);
+  const int G = heads_per_item(B*Hkv*nqb, H / Hkv, pool.size());
+  const int splits = H / Hkv / G;
+  const int tasks = B*Hkv*splits*nqb;
+  TileScratchSet scratch(pool.size(), G*Br, Bc, D);
+  std::vector<Int8Scratch> qscratch(pool.size(), Int8Scratch(G*Br, Bc, D));
+
+  pool.parallel_for(tasks, [&](int t, int worker) {
+    const int qb = query_block_order(t % nqb, nqb, opts.causal);
+    const int item = t / nqb;
+    const int b = item / (Hkv*splits);
+    const int hk = item / splits % Hkv;
+    const int h0 = (hk*splits + item % splits)*G;
+    const size_t bhk = (size_t)b*Hkv + hk;
+    const int i0 = qb*Br;
+    Int8Tiles src{RowSlice{Q.data() + b*Q.stride(0) + h0*Q.stride(1), (std::ptrdiff_t)Q.stride(2)},
+                  (std::ptrdiff_t)Q.stride(1), G,
+                  K.row(b,hk,0), V.row(b,hk,0),
+                  K.scales.data() + bhk*kbh, V.scales.data() + bhk*vbh,
+                  K.block_rows, V.block_rows, D, kern, qscratch[worker]};
+    forward_query_block(src, key_mask(mask, b, h0, qb), O.data() + ((size_t)b*H + h0)*slice, D,
+                        (std::ptrdiff_t)slice, Nk, D, i0, std::min(Br, N-i0), G, Bc, Nk - N,
+                        opts, kern, scratch[worker]);
+  });
+  merge_stats(opts, scratch, (int64_t)D*sizeof(float), 2*(int64_t)D, (int64_t)D*sizeof(float));
+  return O;
+}
+
+} // namespace fa::detail
@@ -0,0 +1,123 @@
+#include "attention_impl.hpp"
+#include "attention_tile.hpp"
+#include "cpu/thread_pool.hpp"
+#include "fa/autotune.hpp"
+#include "fa/packed_kv.hpp"
+#include "fa/simd.hpp"
+#include <algorithm>
+#include <vector>
+
+// Tiled engine over panel-packed K (same query-block loop as
+// attention_tiled.cpp). Key tiles are a whole number of K panels, so a tile's
+// logits are one qk_panels call over contiguous panels: q[d] is broadcast
+// against a panel row and the panel's keys fill the vector lanes. V rows are
+// read in place with unit D stride (packed rows or the caller's view).
+//
+// Work decomposition, split-K and the combine follow the in-memory engine,
+// so results are bitwise identical for any opts.num_threads; they match
+// attention_forward to rounding (QK^T sums in another order).
+
+namespace fa::detail {
+
+namespace {
+
+struct PanelTiles {
+  RowSlice q_in;             // first query head of the group
+  std::ptrdiff_t q_gs;
+  const float* k_in;         // panels of this (b, K/V head)
+  RowSlice v_in;
+  int D;
+  const simd::MicroKernels& kern;
+  QueryRows q{};
+  const float* kt = nullptr;
+  RowSlice v{};
+
+  void load_queries(int i0, int br) { q = QueryRows{q_in.row(i0), q_in.rs, q_gs, br}; }
+  void load_keys(int j0, int) {
+    kt = k_in + (std::size_t)(j0 / simd::kPanelKeys)*D*simd::kPanelKeys;
+    v = RowSlice{v_in.row(j0), v_in.rs};
+  }
+  void logits(int r, int bc, float* s) { kern.qk_panels(q.row(r), kt, bc, D, s); }
+  void accumulate(int bc, float* p, float* acc) { kern.pv(p, v.row(0), v.rs, bc, D, acc); }
+};
+
+} // namespace
+
+Tensor attention_forward_packed(const ConstTensorView& Q_in, const PackedKV& K, const ConstTensorView& V_in,
+                                const AttentionMask& mask, const AttentionOpts& opts, float* lse)
+{
+  Tensor q_copy, v_copy;
+  const ConstTensorView Q = unit_inner(Q_in, q_copy);
+  const ConstTensorView V = unit_inner(V_in, v_copy);
+
+  const int B=Q.dim(0), H=Q.dim(1), N=Q.dim(2), D=Q.dim(3);
+  const int Hkv = K.dim(1), Nk = K.dim(2);
+  const fa::tune::TileConfig tiles = block_sparse_tiles(mask, opts, N, Nk, D);
+  const int Br = tiles.block_q;
+  // whole panels per key tile (block-sparse layouts are checked to comply)
+  const int Bc = (tiles.block_k + simd::kPanelKeys - 1) / simd::kPanelKeys * simd::kPanelKeys;
+
+  Tensor O = Tensor::empty({B,H,N,D});   // every row is written below
+  const std::size_t slice = (std::size_t)N*D;
+  const int nqb = (N + Br - 1) / Br;
+  const int np = K.panels_per_head();
+
+  const simd::MicroKernels& kern = simd::kernels();
+  cpu::ThreadPool& pool = cpu::ThreadPool::instance(opts.num_threads);
+  const KvSplit kv = kv_split(opts, (long long)B*H*nqb, (Nk + Bc - 1) / Bc);
+  const int S = kv.count;
+  const int G = heads_per_item(B*Hkv*nqb*S, H / Hkv, pool.size());
+  const int splits = H / Hkv / G;
+  const int tasks = B*Hkv*splits*nqb*S;
+  TileScratchSet scratch(pool.size(), G*Br, Bc, D);
+  // chunk c of row (b,h,i): part + ((c*B + b)*H + h)*N*D, lse in plse
+  std::vector<float> part(S > 1 ? (std::size_t)S*B*H*slice : 0), plse(S > 1 ? (std::size_t)S*B*H*N : 0);
+
+  pool.parallel_for(tasks, [&](int t, int worker) {
+    const int c = t % S;
+    const int qb = query_block_order(t / S % nqb, nqb, opts.causal);
+    const int item = t / S / nqb;
+    const int b = item / (Hkv*splits);
+    const int hk = item / splits % Hkv;
+    const int h0 = (hk*splits + item % splits)*G;
+    const int i0 = qb*Br;
+    PanelTiles src{RowSlice{Q.data() + b*Q.stride(0) + h0*Q.stride(1), (std::ptrdiff_t)Q.stride(2)},
+                   (std::ptrdiff_t)Q.stride(1),
+                   K.k.data() + ((std::size_t)b*Hkv + hk)*np*D*simd::kPanelKeys,
+                   RowSlice{V.data() + b*V.stride(0) + hk*V.stride(1), (std::ptrdiff_t)V.stride(2)},
+                   D, kern};
+    KeyMask km = key_mask(mask, b, h0, qb);
+    if (S == 1) {
+      forward_query_block(src, km, O.data() + ((std::size_t)b*H + h0)*slice, D, (std::ptrdiff_t)slice,
+                          Nk, D, i0, std::min(Br, N-i0), G, Bc, Nk - N, opts, kern, scratch[worker],
+                          lse ? lse + ((std::size_t)b*H + h0)*N : nullptr, (std::ptrdiff_t)N);
+      return;
+    }
+    km.j_begin = c*kv.tiles*Bc;
+    km.j_end = km.j_begin + kv.tiles*Bc;
+    const std::size_t head = ((std::size_t)c*B + b)*H + h0;
+    forward_query_block(src, km, part.data() + head*slice, D, (std::ptrdiff_t)slice,
+                        Nk, D, i0, std::min(Br, N-i0), G, Bc, Nk - N, opts, kern, scratch[worker],
+                        plse.data() + head*N, (std::ptrdiff_t)N);
+  });
+
+  if (S > 1) {
+    const std::size_t rows = (std::size_t)B*H*N;
+    pool.parallel_for(B*H*nqb, [&](int t, int worker) {
+      TileScratch& w = scratch[worker];
+      StatsSink* st = stats_sink(opts, w.stats);
+      const int i0 = t % nqb * Br;
+      for (int i = i0; i < std::min(N, i0 + Br); ++i) {
+        const std::size_t row = (std::size_t)t / nqb * N + i;
+        if (!combine_kv_splits(part.data() + row*D, (std::ptrdiff_t)(rows*D), plse.data() + row,
+                               (std::ptrdiff_t)rows, S, D, kern, w.acc, O.data() + row*D,
+                               lse ? lse + row : nullptr) && st)
+          ++st->rows_fully_masked;
+      }
+    });
+  }
+  merge_stats(opts, scratch, (int64_t)D*sizeof(float), 2*(int64_t)D*sizeof(float), (int64_t)D*sizeof(float));
+  return O;
+}
+
+} // namespace fa::detail
@@ -1,85 +1,107 @@
-#include "fa/attention.hpp"
+#include "attention_impl.hpp"
+#include "attention_stats.hpp"
 #include "fa/math.hpp"
 #include "fa/mask.hpp"
+#include "fa/random.hpp"
 #include "fa/tensor.hpp"
 #include <stdexcept>
 #include <vector>
 #include <cmath>
 #include <algorithm>
 
-namespace fa {
+namespace fa::detail {
 
-static void validate_core(const Tensor& Q, const Tensor& K, const Tensor& V) {
-  if (Q.ndim()!=4 || K.ndim()!=4 || V.ndim()!=4)
-    throw std::invalid_argument("attention_forward: Q,K,V must be 4D (B,H,N,D)");
-  if (Q.dim(0)!=K.dim(0) || Q.dim(0)!=V.dim(0)) throw std::invalid_argument("B mismatch");
-  if (Q.dim(1)!=K.dim(1) || Q.dim(1)!=V.dim(1)) throw std::invalid_argument("H mismatch");
-  if (Q.dim(2)!=K.dim(2) || Q.dim(2)!=V.dim(2)) throw std::invalid_argument("N mismatch");
-  if (Q.dim(3)!=K.dim(3) || Q.dim(3)!=V.dim(3)) throw std::invalid_argument("D mismatch");
-}
-
-Tensor attention_forward(const Tensor& Q,
-                         const Tensor& K,
-                         const Tensor& V,
-                         const Tensor* mask,
-                         const AttentionOpts& opts)
+Tensor attention_forward_ref(const ConstTensorView& Q,
+                             const ConstTensorView& K,
+                             const ConstTensorView& V,
+                             const AttentionMask& mask,
+                             const AttentionOpts& opts,
+                             float* lse)
 {
-  if (std::isnan(opts.dropout_prob) || opts.dropout_prob < 0.0f || opts.dropout_prob > 1.0f)
-    throw std::invalid_argument("attention_forward: dropout_prob must be between 0 and 1 and not NaN");
-
-
-  validate_core(Q,K,V);
   const int B=Q.dim(0), H=Q.dim(1), N=Q.dim(2), D=Q.dim(3);
-  if (mask) fa::mask::validate_padding_mask_b11n(Q, *mask);
+  const int Nk = K.dim(2);
+  const int off = Nk - N;       // bottom-right alignment: query i sits at key position i + off
+  const int G = H / K.dim(1);   // query heads per K/V head
+  const float ninf = fa::math::neg_inf();
+  const bool drop = opts.dropout_prob > 0.0f;
+  const fa::rnd::DropoutRng dropout(opts.dropout_seed, opts.dropout_prob);
 
     Tensor O = Tensor::zeros({B,H,N,D});
-    std::vector<float> logits(N);
+    if (lse) std::fill(lse, lse + (size_t)B*H*N, ninf);   // stays -inf for all-masked rows
+    std::vector<float> logits(Nk);
+    StatsSink sink;
+    StatsSink* st = stats_sink(opts, sink);
 
     for (int b=0;b<B;++b) {
       for (int h=0; h<H; ++h) {
         for (int i=0;i<N;++i) {
 
+          // CAUSAL: keys j > i+off, WINDOW: keys |i+off-j| >= window are never touched
+          const int p = i + off;
+          int lo = 0, hi = Nk;
+          if (opts.causal) hi = std::max(0, p + 1);
+          if (opts.window > 0) {
+            lo = std::max(0, p - opts.window + 1);
+            hi = std::max(lo, std::min(hi, p + opts.window));
+          }
+
+          int64_t t = stats_clock(st);
+          if (st) {
+            sink.q_rows += 1;
+            sink.o_rows += 1;
+            sink.kv_rows += std::max(0, hi - lo);
+          }
+
           // logits[j] = Q[i]·K[j]
-          for (int j=0;j<N;++j) {
+          for (int j=lo;j<hi;++j) {
             float s = 0.0f;
-            for (int d=0; d<D; ++d) s += Q.at(b,h,i,d)*K.at(b,h,j,d);
+            for (int d=0; d<D; ++d) s += Q.at(b,h,i,d)*K.at(b,h/G,j,d);
             logits[j] = s;
           }
 
-        // CAUSAL: j > i → -inf
-        if (opts.causal) {
-          const float ninf = fa::math::neg_inf();
-          for (int j=i+1; j<N; ++j) logits[j] = ninf;
-        }
-		
 		float temp = opts.temperature;
-        if (temp <= 0.0f)
-            throw std::invalid_argument("attention_forward: temperature must be positive");
-        
         if (temp != 1.0f) {
-            for (int j = 0; j < N; ++j)
+            for (int j = lo; j < hi; ++j)
                 logits[j] /= temp;
         }
+        stats_lap(st, kPhaseQK, t);
 
-        // PADDING: apply mask (non-zero=keep, zero=masked)
-        if (mask) fa::mask::apply_padding_mask_logits(logits, *mask, b, N);
+        // PADDING: packed keep bits; BLOCK-SPARSE: inactive (i,j) tiles
+        if (mask.padding) fa::apply_logits_mask_inplace(logits.data(), Nk, *mask.padding, b);
+        if (mask.blocks) {
+          const int qb = i / mask.blocks->block_q();
+          for (int j=lo;j<hi;++j)
+            if (!mask.blocks->active(qb, j / mask.blocks->block_k())) logits[j] = ninf;
+        }
+        stats_lap(st, kPhaseMask, t);
 
-        // stable softmax
-        float m = fa::math::row_max(logits.data(), N);
+        // stable softmax over the visible span
+        const float* row = logits.data() + lo;
+        const int span = hi - lo;
+        float m = span > 0 ? fa::math::row_max(row, span) : ninf;
         bool all_masked = std::isinf(m) && m < 0.0f;
-        float denom = all_masked ? 0.0f : fa::math::row_sumexp_stable(logits.data(), N, m);
-        if (denom <= 0.0f) continue; // leave zeros (all masked)
+        float denom = all_masked ? 0.0f : fa::math::row_sumexp_stable(row, span, m);
+        stats_lap(st, kPhaseSoftmax, t);
+        if (denom <= 0.0f) { // leave zeros (all masked)
+          if (st) ++sink.rows_fully_masked;
+          continue;
+        }
+        if (lse) lse[((size_t)b*H + h)*N + i] = m + std::log(denom);
 
-          for (int j=0;j<N;++j) {
+          for (int j=lo;j<hi;++j) {
             float w = std::exp(std::min(80.0f, logits[j]-m)) / denom;
+            // DROPOUT: same (seed, b, h, i, j) draw as the tiled engines
+            if (drop) w = dropout.keep(b,h,p,j) ? w*dropout.scale() : 0.0f;
             if (w==0.0f) continue;
             for (int d=0; d<D; ++d)
-              O.at(b,h,i,d) += w * V.at(b,h,j,d);
+              O.at(b,h,i,d) += w * V.at(b,h/G,j,d);
           }
+          stats_lap(st, kPhasePV, t);
         }
       }
     }
+    merge_stats(opts, sink, (int64_t)D*sizeof(float), 2*(int64_t)D*sizeof(float), (int64_t)D*sizeof(float));
     return O;
 }
 
-} // namespace fa
+} // namespace fa::detail
@@ -0,0 +1,135 @@
+#pragma once
+// Per-worker instrumentation sink for the attention engines (fa/stats.hpp).
+// Engines ask stats_sink() for a pointer once per work item and pass it to
+// the helpers below; it is null unless the caller set opts.stats, and with
+// FA_STATS off every helper is an empty inline function, so the engines
+// compile to the uninstrumented code.
+#include "fa/stats.hpp"
+#include "fa/types.hpp"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#ifndef FA_STATS
+#define FA_STATS 0
+#endif
+
+namespace fa::detail {
+
+enum Phase { kPhaseQK, kPhaseMask, kPhaseSoftmax, kPhasePV, kPhases };
+
+struct StatsSink {
+  int64_t ns[kPhases] = {};
+  int64_t tiles_visited = 0, tiles_skipped = 0, rows_fully_masked = 0;
+  int64_t q_rows = 0, kv_rows = 0, o_rows = 0;   // bytes are applied at merge
+  std::vector<TraceEvent> trace;                 // worker is set at merge
+};
+
+inline StatsSink* stats_sink([[maybe_unused]] const AttentionOpts& opts, [[maybe_unused]] StatsSink& s) {
+#if FA_STATS
+  return opts.stats ? &s : nullptr;
+#else
+  return nullptr;
+#endif
+}
+
+inline int64_t stats_clock([[maybe_unused]] const StatsSink* st) {
+#if FA_STATS
+  if (st)
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  return 0;
+}
+
+// Charges the time since t to phase p and restarts t.
+inline void stats_lap([[maybe_unused]] StatsSink* st, [[maybe_unused]] Phase p,
+                      [[maybe_unused]] int64_t& t) {
+#if FA_STATS
+  if (!st) return;
+  const int64_t now = stats_clock(st);
+  st->ns[p] += now - t;
+  t = now;
+#endif
+}
+
+// A finished work item: key tiles visited / skipped out of its grid, rows
+// in and out, fully masked rows, and its trace span if one was asked for.
+inline void stats_item([[maybe_unused]] StatsSink* st, [[maybe_unused]] const AttentionOpts& opts,
+                       [[maybe_unused]] int visited, [[maybe_unused]] int grid_tiles,
+                       [[maybe_unused]] int64_t kv_rows, [[maybe_unused]] int rows,
+                       [[maybe_unused]] int masked_rows, [[maybe_unused]] int b,
+                       [[maybe_unused]] int h, [[maybe_unused]] int row,
+                       [[maybe_unused]] int64_t start) {
+#if FA_STATS
+  if (!st) return;
+  st->tiles_visited += visited;
+  st->tiles_skipped += grid_tiles - visited;
+  st->kv_rows += kv_rows;
+  st->q_rows += rows;
+  st->o_rows += rows;
+  st->rows_fully_masked += masked_rows;
+  if (opts.stats->record_trace)
+    st->trace.push_back(TraceEvent{0, b, h, row, start, stats_clock(st) - start});
+#endif
+}
+
+// into += from, for engines that keep several sinks per worker.
+inline void fold_stats([[maybe_unused]] StatsSink& into, [[maybe_unused]] const StatsSink& from) {
+#if FA_STATS
+  for (int p=0; p<kPhases; ++p) into.ns[p] += from.ns[p];
+  into.tiles_visited += from.tiles_visited;
+  into.tiles_skipped += from.tiles_skipped;
+  into.rows_fully_masked += from.rows_fully_masked;
+  into.q_rows += from.q_rows;
+  into.kv_rows += from.kv_rows;
+  into.o_rows += from.o_rows;
+  into.trace.insert(into.trace.end(), from.trace.begin(), from.trace.end());
+#endif
+}
+
+#if FA_STATS
+inline void add_sink(AttentionStats* out, const StatsSink& s, int worker,
+                     int64_t q_row_bytes, int64_t kv_row_bytes, int64_t o_row_bytes) {
+  out->qk_ns += s.ns[kPhaseQK];
+  out->mask_ns += s.ns[kPhaseMask];
+  out->softmax_ns += s.ns[kPhaseSoftmax];
+  out->pv_ns += s.ns[kPhasePV];
+  out->tiles_visited += s.tiles_visited;
+  out->tiles_skipped += s.tiles_skipped;
+  out->rows_fully_masked += s.rows_fully_masked;
+  out->bytes_read += s.q_rows*q_row_bytes + s.kv_rows*kv_row_bytes;
+  out->bytes_written += s.o_rows*o_row_bytes;
+  for (TraceEvent e : s.trace) {
+    e.worker = worker;
+    out->trace.push_back(e);
+  }
+}
+#endif
+
+// Adds one call's per-worker sinks (index = worker) into opts.stats. Row
+// sizes in bytes turn the row counts into traffic.
+template <class Workers>
+void merge_stats([[maybe_unused]] const AttentionOpts& opts, [[maybe_unused]] const Workers& workers,
+                 [[maybe_unused]] int64_t q_row_bytes, [[maybe_unused]] int64_t kv_row_bytes,
+                 [[maybe_unused]] int64_t o_row_bytes) {
+#if FA_STATS
+  if (!opts.stats) return;
+  ++opts.stats->calls;
+  for (int w=0; w<(int)workers.size(); ++w)
+    add_sink(opts.stats, workers[w].stats, w, q_row_bytes, kv_row_bytes, o_row_bytes);
+#endif
+}
+
+// Same for a serial engine with a single sink.
+inline void merge_stats([[maybe_unused]] const AttentionOpts& opts, [[maybe_unused]] const StatsSink& sink,
+                        [[maybe_unused]] int64_t q_row_bytes, [[maybe_unused]] int64_t kv_row_bytes,
+                        [[maybe_unused]] int64_t o_row_bytes) {
+#if FA_STATS
+  if (!opts.stats) return;
+  ++opts.stats->calls;
+  add_sink(opts.stats, sink, 0, q_row_bytes, kv_row_bytes, o_row_bytes);
+#endif
+}
+
+} // namespace fa::detail
@@ -0,0 +1,161 @@
+#include "attention_impl.hpp"
+#include "attention_tile.hpp"
+#include "cpu/thread_pool.hpp"
+#include "fa/autotune.hpp"
+#include "fa/kv_stream.hpp"
+#include "fa/math.hpp"
+#include "fa/simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <vector>
+
+// Out-of-core forward pass: K/V come from a KVSource in blocks of R keys (a
+// whole number of key tiles) and are never resident at once. Each block is
+// run like the key chunks of split-K: every query block leaves the block's
+// normalized rows and log-sum-exp in a partial slot, and combine_kv_splits
+// folds the slots into the running rows and lse of slot 0. That is the
+// online-softmax recurrence at block granularity, so the state is O(B*H*N_q*D)
+// plus two K/V block buffers, whatever N_kv is.
+//
+// While the pool computes block c, block c+1 is read into the other buffer
+// on a std::async thread, so I/O, page faults or decompression in the source
+// overlap the compute. Blocks that no query can see (opts.window) are never
+// read. A long block with few query blocks is cut into kv_split chunks, as
+// in the in-memory engine, so one query row still spreads over the cores.
+//
+// Work items and the combine order depend only on the shapes, R and the
+// machine, never on opts.num_threads: results are bitwise identical for any
+// thread count, and agree with attention_forward to rounding.
+
+namespace fa::detail {
+
+namespace {
+
+constexpr int kStreamBlockKeys = 4096;   // default R
+
+// Tiles over one K/V block buffer: rows of (b, K/V head) are contiguous and
+// row r is key jb + r.
+struct BlockTiles {
+  RowSlice q_in;              // first query head of the group
+  std::ptrdiff_t q_gs;
+  const float* k_in;
+  const float* v_in;
+  int jb, D;
+  const simd::MicroKernels& kern;
+  QueryRows q{};
+  const float* k = nullptr;
+  const float* v = nullptr;
+
+  void load_queries(int i0, int br) { q = QueryRows{q_in.row(i0), q_in.rs, q_gs, br}; }
+  void load_keys(int j0, int) {
+    k = k_in + (std::size_t)(j0 - jb)*D;
+    v = v_in + (std::size_t)(j0 - jb)*D;
+  }
+  void logits(int r, int bc, float* s) { kern.qk(q.row(r), k, D, bc, D, s); }
+  void accumulate(int bc, float* p, float* acc) { kern.pv(p, v, D, bc, D, acc); }
+};
+
+} // namespace
+
+Tensor attention_forward_stream(const ConstTensorView& Q_in, KVSource& source, const AttentionMask& mask,
+                                const AttentionOpts& opts, int block_keys, float* lse)
+{
+  Tensor q_copy;
+  const ConstTensorView Q = unit_inner(Q_in, q_copy);
+  const int B=Q.dim(0), H=Q.dim(1), N=Q.dim(2), D=Q.dim(3);
+  const int Hkv = source.heads(), Nk = source.length();
+  const float ninf = fa::math::neg_inf();
+
+  const fa::tune::TileConfig tiles = block_sparse_tiles(mask, opts, N, Nk, D);
+  const int Br = tiles.block_q, Bc = tiles.block_k;
+  const int R = (std::max(block_keys > 0 ? block_keys : kStreamBlockKeys, Bc) + Bc - 1) / Bc * Bc;
+  const int nqb = (N + Br - 1) / Br;
+
+  const simd::MicroKernels& kern = simd::kernels();
+  cpu::ThreadPool& pool = cpu::ThreadPool::instance(opts.num_threads);
+  const KvSplit kv = kv_split(opts, (long long)B*H*nqb, std::min(R, Nk + Bc - 1) / Bc);
+  const int S = kv.count;
+  const int G = heads_per_item(B*Hkv*nqb*S, H / Hkv, pool.size());
+  const int splits = H / Hkv / G;
+  const int tasks = B*Hkv*splits*nqb*S;
+  TileScratchSet scratch(pool.size(), G*Br, Bc, D);
+
+  // Slot 0 holds the running rows (b,h,i) at part + ((b*H + h)*N + i)*D and
+  // their lse in plse; slot 1 + c the current block's chunk c, likewise.
+  const std::size_t slice = (std::size_t)N*D, rows = (std::size_t)B*H*N;
+  std::vector<float> part((S + 1)*rows*D, 0.0f), plse((S + 1)*rows, ninf);
+
+  // Query 0 sits at key Nk - N; with a window nothing before its band is seen.
+  const int first_key = opts.window > 0 ? std::max(0, Nk - N - opts.window + 1) : 0;
+  const int first = N > 0 ? first_key / R : 0;
+  const int last = N > 0 ? (Nk + R - 1) / R : 0;
+
+  // K then V of a block, each (B, H_kv, n, D).
+  std::vector<float> buf[2];
+  if (last > first) {
+    const std::size_t floats = 2*(std::size_t)B*Hkv*std::min(R, Nk)*D;
+    buf[0].resize(floats);
+    if (last - first > 1) buf[1].resize(floats);
+  }
+  auto fetch = [&](int blk) {
+    const int j0 = blk*R, n = std::min(R, Nk - j0);
+    float* k = buf[(blk - first) & 1].data();
+    float* v = k + (std::size_t)B*Hkv*n*D;
+    return std::async(std::launch::async, [&source, j0, n, k, v] { source.read(j0, n, k, v); });
+  };
+
+  std::future<void> next;
+  if (last > first) next = fetch(first);
+  for (int blk = first; blk < last; ++blk) {
+    next.get();
+    if (blk + 1 < last) next = fetch(blk + 1);
+    const int j0 = blk*R, n = std::min(R, Nk - j0);
+    const float* kb = buf[(blk - first) & 1].data();
+    const float* vb = kb + (std::size_t)B*Hkv*n*D;
+
+    pool.parallel_for(tasks, [&](int t, int worker) {
+      const int c = t % S;
+      const int qb = query_block_order(t / S % nqb, nqb, opts.causal);
+      const int item = t / S / nqb;
+      const int b = item / (Hkv*splits);
+      const int hk = item / splits % Hkv;
+      const int h0 = (hk*splits + item % splits)*G;
+      const int i0 = qb*Br;
+      const std::size_t kv_head = ((std::size_t)b*Hkv + hk)*n*D;
+      BlockTiles bt{RowSlice{Q.data() + b*Q.stride(0) + h0*Q.stride(1), (std::ptrdiff_t)Q.stride(2)},
+                    (std::ptrdiff_t)Q.stride(1), kb + kv_head, vb + kv_head, j0, D, kern};
+      KeyMask km = key_mask(mask, b, h0, qb);
+      km.j_begin = j0 + c*kv.tiles*Bc;
+      km.j_end = std::min(km.j_begin + kv.tiles*Bc, j0 + n);
+      const std::size_t head = ((std::size_t)(c + 1)*B + b)*H + h0;
+      forward_query_block(bt, km, part.data() + head*slice, D, (std::ptrdiff_t)slice,
+                          Nk, D, i0, std::min(Br, N-i0), G, Bc, Nk - N, opts, kern, scratch[worker],
+                          plse.data() + head*N, (std::ptrdiff_t)N);
+    });
+
+    pool.parallel_for(B*H*nqb, [&](int t, int worker) {
+      const int i0 = t % nqb * Br;
+      for (int i = i0; i < std::min(N, i0 + Br); ++i) {
+        const std::size_t row = (std::size_t)t / nqb * N + i;
+        combine_kv_splits(part.data() + row*D, (std::ptrdiff_t)(rows*D), plse.data() + row,
+                          (std::ptrdiff_t)rows, S + 1, D, kern, scratch[worker].acc,
+                          part.data() + row*D, plse.data() + row);
+      }
+    });
+  }
+
+  // A single block of a single chunk is a whole pass and forward_query_block
+  // has counted its masked rows already.
+  if (StatsSink* st = stats_sink(opts, scratch[0].stats); st && !(last - first == 1 && S == 1 && first == 0)) {
+    for (std::size_t r = 0; r < rows; ++r) if (std::isinf(plse[r])) ++st->rows_fully_masked;
+  }
+  merge_stats(opts, scratch, (int64_t)D*sizeof(float), 2*(int64_t)D*sizeof(float), (int64_t)D*sizeof(float));
+
+  Tensor O = Tensor::empty({B,H,N,D});
+  std::copy(part.begin(), part.begin() + rows*D, O.data());
+  if (lse) std::copy(plse.begin(), plse.begin() + rows, lse);
+  return O;
+}
+
+} // namespace fa::detail
@@ -0,0 +1,407 @@
+#pragma once
+// Online-softmax query-block loop shared by the tiled engines (see the notes
+// at the top of attention_tiled.cpp). The loop owns masking and the softmax
+// state; where Q/K/V come from, and how a tile's logits and PV product are
+// formed, is up to a Tiles policy:
+//
+//   void load_queries(int i0, int br);            // query rows [i0, i0+br)
+//   void load_keys(int j0, int bc);               // key/value rows [j0, j0+bc)
+//   void logits(int r, int bc, float* s);         // s[c] = q[r] . k[j0+c]
+//   void accumulate(int bc, float* p, float* acc); // acc += sum_c p[c] v[j0+c]
+//
+// accumulate may overwrite p. A block can span a group of query heads that
+// share one K/V head (GQA/MQA): block row r is then query i0 + r % br of the
+// group's head r / br, so every loaded K/V tile serves group*br rows.
+#include "attention_stats.hpp"
+#include "cpu/thread_pool.hpp"
+#include "fa/autotune.hpp"
+#include "fa/mask.hpp"
+#include "fa/math.hpp"
+#include "fa/random.hpp"
+#include "fa/simd.hpp"
+#include "fa/tensor.hpp"
+#include "fa/types.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace fa::detail {
+
+// Buffers of one worker, sized for Br x (query heads per block) rows.
+// Non-owning: carved out of a TileScratchSet arena.
+struct TileScratch {
+  float* s = nullptr;      // rows x Bc logits, overwritten with probabilities
+  float* acc = nullptr;    // rows x D unnormalized output
+  float* m = nullptr;      // running row max
+  float* l = nullptr;      // running row denominator
+  int* span_a = nullptr;   // visible [a, n) of each row in the current tile
+  int* span_n = nullptr;
+  StatsSink stats;
+
+  // Arena bytes for one worker; every buffer starts on a 64-byte boundary.
+  static std::size_t bytes(int rows, int bc, int d) {
+    return pad((size_t)rows*bc*sizeof(float)) + pad((size_t)rows*d*sizeof(float)) +
+           2*pad((size_t)rows*sizeof(float)) + 2*pad((size_t)rows*sizeof(int));
+  }
+
+  char* carve(char* p, int rows, int bc, int d) {
+    s = take<float>(p, (size_t)rows*bc);
+    acc = take<float>(p, (size_t)rows*d);
+    m = take<float>(p, rows);
+    l = take<float>(p, rows);
+    span_a = take<int>(p, rows);
+    span_n = take<int>(p, rows);
+    return p;
+  }
+
+private:
+  static std::size_t pad(std::size_t n) { return (n + 63) / 64 * 64; }
+  template <class T>
+  static T* take(char*& p, std::size_t n) {
+    T* r = reinterpret_cast<T*>(p);
+    p += pad(n*sizeof(T));
+    return r;
+  }
+};
+
+// One TileScratch per worker over a single arena, either owned (sized at
+// construction) or borrowed from an AttentionWorkspace through reset().
+// Re-carving a borrowed arena for the same or fewer workers allocates
+// nothing.
+class TileScratchSet {
+public:
+  TileScratchSet() = default;
+  TileScratchSet(int workers, int rows, int bc, int d)
+    : own_(workers*TileScratch::bytes(rows, bc, d) + 64) {
+    char* p = own_.data();
+    p += (64 - reinterpret_cast<std::uintptr_t>(p) % 64) % 64;
+    reset(p, workers, rows, bc, d);
+  }
+  TileScratchSet(TileScratchSet&&) = default;
+  TileScratchSet& operator=(TileScratchSet&&) = default;
+
+  // arena holds workers*TileScratch::bytes(rows, bc, d) bytes, 64-aligned.
+  void reset(char* arena, int workers, int rows, int bc, int d) {
+    views_.resize(workers);
+    for (TileScratch& w : views_) {
+      w.stats = StatsSink{};
+      arena = w.carve(arena, rows, bc, d);
+    }
+  }
+
+  int size() const { return (int)views_.size(); }
+  TileScratch& operator[](int w) { return views_[w]; }
+  const TileScratch& operator[](int w) const { return views_[w]; }
+
+private:
+  std::vector<char> own_;
+  std::vector<TileScratch> views_;
+};
+
+// Row-major (N,D) slice of one (b,h): rows are `rs` elements apart and the
+// D elements of a row are contiguous.
+template <class T>
+struct RowSliceT {
+  const T* p;
+  std::ptrdiff_t rs;
+  const T* row(int i) const { return p + (std::ptrdiff_t)i*rs; }
+};
+using RowSlice = RowSliceT<float>;
+
+// fp32 query rows of a block spanning a group of heads: row r is row r % br
+// of head r / br, heads `gs` elements apart.
+struct QueryRows {
+  const float* p;
+  std::ptrdiff_t rs, gs;
+  int br;
+  const float* row(int r) const { return p + (std::ptrdiff_t)(r / br)*gs + (std::ptrdiff_t)(r % br)*rs; }
+};
+
+inline void store_row(const simd::MicroKernels&, const float* x, float* y, int n) { std::copy(x, x + n, y); }
+inline void store_row(const simd::MicroKernels& kern, const float* x, bf16* y, int n) { kern.f32_to_bf16(x, y, n); }
+inline void store_row(const simd::MicroKernels& kern, const float* x, fp16* y, int n) { kern.f32_to_f16(x, y, n); }
+
+// Views whose D stride is not 1 are packed once so the micro-kernels can
+// read rows directly; the common (B,N,H,D)->(B,H,N,D) transpose needs no copy.
+template <class T>
+TensorViewT<const T> unit_inner(const TensorViewT<const T>& X, TensorT<T>& storage) {
+  if (X.stride(3) == 1) return X;
+  storage = TensorT<T>::from(X);
+  return storage.view();
+}
+
+// Query block handled by work item k of one (b,h) with nqb blocks. Causal
+// block qb costs ~qb+1 key tiles, so blocks go out heaviest and lightest in
+// alternation (nqb-1, 0, nqb-2, 1, ...): consecutive pairs cost the same, the
+// pool's equal contiguous task ranges carry equal work, and what is left to
+// steal at the end of a range is the middle of the triangle.
+inline int query_block_order(int k, int nqb, bool causal) {
+  if (!causal) return k;
+  return (k & 1) ? k / 2 : nqb - 1 - k / 2;
+}
+
+// Key visibility for one (b, query block) on top of opts.causal / window:
+// the packed padding row of batch entry b, and the active key tiles of this
+// query block from a block-sparse layout (tile t is keys [t*Bc, t*Bc+Bc),
+// ascending). Null means every key / every tile. b and h (the block's first
+// query head) also select the dropout stream. [j_begin, j_end) restricts the
+// block to one split-K chunk of keys (both on the Bc grid).
+struct KeyMask {
+  const PaddingBitmask* padding = nullptr;
+  int b = 0;
+  const int* tiles_begin = nullptr;
+  const int* tiles_end = nullptr;
+  int h = 0;
+  int j_begin = 0;
+  int j_end = std::numeric_limits<int>::max();
+};
+
+// A block-sparse layout fixes the tile grid; otherwise opts / autotune decide.
+inline fa::tune::TileConfig block_sparse_tiles(const AttentionMask& mask, const AttentionOpts& opts,
+                                               int Nq, int Nk, int D) {
+  if (mask.blocks) return fa::tune::TileConfig{mask.blocks->block_q(), mask.blocks->block_k()};
+  return fa::tune::resolve_tiles(opts, Nq, Nk, D);
+}
+
+// Query heads per work item. A whole group shares each K/V tile, but while
+// there are fewer work items than workers the group is halved so decode-sized
+// problems (one query block per head) still spread over the pool. Rows are
+// independent, so the split does not change any result.
+inline int heads_per_item(int items, int group, int workers) {
+  int g = group;
+  while (g % 2 == 0 && (long long)items*(group / g) < workers) g /= 2;
+  return g;
+}
+
+inline KeyMask key_mask(const AttentionMask& mask, int b, int h0, int qb) {
+  KeyMask k{mask.padding, b};
+  k.h = h0;
+  if (mask.blocks) {
+    k.tiles_begin = mask.blocks->begin(qb);
+    k.tiles_end = mask.blocks->end(qb);
+  }
+  return k;
+}
+
+// o is the output slice of the block's first head, row i at o + i*o_rs and
+// the group's heads o_gs apart. Queries [i0, i0+br) of each of the `group`
+// heads attend over keys [0, Nk); with opts.causal, query i sees keys
+// j <= i + causal_offset (0 for self-attention, cached_len - T when T new
+// queries follow a cached prefix), and opts.window limits it to the band
+// |i + causal_offset - j| < window.
+//
+// Work is skipped at tile granularity: tiles outside the band of the block
+// are never visited, block-sparse tiles not in the list are never visited,
+// and tiles whose keys are all padding are never loaded. Inside a visited
+// tile each row only computes its visible span.
+//
+// With opts.dropout_prob > 0, each tile's probabilities are dropped after the
+// row denominator has been updated, so l keeps the full softmax sum and only
+// the PV product sees the (rescaled) survivors.
+//
+// If lse is set it receives m + log(l) per row (-inf for rows with no visible
+// key), laid out like o with rows 1 apart and heads lse_gs apart.
+template <class Tiles, class OutT>
+void forward_query_block(Tiles& tiles, const KeyMask& mask,
+                         OutT* o, std::ptrdiff_t o_rs, std::ptrdiff_t o_gs,
+                         int Nk, int D, int i0, int br, int group, int Bc, int causal_offset,
+                         const AttentionOpts& opts, const simd::MicroKernels& kern,
+                         TileScratch& ws, float* lse = nullptr, std::ptrdiff_t lse_gs = 0)
+{
+  const float ninf = fa::math::neg_inf();
+  const float temp = opts.temperature;
+  const int W = opts.window;
+  const bool drop = opts.dropout_prob > 0.0f;
+  const fa::rnd::DropoutRng dropout(opts.dropout_seed, opts.dropout_prob);
+  StatsSink* st = stats_sink(opts, ws.stats);
+  const int64_t t_item = stats_clock(st);
+  float* acc = ws.acc;
+  float* m = ws.m;
+  float* l = ws.l;
+
+  const int rows = br*group;
+  std::fill(acc, acc + (size_t)rows*D, 0.0f);
+  std::fill(m, m + rows, ninf);
+  std::fill(l, l + rows, 0.0f);
+
+  tiles.load_queries(i0, br);
+
+  // Visible keys of query i (already shifted by causal_offset): [lo(i), hi(i)).
+  auto lo = [&](int i) { return W > 0 ? std::max(0, i - W + 1) : 0; };
+  auto hi = [&](int i) {
+    int h = Nk;
+    if (opts.causal) h = std::min(h, i + 1);
+    if (W > 0) h = std::min(h, i + W);
+    return h;
+  };
+  const int k_lo = std::max(lo(i0 + causal_offset), mask.j_begin);
+  const int k_hi = std::min(hi(i0 + br - 1 + causal_offset), mask.j_end);
+
+  // Each visited tile runs in four phases over all rows of the block (QK,
+  // masking, online softmax, PV); per row the arithmetic is the same as one
+  // row at a time, and the phase boundaries are where stats are timed.
+  int* span_a = ws.span_a;
+  int* span_n = ws.span_n;
+  int visited = 0;
+  int64_t kv_rows = 0;
+  auto visit = [&](int j0) {
+    const int bc = std::min(Bc, k_hi - j0);
+    int kept = bc;
+    if (mask.padding) {
+      kept = mask.padding->count(mask.b, j0, bc);
+      if (kept == 0) return;                  // all padding: never loaded
+    }
+    int64_t t = stats_clock(st);
+    tiles.load_keys(j0, bc);
+    ++visited;
+    kv_rows += bc;
+
+    // s[c] = Q[i]·K[j0+c] / temperature over the row's span [a, n); rows
+    // whose span misses the tile get n <= a and are skipped from here on
+    for (int r=0; r<rows; ++r) {
+      const int i = i0 + r % br + causal_offset;
+      span_a[r] = std::max(0, lo(i) - j0);
+      span_n[r] = std::min(bc, hi(i) - j0);
+      if (span_n[r] <= span_a[r]) continue;
+      float* s = ws.s + (size_t)r*Bc;
+      tiles.logits(r, span_n[r], s);
+      if (temp != 1.0f) {
+        for (int c=span_a[r]; c<span_n[r]; ++c) s[c] /= temp;
+      }
+    }
+    stats_lap(st, kPhaseQK, t);
+
+    // keys before the span and padded keys become -inf
+    for (int r=0; r<rows; ++r) {
+      const int a = span_a[r], n = span_n[r];
+      if (n <= a) continue;
+      float* s = ws.s + (size_t)r*Bc;
+      std::fill(s, s + a, ninf);
+      if (kept < bc) {
+        for (int c=a; c<n; ++c) if (!mask.padding->keep(mask.b, j0 + c)) s[c] = ninf;
+      }
+    }
+    stats_lap(st, kPhaseMask, t);
+
+    for (int r=0; r<rows; ++r) {
+      const int a = span_a[r], n = span_n[r];
+      if (n <= a) continue;
+      float* s = ws.s + (size_t)r*Bc;
+      const float m_new = std::max(m[r], kern.max(s, n));
+      if (std::isinf(m_new) && m_new < 0.0f) { // nothing visible yet
+        span_n[r] = a;
+        continue;
+      }
+
+      // rescale what we have so far to the new max
+      const float alpha = fa::math::fast_exp(m[r] - m_new);
+      if (alpha != 1.0f) kern.scale(alpha, acc + (size_t)r*D, D);
+
+      const float lsum = kern.exp_sum(s, n, m_new);   // s becomes probabilities
+      l[r] = l[r]*alpha + lsum;
+      m[r] = m_new;
+      if (drop) dropout.apply(mask.b, mask.h + r / br, i0 + r % br + causal_offset, j0 + a, n - a, s + a);
+    }
+    stats_lap(st, kPhaseSoftmax, t);
+
+    for (int r=0; r<rows; ++r) {
+      if (span_n[r] <= span_a[r]) continue;
+      tiles.accumulate(span_n[r], ws.s + (size_t)r*Bc, acc + (size_t)r*D);
+    }
+    stats_lap(st, kPhasePV, t);
+  };
+
+  // Tiles sit on the Bc grid (block-sparse layouts and cache pages rely on it).
+  if (mask.tiles_begin) {
+    for (const int* t = mask.tiles_begin; t != mask.tiles_end; ++t) {
+      const int j0 = *t * Bc;
+      if (j0 + Bc > k_lo && j0 < k_hi) visit(j0);
+    }
+  } else {
+    for (int j0 = k_lo / Bc * Bc; j0 < k_hi; j0 += Bc) visit(j0);
+  }
+
+  // normalize; rows that never saw a visible key stay zero
+  int masked_rows = 0;
+  for (int r=0; r<rows; ++r) {
+    OutT* o_r = o + (std::ptrdiff_t)(r / br)*o_gs + (std::ptrdiff_t)(i0 + r % br)*o_rs;
+    float* acc_r = acc + (size_t)r*D;
+    if (lse) lse[(std::ptrdiff_t)(r / br)*lse_gs + i0 + r % br] = l[r] > 0.0f ? m[r] + std::log(l[r]) : ninf;
+    if (l[r] <= 0.0f) {
+      std::fill(o_r, o_r + D, OutT{});
+      ++masked_rows;
+      continue;
+    }
+    kern.scale(1.0f / l[r], acc_r, D);
+    store_row(kern, acc_r, o_r, D);
+  }
+  // a split-K chunk's rows are only fully masked if every chunk says so;
+  // combine_kv_splits counts those
+  const int grid_lo = mask.j_begin / Bc;
+  const int grid_hi = (std::min(Nk, mask.j_end) + Bc - 1) / Bc;
+  const bool chunk = grid_lo > 0 || grid_hi < (Nk + Bc - 1) / Bc;
+  stats_item(st, opts, visited, std::max(0, grid_hi - grid_lo), kv_rows, rows, chunk ? 0 : masked_rows,
+             mask.b, mask.h, i0, t_item);
+}
+
+// Split-K (flash-decoding). While there are fewer (b, head, query block)
+// items than cores, most cores would idle through a long key loop, so the
+// key axis is cut into `count` chunks of `tiles` whole tiles that run as
+// separate work items. Each chunk writes its own normalized output rows and
+// log-sum-exp; combine_kv_splits merges them. The automatic count follows
+// the machine's core count (hardware_concurrency, read once), never
+// opts.num_threads, so results stay bitwise identical for any thread count.
+struct KvSplit {
+  int count = 1;   // chunks
+  int tiles = 0;   // key tiles per chunk
+};
+
+constexpr int kMinSplitTiles = 4;   // auto mode: key tiles per chunk at least
+
+inline KvSplit kv_split(const AttentionOpts& opts, long long items, int nkb) {
+  if (nkb <= 1) return KvSplit{1, nkb};
+  int s = opts.kv_splits;
+  if (s == 0) {
+    static const int cores = cpu::ThreadPool::resolve_threads(0);
+    s = items >= cores ? 1 : (int)((cores + items - 1) / items);
+    s = std::min(s, nkb / kMinSplitTiles);
+  }
+  s = std::max(1, std::min(s, nkb));
+  KvSplit k;
+  k.tiles = (nkb + s - 1) / s;
+  k.count = (nkb + k.tiles - 1) / k.tiles;   // no empty trailing chunk
+  return k;
+}
+
+// LSE combine of one row over S chunks: chunk c left its normalized output
+// at part + c*part_cs and its log-sum-exp at plse[c*lse_cs]. The row is
+// sum_c exp(lse_c - lse) o_c with lse = log(sum_c exp(lse_c)); acc holds D
+// floats. Returns false (row zero, lse -inf) if no chunk saw a visible key.
+template <class OutT>
+bool combine_kv_splits(const float* part, std::ptrdiff_t part_cs, const float* plse, std::ptrdiff_t lse_cs,
+                       int S, int D, const simd::MicroKernels& kern, float* acc, OutT* o, float* lse)
+{
+  const float ninf = fa::math::neg_inf();
+  float mx = ninf;
+  for (int c=0; c<S; ++c) mx = std::max(mx, plse[c*lse_cs]);
+  if (std::isinf(mx)) {
+    std::fill(o, o + D, OutT{});
+    if (lse) *lse = ninf;
+    return false;
+  }
+  float sum = 0.0f;
+  for (int c=0; c<S; ++c) sum += std::exp(plse[c*lse_cs] - mx);
+  std::fill(acc, acc + D, 0.0f);
+  for (int c=0; c<S; ++c) {
+    const float w = std::exp(plse[c*lse_cs] - mx) / sum;
+    if (w != 0.0f) kern.axpy(w, part + c*part_cs, acc, D);
+  }
+  store_row(kern, acc, o, D);
+  if (lse) *lse = mx + std::log(sum);
+  return true;
+}
+
+} // namespace fa::detail
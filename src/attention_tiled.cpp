@@ -0,0 +1,412 @@
+#include "attention_impl.hpp"
+#include "attention_tile.hpp"
+#include "cpu/thread_pool.hpp"
+#include "fa/autotune.hpp"
+#include "fa/math.hpp"
+#include "fa/simd.hpp"
+#include "fa/tensor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Blocked forward pass with an online softmax (FlashAttention-style).
+//
+// For every query block of Br rows we walk K/V in blocks of Bc keys and keep,
+// per query row, a running max m, a running denominator l and an unnormalized
+// output accumulator acc[D]. When a new key block raises the max, the previous
+// l and acc are rescaled by exp(m_old - m_new) before the block is folded in.
+// Scratch is O(Br*(Bc+D)) per call instead of an N-length logits row, and each
+// K/V tile is reused by all Br query rows while it is hot in cache.
+//
+// Work items are (b, h, query-block) triples scheduled on the persistent
+// thread pool. Each item writes a disjoint set of output rows and does the
+// same arithmetic in the same order regardless of which worker runs it, so
+// results are bitwise identical for any opts.num_threads.
+//
+// Grouped-query / multi-query attention (K/V with H_kv = H / G heads): a work
+// item takes the same query block of all G heads that share a K/V head, so
+// each K/V tile is loaded once for G*Br rows and K/V are never replicated.
+//
+// With opts.causal, key tiles entirely above the diagonal are skipped and a
+// diagonal tile only computes each row's visible prefix, so causal prefill
+// does about half the work of the full pass. Query blocks are then uneven
+// (block qb touches qb+1 key tiles); query_block_order() interleaves heavy
+// and light blocks so every worker's share of the triangle is the same.
+//
+// Padding masks arrive as packed bits: a key tile whose bits are all clear is
+// never loaded, and one whose bits are all set needs no per-key test. With a
+// block-sparse layout the tiles are the layout's blocks and only listed tiles
+// are visited; opts.window restricts every block to a band of tiles.
+//
+// QK^T and PV inner loops go through the fa::simd micro-kernel table, which
+// is fixed once per call so every work item uses the same ISA.
+//
+// bf16/fp16 inputs are widened to fp32 once per tile (the Q block when the
+// work item starts, each K/V tile before the Br rows use it), so the
+// micro-kernels and the softmax state are the fp32 ones; only the final
+// normalized row is rounded if the output type is 16-bit.
+
+namespace fa::detail {
+
+namespace {
+
+// Widened Q block / K,V tiles, 16-bit inputs only.
+struct WidenScratch {
+  std::vector<float> q, k, v;
+
+  WidenScratch(int rows, int bc, int d, bool widen)
+    : q(widen ? (size_t)rows*d : 0), k(widen ? (size_t)bc*d : 0), v(widen ? (size_t)bc*d : 0) {}
+};
+
+inline void widen(const simd::MicroKernels& kern, const bf16* x, float* y, int n) { kern.bf16_to_f32(x, y, n); }
+inline void widen(const simd::MicroKernels& kern, const fp16* x, float* y, int n) { kern.f16_to_f32(x, y, n); }
+
+// fp32 rows [r0, r0+n) of src: used in place for float, widened into buf
+// (n x D, contiguous) for 16-bit storage.
+inline RowSlice load_rows(RowSlice src, int r0, int, int, float*, const simd::MicroKernels&) {
+  return RowSlice{src.row(r0), src.rs};
+}
+template <class T>
+RowSlice load_rows(RowSliceT<T> src, int r0, int n, int D, float* buf, const simd::MicroKernels& kern) {
+  for (int r=0; r<n; ++r) widen(kern, src.row(r0 + r), buf + (size_t)r*D, D);
+  return RowSlice{buf, (std::ptrdiff_t)D};
+}
+
+// Tiles policy over dense float / bf16 / fp16 rows of one (b, K/V head) and
+// the `group` query heads that share it (q_gs elements apart).
+template <class T>
+struct DenseTiles {
+  RowSliceT<T> q_in, k_in, v_in;
+  std::ptrdiff_t q_gs;
+  int group, D;
+  const simd::MicroKernels& kern;
+  WidenScratch& ws;
+  QueryRows q{};
+  RowSlice k{}, v{};   // row c is key j0+c
+
+  void load_queries(int i0, int br) {
+    if constexpr (std::is_same_v<T, float>) {
+      q = QueryRows{q_in.row(i0), q_in.rs, q_gs, br};
+    } else {
+      for (int g=0; g<group; ++g)
+        load_rows(RowSliceT<T>{q_in.p + g*q_gs, q_in.rs}, i0, br, D, ws.q.data() + (size_t)g*br*D, kern);
+      q = QueryRows{ws.q.data(), (std::ptrdiff_t)D, (std::ptrdiff_t)br*D, br};
+    }
+  }
+  void load_keys(int j0, int bc) {
+    k = load_rows(k_in, j0, bc, D, ws.k.data(), kern);
+    v = load_rows(v_in, j0, bc, D, ws.v.data(), kern);
+  }
+  void logits(int r, int bc, float* s) { kern.qk(q.row(r), k.row(0), k.rs, bc, D, s); }
+  void accumulate(int bc, float* p, float* acc) { kern.pv(p, v.row(0), v.rs, bc, D, acc); }
+};
+
+} // namespace
+
+// Tile sizes and work decomposition of one dense problem. Work item =
+// (b, K/V head, slice of its query heads, query block, key chunk).
+struct TiledPlan {
+  int Br, Bc, nqb, G, splits, tasks;
+  KvSplit kv;
+};
+
+static TiledPlan plan_tiled(int B, int H, int Hkv, int N, int Nk, int D, const AttentionMask& mask,
+                            const AttentionOpts& opts, int workers) {
+  const fa::tune::TileConfig tiles = block_sparse_tiles(mask, opts, N, Nk, D);
+  TiledPlan p;
+  p.Br = tiles.block_q;
+  p.Bc = tiles.block_k;
+  p.nqb = (N + p.Br - 1) / p.Br;
+  p.kv = kv_split(opts, (long long)B*H*p.nqb, (Nk + p.Bc - 1) / p.Bc);
+  p.G = heads_per_item(B*Hkv*p.nqb*p.kv.count, H / Hkv, workers);
+  p.splits = H / Hkv / p.G;
+  p.tasks = B*Hkv*p.splits*p.nqb*p.kv.count;
+  return p;
+}
+
+// Floats of split-K partials: every chunk's output rows and lse.
+static std::size_t partial_floats(const TiledPlan& p, int B, int H, int N, int D) {
+  return p.kv.count > 1 ? (std::size_t)p.kv.count*B*H*N*(D + 1) : 0;
+}
+
+// Q/K/V have unit D stride. Output row (b,h,i) is at o + b*o_bs + h*o_hs +
+// i*o_rs. Tile buffers come from ws when given, else are allocated here.
+// With N_q != N_k the queries are the last N_q positions of the key
+// sequence (bottom-right alignment), so a causal query chunk over its full
+// prefix gives the rows of the full prefill.
+template <class T, class OutT>
+static void run_tiled(const TensorViewT<const T>& Q, const TensorViewT<const T>& K,
+                      const TensorViewT<const T>& V, const AttentionMask& mask,
+                      const AttentionOpts& opts, OutT* o, std::ptrdiff_t o_bs,
+                      std::ptrdiff_t o_hs, std::ptrdiff_t o_rs, float* lse,
+                      AttentionWorkspace* ws)
+{
+  const int B=Q.dim(0), H=Q.dim(1), N=Q.dim(2), D=Q.dim(3);
+  const int Hkv = K.dim(1), Nk = K.dim(2);
+  const simd::MicroKernels& kern = simd::kernels();
+  cpu::ThreadPool& pool = cpu::ThreadPool::instance(opts.num_threads);
+  const TiledPlan plan = plan_tiled(B, H, Hkv, N, Nk, D, mask, opts, pool.size());
+  const int Br = plan.Br, Bc = plan.Bc, nqb = plan.nqb, G = plan.G, splits = plan.splits;
+  const int S = plan.kv.count;
+
+  // Split-K partials: chunk c's rows at part + ((c*B + b)*H + h)*N*D, its
+  // lse at plse + (c*B + b)*H*N + h*N.
+  const std::size_t nparts = partial_floats(plan, B, H, N, D);
+  TileScratchSet own;
+  std::vector<float> own_parts;
+  char* arena_parts = nullptr;
+  if (!ws) {
+    own = TileScratchSet(pool.size(), G*Br, Bc, D);
+    own_parts.resize(nparts);
+  }
+  TileScratchSet& scratch = ws ? workspace_scratch(*ws, pool.size(), G*Br, Bc, D, nparts*sizeof(float), &arena_parts)
+                               : own;
+  float* part = ws ? reinterpret_cast<float*>(arena_parts) : own_parts.data();
+  float* plse = S > 1 ? part + (std::size_t)S*B*H*N*D : nullptr;
+  // fp32 inputs are read in place and need no widening buffers
+  constexpr bool widen = !std::is_same_v<T, float>;
+  WidenScratch none(0, 0, 0, false);
+  std::vector<WidenScratch> wide(widen ? pool.size() : 0, WidenScratch(G*Br, Bc, D, widen));
+
+  auto rows = [](const TensorViewT<const T>& X, int b, int h) {
+    return RowSliceT<T>{X.data() + b*X.stride(0) + h*X.stride(1), (std::ptrdiff_t)X.stride(2)};
+  };
+
+  pool.parallel_for(plan.tasks, [&](int t, int worker) {
+    const int c = t % S;
+    const int qb = query_block_order(t / S % nqb, nqb, opts.causal);
+    const int item = t / S / nqb;
+    const int b = item / (Hkv*splits);
+    const int hk = item / splits % Hkv;
+    const int h0 = (hk*splits + item % splits)*G;   // first query head
+    const int i0 = qb*Br;
+    DenseTiles<T> tiles{rows(Q,b,h0), rows(K,b,hk), rows(V,b,hk), (std::ptrdiff_t)Q.stride(1),
+                        G, D, kern, widen ? wide[worker] : none};
+    KeyMask km = key_mask(mask, b, h0, qb);
+    if (S == 1) {
+      forward_query_block(tiles, km, o + b*o_bs + h0*o_hs, o_rs, o_hs,
+                          Nk, D, i0, std::min(Br, N-i0), G, Bc, Nk - N, opts, kern, scratch[worker],
+                          lse ? lse + ((size_t)b*H + h0)*N : nullptr, (std::ptrdiff_t)N);
+      return;
+    }
+    km.j_begin = c*plan.kv.tiles*Bc;
+    km.j_end = km.j_begin + plan.kv.tiles*Bc;
+    const std::size_t head = ((size_t)c*B + b)*H + h0;
+    forward_query_block(tiles, km, part + head*N*D, D, (std::ptrdiff_t)N*D,
+                        Nk, D, i0, std::min(Br, N-i0), G, Bc, Nk - N, opts, kern, scratch[worker],
+                        plse + head*N, (std::ptrdiff_t)N);
+  });
+
+  if (S > 1) {
+    const std::ptrdiff_t part_cs = (std::ptrdiff_t)B*H*N*D, lse_cs = (std::ptrdiff_t)B*H*N;
+    pool.parallel_for(B*H*nqb, [&](int t, int worker) {
+      const int b = t / nqb / H, h = t / nqb % H, i0 = t % nqb * Br;
+      TileScratch& w = scratch[worker];
+      StatsSink* st = stats_sink(opts, w.stats);
+      for (int i = i0; i < std::min(N, i0 + Br); ++i) {
+        const std::size_t row = ((size_t)b*H + h)*N + i;
+        const bool seen = combine_kv_splits(part + row*D, part_cs, plse + row, lse_cs, S, D, kern, w.acc,
+                                            o + b*o_bs + h*o_hs + i*o_rs, lse ? lse + row : nullptr);
+        if (st && !seen) ++st->rows_fully_masked;
+      }
+    });
+  }
+  merge_stats(opts, scratch, (int64_t)D*sizeof(T), 2*(int64_t)D*sizeof(T), (int64_t)D*sizeof(OutT));
+}
+
+template <class T, class OutT>
+TensorT<OutT> attention_forward_tiled(const TensorViewT<const T>& Q_in,
+                                      const TensorViewT<const T>& K_in,
+                                      const TensorViewT<const T>& V_in,
+                                      const AttentionMask& mask,
+                                      const AttentionOpts& opts,
+                                      float* lse)
+{
+  TensorT<T> q_copy, k_copy, v_copy;
+  const TensorViewT<const T> Q = unit_inner(Q_in, q_copy);
+  const TensorViewT<const T> K = unit_inner(K_in, k_copy);
+  const TensorViewT<const T> V = unit_inner(V_in, v_copy);
+
+  const int H=Q.dim(1), N=Q.dim(2), D=Q.dim(3);
+  TensorT<OutT> O = TensorT<OutT>::empty(Q.shape());   // every row is written below
+  run_tiled<T, OutT>(Q, K, V, mask, opts, O.data(), (std::ptrdiff_t)H*N*D, (std::ptrdiff_t)N*D, D,
+                     lse, nullptr);
+  return O;
+}
+
+void attention_forward_tiled_into(const ConstTensorView& Q_in, const ConstTensorView& K_in,
+                                  const ConstTensorView& V_in, const AttentionMask& mask,
+                                  const AttentionOpts& opts, const TensorView& out,
+                                  AttentionWorkspace& ws)
+{
+  // Views own their shape vectors: only copy them when a pack is needed.
+  if (Q_in.stride(3) == 1 && K_in.stride(3) == 1 && V_in.stride(3) == 1) {
+    run_tiled<float, float>(Q_in, K_in, V_in, mask, opts, out.data(), out.stride(0), out.stride(1),
+                            out.stride(2), nullptr, &ws);
+    return;
+  }
+  Tensor q_copy, k_copy, v_copy;
+  const ConstTensorView Q = unit_inner(Q_in, q_copy);
+  const ConstTensorView K = unit_inner(K_in, k_copy);
+  const ConstTensorView V = unit_inner(V_in, v_copy);
+  run_tiled<float, float>(Q, K, V, mask, opts, out.data(), out.stride(0), out.stride(1), out.stride(2),
+                          nullptr, &ws);
+}
+
+std::size_t tiled_workspace_bytes(const std::vector<int>& q_shape, const std::vector<int>& k_shape,
+                                  const AttentionMask& mask, const AttentionOpts& opts)
+{
+  const int workers = cpu::ThreadPool::instance(opts.num_threads).size();
+  const int D = q_shape[3];
+  const TiledPlan plan = plan_tiled(q_shape[0], q_shape[1], k_shape[1], q_shape[2], k_shape[2], D, mask,
+                                    opts, workers);
+  return (std::size_t)workers*TileScratch::bytes(plan.G*plan.Br, plan.Bc, D) +
+         partial_floats(plan, q_shape[0], q_shape[1], q_shape[2], D)*sizeof(float);
+}
+
+// Batched problems: one plan per problem, work items of every problem in one
+// parallel_for (bucket by bucket, problems in input order within a bucket).
+// Keys are never split (kv_splits 0 runs as 1, larger values are rejected
+// up front); otherwise each work item is decomposed as in
+// attention_forward_tiled, so results match single-problem calls with
+// opts.kv_splits = 1 bitwise.
+std::vector<Tensor> attention_forward_batch(const std::vector<AttentionProblem>& problems,
+                                            int num_threads, AttentionStats* stats)
+{
+  const int P = (int)problems.size();
+  std::vector<Tensor> out(P);
+  if (P == 0) return out;
+
+  struct Plan {
+    Tensor q_copy, k_copy, v_copy;
+    ConstTensorView Q, K, V;
+    AttentionOpts opts;
+    int Br = 0, Bc = 0, G = 0, splits = 0, nqb = 0, bucket = 0, first = 0;
+  };
+  std::vector<Plan> plan(P);
+
+  const simd::MicroKernels& kern = simd::kernels();
+  cpu::ThreadPool& pool = cpu::ThreadPool::instance(num_threads);
+
+  long long items = 0;
+  for (int p=0; p<P; ++p) {
+    const AttentionProblem& pr = problems[p];
+    Plan& pl = plan[p];
+    pl.Q = unit_inner(pr.Q, pl.q_copy);
+    pl.K = unit_inner(pr.K, pl.k_copy);
+    pl.V = unit_inner(pr.V, pl.v_copy);
+    pl.opts = pr.opts;
+    pl.opts.stats = stats;
+    const int N = pl.Q.dim(2), D = pl.Q.dim(3);
+    const fa::tune::TileConfig tiles = block_sparse_tiles(pr.mask, pr.opts, N, pl.K.dim(2), D);
+    pl.Br = tiles.block_q;
+    pl.Bc = tiles.block_k;
+    pl.nqb = (N + pl.Br - 1) / pl.Br;
+    items += (long long)pl.Q.dim(0)*pl.K.dim(1)*pl.nqb;
+    out[p] = Tensor::empty(pl.Q.shape());   // every row is written below
+  }
+
+  // Buckets of equal (D, Br, Bc) share per-worker scratch sized for their
+  // largest block; heads are split against the item count of the batch.
+  std::map<std::tuple<int,int,int>, int> bucket_of;
+  std::vector<std::tuple<int,int,int>> bucket_key;
+  std::vector<int> bucket_rows;
+  for (Plan& pl : plan) {
+    const int group = pl.Q.dim(1) / pl.K.dim(1);
+    pl.G = heads_per_item((int)std::min<long long>(items, 1 << 30), group, pool.size());
+    pl.splits = group / pl.G;
+    const auto key = std::make_tuple(pl.Q.dim(3), pl.Br, pl.Bc);
+    auto it = bucket_of.find(key);
+    if (it == bucket_of.end()) {
+      it = bucket_of.emplace(key, (int)bucket_key.size()).first;
+      bucket_key.push_back(key);
+      bucket_rows.push_back(0);
+    }
+    pl.bucket = it->second;
+    bucket_rows[pl.bucket] = std::max(bucket_rows[pl.bucket], pl.G*pl.Br);
+  }
+
+  std::vector<int> order(P);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return plan[a].bucket < plan[b].bucket; });
+  std::vector<int> starts(P);
+  int tasks = 0;
+  for (int k=0; k<P; ++k) {
+    Plan& pl = plan[order[k]];
+    starts[k] = pl.first = tasks;
+    tasks += pl.Q.dim(0)*pl.K.dim(1)*pl.splits*pl.nqb;
+  }
+
+  std::vector<TileScratchSet> scratch;
+  for (size_t bk=0; bk<bucket_key.size(); ++bk) {
+    const auto [D, Br, Bc] = bucket_key[bk];
+    (void)Br;
+    scratch.emplace_back(pool.size(), bucket_rows[bk], Bc, D);
+  }
+  std::vector<WidenScratch> wide(pool.size(), WidenScratch(0, 0, 0, false));
+
+  auto rows = [](const ConstTensorView& X, int b, int h) {
+    return RowSlice{X.data() + b*X.stride(0) + h*X.stride(1), (std::ptrdiff_t)X.stride(2)};
+  };
+
+  pool.parallel_for(tasks, [&](int t, int worker) {
+    const int k = int(std::upper_bound(starts.begin(), starts.end(), t) - starts.begin()) - 1;
+    const int p = order[k];
+    const Plan& pl = plan[p];
+    const int H = pl.Q.dim(1), N = pl.Q.dim(2), D = pl.Q.dim(3), Hkv = pl.K.dim(1), Nk = pl.K.dim(2);
+    const int local = t - pl.first;
+    const int qb = query_block_order(local % pl.nqb, pl.nqb, pl.opts.causal);
+    const int item = local / pl.nqb;
+    const int b = item / (Hkv*pl.splits);
+    const int hk = item / pl.splits % Hkv;
+    const int h0 = (hk*pl.splits + item % pl.splits)*pl.G;
+    const int i0 = qb*pl.Br;
+    const size_t slice = (size_t)N*D;
+    DenseTiles<float> tiles{rows(pl.Q,b,h0), rows(pl.K,b,hk), rows(pl.V,b,hk), (std::ptrdiff_t)pl.Q.stride(1),
+                            pl.G, D, kern, wide[worker]};
+    forward_query_block(tiles, key_mask(problems[p].mask, b, h0, qb), out[p].data() + ((size_t)b*H + h0)*slice, D,
+                        (std::ptrdiff_t)slice, Nk, D, i0, std::min(pl.Br, N-i0), pl.G, pl.Bc, Nk - N,
+                        pl.opts, kern, scratch[pl.bucket][worker]);
+  });
+
+  // Row counts become element counts (D differs between buckets), then all
+  // buckets fold into the first so the batch is one call in the stats.
+  if (stats) {
+    for (size_t bk=0; bk<scratch.size(); ++bk) {
+      const int64_t D = std::get<0>(bucket_key[bk]);
+      for (int w=0; w<pool.size(); ++w) {
+        StatsSink& s = scratch[bk][w].stats;
+        s.q_rows *= D;
+        s.kv_rows *= D;
+        s.o_rows *= D;
+        if (bk > 0) fold_stats(scratch[0][w].stats, s);
+      }
+    }
+    AttentionOpts o;
+    o.stats = stats;
+    merge_stats(o, scratch[0], sizeof(float), 2*sizeof(float), sizeof(float));
+  }
+  return out;
+}
+
+template Tensor attention_forward_tiled<float, float>(
+    const ConstTensorView&, const ConstTensorView&, const ConstTensorView&,
+    const AttentionMask&, const AttentionOpts&, float*);
+template Tensor attention_forward_tiled<bf16, float>(
+    const TensorViewT<const bf16>&, const TensorViewT<const bf16>&, const TensorViewT<const bf16>&,
+    const AttentionMask&, const AttentionOpts&, float*);
+template TensorBF16 attention_forward_tiled<bf16, bf16>(
+    const TensorViewT<const bf16>&, const TensorViewT<const bf16>&, const TensorViewT<const bf16>&,
+    const AttentionMask&, const AttentionOpts&, float*);
+template Tensor attention_forward_tiled<fp16, float>(
+    const TensorViewT<const fp16>&, const TensorViewT<const fp16>&, const TensorViewT<const fp16>&,
+    const AttentionMask&, const AttentionOpts&, float*);
+template TensorF16 attention_forward_tiled<fp16, fp16>(
+    const TensorViewT<const fp16>&, const TensorViewT<const fp16>&, const TensorViewT<const fp16>&,
+    const AttentionMask&, const AttentionOpts&, float*);
+
+} // namespace fa::detail
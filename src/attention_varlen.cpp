@@ -0,0 +1,110 @@
+#include "attention_impl.hpp"
+#include "attention_tile.hpp"
+#include "cpu/thread_pool.hpp"
+#include "fa/autotune.hpp"
+#include "fa/simd.hpp"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+// Packed variable-length batches (same query-block loop as the tiled engine).
+//
+// Q/K/V are (total, H, D) with sequence s occupying tokens
+// [cu_seqlens[s], cu_seqlens[s+1]). A work item is (sequence, head,
+// query-block) and only ever reads the K/V rows of its own sequence, so no
+// padding is stored, loaded or masked. Work items of long sequences are
+// issued first so the short ones fill in behind them. K/V may have fewer heads
+// than Q (GQA/MQA); the query heads sharing a K/V head share its tiles.
+// Dropout streams are keyed by sequence index as the batch index, so every
+// sequence drops independently and results match the padded batch.
+
+namespace fa::detail {
+
+namespace {
+
+struct PackedTiles {
+  RowSlice q_in, k_in, v_in;   // rows of one sequence: first query head, its K/V head
+  std::ptrdiff_t q_gs;
+  int D;
+  const simd::MicroKernels& kern;
+  QueryRows q{};
+  RowSlice k{}, v{};
+
+  void load_queries(int i0, int br) { q = QueryRows{q_in.row(i0), q_in.rs, q_gs, br}; }
+  void load_keys(int j0, int) {
+    k = RowSlice{k_in.row(j0), k_in.rs};
+    v = RowSlice{v_in.row(j0), v_in.rs};
+  }
+  void logits(int r, int bc, float* s) { kern.qk(q.row(r), k.row(0), k.rs, bc, D, s); }
+  void accumulate(int bc, float* p, float* acc) { kern.pv(p, v.row(0), v.rs, bc, D, acc); }
+};
+
+} // namespace
+
+Tensor attention_forward_varlen(const ConstTensorView& Q_in, const ConstTensorView& K_in,
+                                const ConstTensorView& V_in, const std::vector<int>& cu_seqlens,
+                                const AttentionOpts& opts)
+{
+  Tensor q_copy, k_copy, v_copy;
+  auto unit_inner = [](const ConstTensorView& X, Tensor& storage) {
+    if (X.stride(2) == 1) return X;
+    storage = Tensor::from(X);
+    return ConstTensorView(storage.view());
+  };
+  const ConstTensorView Q = unit_inner(Q_in, q_copy);
+  const ConstTensorView K = unit_inner(K_in, k_copy);
+  const ConstTensorView V = unit_inner(V_in, v_copy);
+
+  const int total = Q.dim(0), H = Q.dim(1), D = Q.dim(2), Hkv = K.dim(1);
+  const int S = (int)cu_seqlens.size() - 1;
+  Tensor O = Tensor::empty({total, H, D});
+  if (total == 0) return O;
+
+  int max_len = 0;
+  for (int s=0; s<S; ++s) max_len = std::max(max_len, cu_seqlens[s+1] - cu_seqlens[s]);
+  const fa::tune::TileConfig tiles = fa::tune::resolve_tiles(opts, max_len, D);
+  const int Br = tiles.block_q;
+  const int Bc = tiles.block_k;
+
+  // Longest sequences first; first_task[k] is where order[k]'s items start.
+  std::vector<int> order(S);
+  std::iota(order.begin(), order.end(), 0);
+  auto len = [&](int s) { return cu_seqlens[s+1] - cu_seqlens[s]; };
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return len(a) > len(b); });
+  int blocks = 0;
+  for (int s=0; s<S; ++s) blocks += (len(s) + Br - 1) / Br;
+
+  const simd::MicroKernels& kern = simd::kernels();
+  cpu::ThreadPool& pool = cpu::ThreadPool::instance(opts.num_threads);
+  // Work item = (sequence, K/V head, slice of its query heads, query block).
+  const int G = heads_per_item(Hkv*blocks, H / Hkv, pool.size());
+  const int units = H / G;   // (K/V head, slice) pairs per query block
+  std::vector<int> first_task(S + 1, 0);
+  for (int k=0; k<S; ++k) first_task[k+1] = first_task[k] + units*((len(order[k]) + Br - 1) / Br);
+  const int tasks = first_task[S];
+  TileScratchSet scratch(pool.size(), G*Br, Bc, D);
+
+  auto rows = [](const ConstTensorView& X, int tok0, int h) {
+    return RowSlice{X.data() + tok0*X.stride(0) + h*X.stride(1), (std::ptrdiff_t)X.stride(0)};
+  };
+  const std::ptrdiff_t o_rs = (std::ptrdiff_t)H*D;
+
+  pool.parallel_for(tasks, [&](int t, int worker) {
+    const int k = int(std::upper_bound(first_task.begin(), first_task.end(), t) - first_task.begin()) - 1;
+    const int s = order[k];
+    const int tok0 = cu_seqlens[s], N = len(s);
+    const int nqb = (N + Br - 1) / Br;
+    const int local = t - first_task[k];
+    const int h0 = local / nqb * G;              // first query head
+    const int hk = h0 / (H / Hkv);
+    const int qb = query_block_order(local % nqb, nqb, opts.causal);
+
+    PackedTiles src{rows(Q,tok0,h0), rows(K,tok0,hk), rows(V,tok0,hk), (std::ptrdiff_t)Q.stride(1), D, kern};
+    forward_query_block(src, key_mask(AttentionMask{}, s, h0, 0), O.data() + (size_t)tok0*o_rs + (size_t)h0*D, o_rs, (std::ptrdiff_t)D,
+                        N, D, qb*Br, std::min(Br, N - qb*Br), G, Bc, 0, opts, kern, scratch[worker]);
+  });
+  merge_stats(opts, scratch, (int64_t)D*sizeof(float), 2*(int64_t)D*sizeof(float), (int64_t)D*sizeof(float));
+  return O;
+}
+
+} // namespace fa::detail
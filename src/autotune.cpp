@@ -0,0 +1,188 @@
+#include "fa/autotune.hpp"
+#include "fa/attention.hpp"
+#include "fa/tensor.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace fa::tune {
+
+namespace {
+
+// Cache file format, one entry per line after the header:
+//   # fa tile cache v1
+//   <N> <D> <block_q> <block_k>
+constexpr const char* kCacheHeader = "# fa tile cache v1";
+
+struct TileTable {
+    std::mutex mu;
+    std::map<std::pair<int,int>, TileConfig> entries;
+    bool default_loaded = false;
+};
+
+TileTable& table() {
+    static TileTable t;
+    return t;
+}
+
+void load_into(TileTable& t, const std::string& path) {
+    std::ifstream in(path);
+    if (!in) return;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ls(line);
+        int n, d, bq, bk;
+        if (!(ls >> n >> d >> bq >> bk)) continue;   // skip malformed rows
+        if (n <= 0 || d <= 0 || bq <= 0 || bk <= 0) continue;
+        t.entries[{n, d}] = TileConfig{bq, bk};
+    }
+}
+
+void save_from(TileTable& t, const std::string& path) {
+    if (path.empty()) return;
+    std::filesystem::path p(path);
+    std::error_code ec;
+    if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path(), ec);
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) throw std::runtime_error("autotune: cannot write tile cache " + path);
+    out << kCacheHeader << "\n";
+    for (const auto& [key, cfg] : t.entries)
+        out << key.first << " " << key.second << " " << cfg.block_q << " " << cfg.block_k << "\n";
+}
+
+void ensure_default_loaded(TileTable& t) {
+    if (t.default_loaded) return;
+    t.default_loaded = true;
+    const std::string path = default_cache_path();
+    if (!path.empty()) load_into(t, path);
+}
+
+} // namespace
+
+std::string default_cache_path() {
+    if (const char* p = std::getenv("FA_TILE_CACHE")) return p;
+    if (const char* x = std::getenv("XDG_CACHE_HOME")) return std::string(x) + "/fa_tiles.txt";
+    if (const char* h = std::getenv("HOME")) return std::string(h) + "/.cache/fa_tiles.txt";
+    return {};
+}
+
+TileConfig default_tiles(int N, int /*D*/) {
+    TileConfig c;
+    c.block_q = std::min(c.block_q, N);
+    c.block_k = std::min(c.block_k, N);
+    return c;
+}
+
+bool lookup_tiles(int N, int D, TileConfig* out) {
+    TileTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mu);
+    ensure_default_loaded(t);
+    auto it = t.entries.find({N, D});
+    if (it == t.entries.end()) return false;
+    if (out) *out = it->second;
+    return true;
+}
+
+TileConfig resolve_tiles(const AttentionOpts& opts, int N, int D) {
+    return resolve_tiles(opts, N, N, D);
+}
+
+TileConfig resolve_tiles(const AttentionOpts& opts, int Nq, int Nk, int D) {
+    if (opts.block_q < 0 || opts.block_k < 0)
+        throw std::invalid_argument("attention_forward: block sizes must be non-negative");
+    TileConfig c = default_tiles(Nk, D);
+    if (opts.block_q == 0 || opts.block_k == 0) {
+        TileConfig tuned;
+        if (lookup_tiles(Nk, D, &tuned)) c = tuned;
+    }
+    if (opts.block_q > 0) c.block_q = opts.block_q;
+    if (opts.block_k > 0) c.block_k = opts.block_k;
+    c.block_q = std::max(1, std::min(c.block_q, Nq));
+    c.block_k = std::max(1, std::min(c.block_k, Nk));
+    return c;
+}
+
+void load_tile_cache(const std::string& path) {
+    TileTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mu);
+    load_into(t, path);
+}
+
+void save_tile_cache(const std::string& path) {
+    TileTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mu);
+    save_from(t, path);
+}
+
+void clear_tile_cache() {
+    TileTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mu);
+    t.entries.clear();
+}
+
+TileConfig autotune_tiles(int N, int D, const AutotuneOpts& opts) {
+    if (N <= 0 || D <= 0) throw std::invalid_argument("autotune: N and D must be positive");
+    if (opts.candidates_q.empty() || opts.candidates_k.empty())
+        throw std::invalid_argument("autotune: empty candidate list");
+
+    // Clamp to N and drop duplicates so short sequences don't re-time one tile.
+    auto clamp_unique = [N](const std::vector<int>& in) {
+        std::vector<int> out;
+        for (int v : in) if (v > 0) out.push_back(std::min(v, N));
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    };
+    const std::vector<int> cq = clamp_unique(opts.candidates_q);
+    const std::vector<int> ck = clamp_unique(opts.candidates_k);
+    if (cq.empty() || ck.empty()) throw std::invalid_argument("autotune: no positive candidates");
+
+    Tensor Q = Tensor::randn({1,1,N,D}, 1);
+    Tensor K = Tensor::randn({1,1,N,D}, 2);
+    Tensor V = Tensor::randn({1,1,N,D}, 3);
+
+    TileConfig best = default_tiles(N, D);
+    double best_t = std::numeric_limits<double>::infinity();
+    const int repeats = std::max(1, opts.repeats);
+
+    for (int bq : cq) {
+        for (int bk : ck) {
+            AttentionOpts a;
+            a.engine = AttentionEngine::Tiled;
+            a.block_q = bq;
+            a.block_k = bk;
+            double t_min = std::numeric_limits<double>::infinity();
+            for (int r = 0; r < repeats; ++r) {
+                auto t0 = std::chrono::steady_clock::now();
+                Tensor O = attention_forward(Q, K, V, nullptr, a);
+                auto t1 = std::chrono::steady_clock::now();
+                t_min = std::min(t_min, std::chrono::duration<double>(t1 - t0).count());
+            }
+            if (t_min < best_t) {
+                best_t = t_min;
+                best = TileConfig{bq, bk};
+            }
+        }
+    }
+
+    TileTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mu);
+    // Merge the on-disk table first so we don't drop entries other runs wrote.
+    const std::string path = opts.cache_path.empty() ? default_cache_path() : opts.cache_path;
+    ensure_default_loaded(t);
+    if (!path.empty()) load_into(t, path);
+    t.entries[{N, D}] = best;
+    save_from(t, path);
+    return best;
+}
+
+} // namespace fa::tune
@@ -0,0 +1,40 @@
+#include "fa/dtype.hpp"
+#include "fa/simd.hpp"
+#include <algorithm>
+#include <climits>
+
+namespace fa {
+
+namespace {
+
+// The kernels take int counts; split very large buffers.
+template <class S, class D, class K>
+void convert_chunked(const S* src, D* dst, std::size_t n, K kern) {
+    while (n > 0) {
+        const int c = static_cast<int>(std::min<std::size_t>(n, INT_MAX));
+        kern(src, dst, c);
+        src += c;
+        dst += c;
+        n -= static_cast<std::size_t>(c);
+    }
+}
+
+} // namespace
+
+void convert(const bf16* src, float* dst, std::size_t n) {
+    convert_chunked(src, dst, n, simd::kernels().bf16_to_f32);
+}
+
+void convert(const fp16* src, float* dst, std::size_t n) {
+    convert_chunked(src, dst, n, simd::kernels().f16_to_f32);
+}
+
+void convert(const float* src, bf16* dst, std::size_t n) {
+    convert_chunked(src, dst, n, simd::kernels().f32_to_bf16);
+}
+
+void convert(const float* src, fp16* dst, std::size_t n) {
+    convert_chunked(src, dst, n, simd::kernels().f32_to_f16);
+}
+
+} // namespace fa
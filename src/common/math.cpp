@@ -1,6 +1,9 @@
 #include "fa/math.hpp"
+#include "fa/simd.hpp"
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 
 namespace fa::math {
@@ -27,4 +30,54 @@ float row_sumexp_stable(const float* x, int n, float m) {
     return s;
 }
 
+namespace {
+
+// 2^k for k in [-126, 127], built directly from the exponent bits.
+inline float pow2i(int k) {
+    const uint32_t bits = uint32_t(k + 127) << 23;
+    float f;
+    std::memcpy(&f, &bits, sizeof f);
+    return f;
+}
+
+} // namespace
+
+// The SIMD kernels in src/cpu/simd/ implement the same steps lane-wise; keep
+// the constants in sync.
+float fast_exp(float v) {
+    if (v != v) return v;
+    // The clamp keeps n in [-150, 128]; 2^n is applied as two in-range factors
+    // so overflow/underflow happen in the final multiply and round once.
+    v = std::min(89.0f, std::max(-104.0f, v));
+    const float n = std::nearbyint(v * 1.44269504088896341f);
+    float r = v - n * 0.693359375f;
+    r = r - n * -2.12194440e-4f;
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    const float y = p * (r * r) + r + 1.0f;
+    const int ni = int(n);
+    const int n1 = ni >> 1;
+    return y * pow2i(n1) * pow2i(ni - n1);
+}
+
+void exp_batch(const float* x, float* y, int n) {
+    fa::simd::kernels().exp(x, y, n);
+}
+
+void row_max_sumexp(const float* x, int n, float* m, float* s) {
+    fa::simd::kernels().max_sumexp(x, n, m, s);
+}
+
+void softmax_weights(const float* x, int n, float m, float denom, float* w) {
+    if (std::isinf(m) || !(denom > 0.0f)) {
+        std::fill(w, w + n, 0.0f);
+        return;
+    }
+    fa::simd::kernels().exp_scale(x, n, m, 1.0f / denom, w);
+}
+
 } // namespace fa::math
@@ -1,11 +1,51 @@
-#include <random>
+#include "fa/random.hpp"
+#include "cpu/thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace fa::rnd {
 
-inline void fill_randn(float* data, long long n, unsigned int seed) {
-    std::mt19937 rng(seed);
-    std::normal_distribution<float> dist(0.0f, 1.0f);
-    for (long long i = 0; i < n; ++i) data[i] = dist(rng);
+namespace {
+
+// Elements per task; a multiple of 4 so no Philox block straddles two tasks.
+constexpr long long kChunk = 1 << 14;
+
+// Element k of stream `kind` is lane k % 4 of Philox block k / 4.
+template <class Block>
+void fill_blocks(float* data, long long n, uint64_t seed, uint32_t kind, int num_threads, Block&& block) {
+    if (n <= 0) return;
+    const long long chunks = (n + kChunk - 1) / kChunk;
+    cpu::ThreadPool& pool = cpu::ThreadPool::instance(num_threads);
+    pool.parallel_for((int)chunks, [&](int t, int) {
+        const long long end = std::min(n, (t + 1)*kChunk);
+        for (long long k = t*kChunk; k < end; k += 4) {
+            const uint64_t c = uint64_t(k) >> 2;
+            float v[4];
+            block(philox4x32({uint32_t(c), uint32_t(c >> 32), kind, 0}, seed), v);
+            std::copy(v, v + std::min(4LL, end - k), data + k);
+        }
+    });
+}
+
+} // namespace
+
+void fill_randn(float* data, long long n, uint64_t seed, int num_threads) {
+    const float two_pi = 6.28318530717958647692f;
+    fill_blocks(data, n, seed, 0, num_threads, [&](const std::array<uint32_t, 4>& r, float* v) {
+        for (int p = 0; p < 4; p += 2) {
+            const float u1 = 1.0f - to_unit(r[p]);   // (0, 1]: log stays finite
+            const float u2 = to_unit(r[p + 1]);
+            const float rad = std::sqrt(-2.0f*std::log(u1));
+            v[p] = rad*std::cos(two_pi*u2);
+            v[p + 1] = rad*std::sin(two_pi*u2);
+        }
+    });
+}
+
+void fill_uniform(float* data, long long n, uint64_t seed, int num_threads) {
+    fill_blocks(data, n, seed, 1, num_threads, [](const std::array<uint32_t, 4>& r, float* v) {
+        for (int p = 0; p < 4; ++p) v[p] = to_unit(r[p]);
+    });
 }
 
 } // namespace fa::rnd
@@ -0,0 +1,143 @@
+#include "fa/allocator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+namespace fa::mem {
+
+void* AlignedAllocator::allocate(std::size_t bytes, std::size_t alignment) {
+    return ::operator new(std::max<std::size_t>(bytes, 1), std::align_val_t(alignment));
+}
+
+void AlignedAllocator::deallocate(void* p, std::size_t /*bytes*/, std::size_t alignment) noexcept {
+    ::operator delete(p, std::align_val_t(alignment));
+}
+
+namespace {
+
+constexpr int kMinShift = 6;      // 64 B smallest class
+constexpr int kNumClasses = 40;
+
+struct FreeBlock { FreeBlock* next; };
+
+int class_of(std::size_t bytes) {
+    int c = 0;
+    std::size_t sz = std::size_t(1) << kMinShift;
+    while (sz < bytes) { sz <<= 1; ++c; }
+    return c;
+}
+
+std::size_t class_bytes(int c) { return std::size_t(1) << (kMinShift + c); }
+
+} // namespace
+
+struct PoolAllocator::Impl {
+    struct alignas(64) SizeClass {
+        std::mutex mu;
+        FreeBlock* head = nullptr;
+    };
+
+    std::size_t max_block;
+    std::size_t max_cached;
+    SizeClass classes[kNumClasses];
+    std::atomic<std::size_t> hits{0};
+    std::atomic<std::size_t> misses{0};
+    std::atomic<std::size_t> cached{0};
+};
+
+PoolAllocator::PoolAllocator(std::size_t max_block, std::size_t max_cached)
+    : impl_(new Impl) {
+    impl_->max_block = std::min(max_block, class_bytes(kNumClasses - 1));
+    impl_->max_cached = max_cached;
+}
+
+PoolAllocator::~PoolAllocator() {
+    release();
+    delete impl_;
+}
+
+void* PoolAllocator::allocate(std::size_t bytes, std::size_t alignment) {
+    if (alignment > kAlignment || bytes > impl_->max_block) {
+        impl_->misses.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(std::max<std::size_t>(bytes, 1), std::align_val_t(std::max(alignment, kAlignment)));
+    }
+    const int c = class_of(bytes);
+    auto& sc = impl_->classes[c];
+    {
+        std::lock_guard<std::mutex> lock(sc.mu);
+        if (FreeBlock* b = sc.head) {
+            sc.head = b->next;
+            impl_->cached.fetch_sub(class_bytes(c), std::memory_order_relaxed);
+            impl_->hits.fetch_add(1, std::memory_order_relaxed);
+            return b;
+        }
+    }
+    impl_->misses.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(class_bytes(c), std::align_val_t(kAlignment));
+}
+
+void PoolAllocator::deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept {
+    if (!p) return;
+    if (alignment > kAlignment || bytes > impl_->max_block) {
+        ::operator delete(p, std::align_val_t(std::max(alignment, kAlignment)));
+        return;
+    }
+    const int c = class_of(bytes);
+    const std::size_t sz = class_bytes(c);
+    if (impl_->cached.fetch_add(sz, std::memory_order_relaxed) + sz > impl_->max_cached) {
+        impl_->cached.fetch_sub(sz, std::memory_order_relaxed);
+        ::operator delete(p, std::align_val_t(kAlignment));
+        return;
+    }
+    auto& sc = impl_->classes[c];
+    std::lock_guard<std::mutex> lock(sc.mu);
+    FreeBlock* b = static_cast<FreeBlock*>(p);
+    b->next = sc.head;
+    sc.head = b;
+}
+
+PoolAllocator::Stats PoolAllocator::stats() const {
+    Stats s;
+    s.hits = impl_->hits.load(std::memory_order_relaxed);
+    s.misses = impl_->misses.load(std::memory_order_relaxed);
+    s.cached_bytes = impl_->cached.load(std::memory_order_relaxed);
+    return s;
+}
+
+void PoolAllocator::release() {
+    for (int c = 0; c < kNumClasses; ++c) {
+        auto& sc = impl_->classes[c];
+        std::lock_guard<std::mutex> lock(sc.mu);
+        while (FreeBlock* b = sc.head) {
+            sc.head = b->next;
+            impl_->cached.fetch_sub(class_bytes(c), std::memory_order_relaxed);
+            ::operator delete(static_cast<void*>(b), std::align_val_t(kAlignment));
+        }
+    }
+}
+
+// Leaked on purpose: tensors with static storage duration may be destroyed
+// after any function-local static would be.
+PoolAllocator& builtin_pool() {
+    static PoolAllocator* pool = new PoolAllocator();
+    return *pool;
+}
+
+namespace {
+
+std::atomic<Allocator*>& default_slot() {
+    static std::atomic<Allocator*> slot{&builtin_pool()};
+    return slot;
+}
+
+} // namespace
+
+Allocator& default_allocator() {
+    return *default_slot().load(std::memory_order_acquire);
+}
+
+Allocator* set_default_allocator(Allocator* a) {
+    return default_slot().exchange(a ? a : &builtin_pool(), std::memory_order_acq_rel);
+}
+
+} // namespace fa::mem
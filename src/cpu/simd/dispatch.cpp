@@ -0,0 +1,147 @@
+#include "cpu/simd/kernels.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace fa::simd {
+
+namespace {
+
+// CPUID + XGETBV: the OS must also save the wider register state.
+bool cpu_has(Isa isa) {
+    if (isa == Isa::Scalar) return true;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (isa == Isa::AVX2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+               __builtin_cpu_supports("f16c");
+    if (isa == Isa::AVX512)
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+               __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+    return false;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int r[4];
+    __cpuid(r, 1);
+    const bool osxsave = (r[2] >> 27) & 1;
+    const bool fma = (r[2] >> 12) & 1;
+    const bool f16c = (r[2] >> 29) & 1;
+    if (!osxsave) return false;
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(r, 7, 0);
+    if (isa == Isa::AVX2)
+        return fma && f16c && ((r[1] >> 5) & 1) && (xcr0 & 0x6) == 0x6;
+    if (isa == Isa::AVX512)
+        return ((r[1] >> 16) & 1) && ((r[1] >> 30) & 1) && ((r[1] >> 17) & 1) &&
+               ((r[1] >> 31) & 1) && (xcr0 & 0xE6) == 0xE6;
+    return false;
+#else
+    return false;
+#endif
+}
+
+#if defined(FA_HAVE_AVX512)
+// Optional AVX-512 extensions, probed only on GCC/Clang (MSVC builds keep the
+// baseline AVX-512 kernels).
+[[maybe_unused]] bool cpu_has_ext(const char* feature) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (!std::strcmp(feature, "avx512bf16")) return __builtin_cpu_supports("avx512bf16");
+    if (!std::strcmp(feature, "avx512vnni")) return __builtin_cpu_supports("avx512vnni");
+#endif
+    (void)feature;
+    return false;
+}
+
+// The AVX-512 table with native bf16 stores / VNNI dot products patched in
+// when available.
+const MicroKernels& avx512_table() {
+    static const MicroKernels k = [] {
+        MicroKernels t = detail::avx512_kernels();
+#if defined(FA_HAVE_AVX512_BF16)
+        if (cpu_has_ext("avx512bf16")) t.f32_to_bf16 = detail::f32_to_bf16_avx512bf16;
+#endif
+#if defined(FA_HAVE_AVX512_VNNI)
+        if (cpu_has_ext("avx512vnni")) t.qk_i8 = detail::qk_i8_avx512vnni;
+#endif
+        return t;
+    }();
+    return k;
+}
+#endif
+
+const MicroKernels* table_for(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return &detail::scalar_kernels();
+#if defined(FA_HAVE_AVX2)
+        case Isa::AVX2:   return &detail::avx2_kernels();
+#endif
+#if defined(FA_HAVE_AVX512)
+        case Isa::AVX512: return &avx512_table();
+#endif
+        default: return nullptr;
+    }
+}
+
+Isa initial_isa() {
+    Isa isa = detected_isa();
+    if (const char* env = std::getenv("FA_ISA")) {
+        Isa want = isa;
+        if (!std::strcmp(env, "scalar")) want = Isa::Scalar;
+        else if (!std::strcmp(env, "avx2")) want = Isa::AVX2;
+        else if (!std::strcmp(env, "avx512")) want = Isa::AVX512;
+        if (isa_supported(want) && int(want) < int(isa)) isa = want;
+    }
+    return isa;
+}
+
+std::atomic<const MicroKernels*>& active_slot() {
+    static std::atomic<const MicroKernels*> slot{table_for(initial_isa())};
+    return slot;
+}
+
+// Resolve at load time rather than on the first attention call.
+[[maybe_unused]] const bool g_resolved_at_load = (active_slot(), true);
+
+} // namespace
+
+bool isa_supported(Isa isa) {
+    return table_for(isa) != nullptr && cpu_has(isa);
+}
+
+Isa detected_isa() {
+    if (isa_supported(Isa::AVX512)) return Isa::AVX512;
+    if (isa_supported(Isa::AVX2)) return Isa::AVX2;
+    return Isa::Scalar;
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::AVX2:   return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+    return "unknown";
+}
+
+const MicroKernels& kernels() {
+    return *active_slot().load(std::memory_order_acquire);
+}
+
+const MicroKernels& kernels_for(Isa isa) {
+    if (!isa_supported(isa))
+        throw std::invalid_argument(std::string("simd: ISA not available: ") + isa_name(isa));
+    return *table_for(isa);
+}
+
+Isa select_isa(Isa isa) {
+    const MicroKernels* k = &kernels_for(isa);
+    return active_slot().exchange(k, std::memory_order_acq_rel)->isa;
+}
+
+} // namespace fa::simd
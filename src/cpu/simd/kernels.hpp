@@ -0,0 +1,32 @@
+#pragma once
+// Per-ISA kernel tables. Each lives in its own translation unit compiled with
+// the matching target flags; only dispatch.cpp decides which one may run.
+// Keep the ISA translation units free of inline library code (no <algorithm>,
+// <vector>, ...) so no AVX-compiled COMDAT can leak into the scalar path.
+#include "fa/simd.hpp"
+
+namespace fa::simd::detail {
+
+// -inf as a folded constant for the ISA units: std::numeric_limits<float>::
+// infinity() is an inline function and would be emitted there with AVX code.
+#if defined(_MSC_VER) && !defined(__clang__)
+constexpr float kNegInf = -(float)(1e300 * 1e300);
+#else
+constexpr float kNegInf = -__builtin_huge_valf();
+#endif
+
+const MicroKernels& scalar_kernels();
+#if defined(FA_HAVE_AVX2)
+const MicroKernels& avx2_kernels();
+#endif
+#if defined(FA_HAVE_AVX512)
+const MicroKernels& avx512_kernels();
+#endif
+#if defined(FA_HAVE_AVX512_BF16)
+void f32_to_bf16_avx512bf16(const float* x, bf16* y, int n);
+#endif
+#if defined(FA_HAVE_AVX512_VNNI)
+void qk_i8_avx512vnni(const int8_t* q, const int8_t* k, std::ptrdiff_t ldk, int nk, int D, int32_t* out);
+#endif
+
+} // namespace fa::simd::detail
@@ -0,0 +1,439 @@
+// Compiled with -mavx2 -mfma -mf16c (see CMakeLists.txt). Only reached through
+// dispatch.cpp after CPUID confirms support.
+#include "cpu/simd/kernels.hpp"
+#include <immintrin.h>
+#include <cstdint>
+
+namespace fa::simd::detail {
+
+namespace {
+
+inline float hsum(__m256 v) {
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+    return _mm_cvtss_f32(lo);
+}
+
+// Four keys per pass: q is loaded once per 8 lanes and reused for 4 FMAs.
+void qk_avx2(const float* q, const float* k, std::ptrdiff_t ldk, int nk, int D, float* out) {
+    int c = 0;
+    for (; c + 4 <= nk; c += 4) {
+        const float* k0 = k + (c+0)*ldk;
+        const float* k1 = k + (c+1)*ldk;
+        const float* k2 = k + (c+2)*ldk;
+        const float* k3 = k + (c+3)*ldk;
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+        int d = 0;
+        for (; d + 8 <= D; d += 8) {
+            const __m256 qv = _mm256_loadu_ps(q + d);
+            a0 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k0 + d), a0);
+            a1 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k1 + d), a1);
+            a2 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k2 + d), a2);
+            a3 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k3 + d), a3);
+        }
+        float s0 = hsum(a0), s1 = hsum(a1), s2 = hsum(a2), s3 = hsum(a3);
+        for (; d < D; ++d) {
+            s0 += q[d]*k0[d]; s1 += q[d]*k1[d]; s2 += q[d]*k2[d]; s3 += q[d]*k3[d];
+        }
+        out[c+0] = s0; out[c+1] = s1; out[c+2] = s2; out[c+3] = s3;
+    }
+    for (; c < nk; ++c) {
+        const float* kc = k + c*ldk;
+        __m256 a = _mm256_setzero_ps();
+        int d = 0;
+        for (; d + 8 <= D; d += 8) a = _mm256_fmadd_ps(_mm256_loadu_ps(q + d), _mm256_loadu_ps(kc + d), a);
+        float s = hsum(a);
+        for (; d < D; ++d) s += q[d]*kc[d];
+        out[c] = s;
+    }
+}
+
+// The accumulator stays in registers across all nk keys, 32 lanes at a time.
+// Zero weights are skipped as in pv_scalar, so masked V rows holding NaN or
+// Inf do not reach the output.
+void pv_avx2(const float* p, const float* v, std::ptrdiff_t ldv, int nk, int D, float* acc) {
+    int d = 0;
+    for (; d + 32 <= D; d += 32) {
+        __m256 a0 = _mm256_loadu_ps(acc + d),      a1 = _mm256_loadu_ps(acc + d + 8);
+        __m256 a2 = _mm256_loadu_ps(acc + d + 16), a3 = _mm256_loadu_ps(acc + d + 24);
+        for (int c = 0; c < nk; ++c) {
+            if (p[c] == 0.0f) continue;
+            const __m256 w = _mm256_set1_ps(p[c]);
+            const float* vc = v + c*ldv + d;
+            a0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(vc),      a0);
+            a1 = _mm256_fmadd_ps(w, _mm256_loadu_ps(vc + 8),  a1);
+            a2 = _mm256_fmadd_ps(w, _mm256_loadu_ps(vc + 16), a2);
+            a3 = _mm256_fmadd_ps(w, _mm256_loadu_ps(vc + 24), a3);
+        }
+        _mm256_storeu_ps(acc + d, a0);      _mm256_storeu_ps(acc + d + 8, a1);
+        _mm256_storeu_ps(acc + d + 16, a2); _mm256_storeu_ps(acc + d + 24, a3);
+    }
+    for (; d + 8 <= D; d += 8) {
+        __m256 a = _mm256_loadu_ps(acc + d);
+        for (int c = 0; c < nk; ++c)
+            if (p[c] != 0.0f) a = _mm256_fmadd_ps(_mm256_set1_ps(p[c]), _mm256_loadu_ps(v + c*ldv + d), a);
+        _mm256_storeu_ps(acc + d, a);
+    }
+    for (; d < D; ++d) {
+        float a = acc[d];
+        for (int c = 0; c < nk; ++c) if (p[c] != 0.0f) a += p[c]*v[c*ldv + d];
+        acc[d] = a;
+    }
+}
+
+float dot_avx2(const float* x, const float* y, int n) {
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        a0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i),     _mm256_loadu_ps(y + i),     a0);
+        a1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), a1);
+    }
+    for (; i + 8 <= n; i += 8) a0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), a0);
+    float s = hsum(_mm256_add_ps(a0, a1));
+    for (; i < n; ++i) s += x[i]*y[i];
+    return s;
+}
+
+void axpy_avx2(float a, const float* x, float* y, int n) {
+    const __m256 av = _mm256_set1_ps(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(y + i, _mm256_fmadd_ps(av, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+    for (; i < n; ++i) y[i] += a*x[i];
+}
+
+void scale_avx2(float a, float* x, int n) {
+    const __m256 av = _mm256_set1_ps(a);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_ps(x + i, _mm256_mul_ps(av, _mm256_loadu_ps(x + i)));
+    for (; i < n; ++i) x[i] *= a;
+}
+
+// Lane-wise fa::math::fast_exp (same constants, same 2^n split).
+inline __m256 exp_ps(__m256 x) {
+    // max(lo, x) / min(hi, .) return the second operand for NaN, so NaN survives.
+    x = _mm256_min_ps(_mm256_set1_ps(89.0f), _mm256_max_ps(_mm256_set1_ps(-104.0f), x));
+    const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                                     _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+    r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+    __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.3981999507e-3f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(8.3334519073e-3f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(4.1665795894e-2f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.6666665459e-1f));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(5.0000001201e-1f));
+    const __m256 y = _mm256_add_ps(_mm256_fmadd_ps(p, _mm256_mul_ps(r, r), r), _mm256_set1_ps(1.0f));
+    const __m256i ni = _mm256_cvtps_epi32(n);
+    const __m256i n1 = _mm256_srai_epi32(ni, 1);
+    const __m256i n2 = _mm256_sub_epi32(ni, n1);
+    const __m256i bias = _mm256_set1_epi32(127);
+    const __m256 s1 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n1, bias), 23));
+    const __m256 s2 = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(n2, bias), 23));
+    return _mm256_mul_ps(_mm256_mul_ps(y, s1), s2);
+}
+
+inline __m256i tail_mask(int n) {
+    const __m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), idx);
+}
+
+// Loads n < 8 elements; the remaining lanes hold fill.
+inline __m256 load_tail(const float* x, __m256i m, float fill) {
+    return _mm256_blendv_ps(_mm256_set1_ps(fill), _mm256_maskload_ps(x, m), _mm256_castsi256_ps(m));
+}
+
+inline float hmax(__m256 v) {
+    __m128 lo = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    lo = _mm_max_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_max_ss(lo, _mm_movehdup_ps(lo));
+    return _mm_cvtss_f32(lo);
+}
+
+void exp_avx2(const float* x, float* y, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_ps(y + i, exp_ps(_mm256_loadu_ps(x + i)));
+    if (i < n) {
+        const __m256i m = tail_mask(n - i);
+        _mm256_maskstore_ps(y + i, m, exp_ps(_mm256_maskload_ps(x + i, m)));
+    }
+}
+
+float max_avx2(const float* x, int n) {
+    const float ninf = kNegInf;
+    __m256 a = _mm256_set1_ps(ninf);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) a = _mm256_max_ps(a, _mm256_loadu_ps(x + i));
+    if (i < n) a = _mm256_max_ps(a, load_tail(x + i, tail_mask(n - i), ninf));
+    return hmax(a);
+}
+
+float exp_sum_avx2(float* x, int n, float m) {
+    const __m256 mv = _mm256_set1_ps(m);
+    __m256 acc = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 e = exp_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), mv));
+        _mm256_storeu_ps(x + i, e);
+        acc = _mm256_add_ps(acc, e);
+    }
+    if (i < n) {
+        const __m256i tm = tail_mask(n - i);
+        const __m256 e = exp_ps(_mm256_sub_ps(load_tail(x + i, tm, kNegInf), mv));
+        _mm256_maskstore_ps(x + i, tm, e);
+        acc = _mm256_add_ps(acc, e);
+    }
+    return hsum(acc);
+}
+
+// Per-lane online max/sum with one exp per element (see max_sumexp_scalar),
+// then a cross-lane rescale into the global max.
+void max_sumexp_avx2(const float* x, int n, float* m_out, float* s_out) {
+    const float ninf = kNegInf;
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 m = _mm256_set1_ps(ninf);
+    __m256 s = _mm256_setzero_ps();
+    for (int i = 0; i < n; i += 8) {
+        const __m256 xv = i + 8 <= n ? _mm256_loadu_ps(x + i) : load_tail(x + i, tail_mask(n - i), ninf);
+        const __m256 d = _mm256_sub_ps(xv, m);
+        const __m256 valid = _mm256_cmp_ps(d, d, _CMP_ORD_Q);
+        const __m256 e = _mm256_and_ps(exp_ps(_mm256_or_ps(d, sign)), valid);   // exp(-|d|)
+        const __m256 up = _mm256_cmp_ps(xv, m, _CMP_GT_OQ);
+        s = _mm256_blendv_ps(_mm256_add_ps(s, e), _mm256_fmadd_ps(s, e, one), up);
+        m = _mm256_max_ps(m, xv);
+    }
+    const float mx = hmax(m);
+    if (mx == ninf) { *m_out = mx; *s_out = 0.0f; return; }
+    *m_out = mx;
+    *s_out = hsum(_mm256_mul_ps(s, exp_ps(_mm256_sub_ps(m, _mm256_set1_ps(mx)))));
+}
+
+void exp_scale_avx2(const float* x, int n, float m, float scale, float* w) {
+    const __m256 mv = _mm256_set1_ps(m);
+    const __m256 sv = _mm256_set1_ps(scale);
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_ps(w + i, _mm256_mul_ps(exp_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), mv)), sv));
+    if (i < n) {
+        const __m256i tm = tail_mask(n - i);
+        const __m256 e = exp_ps(_mm256_sub_ps(_mm256_maskload_ps(x + i, tm), mv));
+        _mm256_maskstore_ps(w + i, tm, _mm256_mul_ps(e, sv));
+    }
+}
+
+// bf16 -> fp32 is a 16-bit shift; fp32 -> bf16 rounds to nearest even with
+// integer ops and quiets NaNs so they never round into infinity.
+inline __m256 bf16_load8(const uint16_t* p) {
+    const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+inline __m128i bf16_round8(__m256 v) {
+    const __m256i u = _mm256_castps_si256(v);
+    const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(u, 16), _mm256_set1_epi32(1));
+    __m256i r = _mm256_srli_epi32(_mm256_add_epi32(u, _mm256_add_epi32(lsb, _mm256_set1_epi32(0x7FFF))), 16);
+    const __m256i qnan = _mm256_or_si256(_mm256_srli_epi32(u, 16), _mm256_set1_epi32(0x40));
+    r = _mm256_blendv_epi8(r, qnan, _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q)));
+    const __m256i packed = _mm256_packus_epi32(r, r);          // per 128-bit lane
+    return _mm256_castsi256_si128(_mm256_permute4x64_epi64(packed, 0x08));
+}
+
+inline __m256 f16_load8(const uint16_t* p) {
+    return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+inline __m128i f16_round8(__m256 v) {
+    return _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+}
+
+// Tails go through an 8-lane stack buffer so every element takes the vector path.
+template <__m256 (*load)(const uint16_t*)>
+void widen_avx2(const uint16_t* x, float* y, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) _mm256_storeu_ps(y + i, load(x + i));
+    if (i < n) {
+        uint16_t hb[8] = {};
+        float fb[8];
+        for (int t = 0; t < n - i; ++t) hb[t] = x[i + t];
+        _mm256_storeu_ps(fb, load(hb));
+        for (int t = 0; t < n - i; ++t) y[i + t] = fb[t];
+    }
+}
+
+template <__m128i (*round)(__m256)>
+void narrow_avx2(const float* x, uint16_t* y, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), round(_mm256_loadu_ps(x + i)));
+    if (i < n) {
+        uint16_t hb[8];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hb), round(load_tail(x + i, tail_mask(n - i), 0.0f)));
+        for (int t = 0; t < n - i; ++t) y[i + t] = hb[t];
+    }
+}
+
+void bf16_to_f32_avx2(const bf16* x, float* y, int n) {
+    widen_avx2<bf16_load8>(reinterpret_cast<const uint16_t*>(x), y, n);
+}
+
+void f32_to_bf16_avx2(const float* x, bf16* y, int n) {
+    narrow_avx2<bf16_round8>(x, reinterpret_cast<uint16_t*>(y), n);
+}
+
+void f16_to_f32_avx2(const fp16* x, float* y, int n) {
+    widen_avx2<f16_load8>(reinterpret_cast<const uint16_t*>(x), y, n);
+}
+
+void f32_to_f16_avx2(const float* x, fp16* y, int n) {
+    narrow_avx2<f16_round8>(x, reinterpret_cast<uint16_t*>(y), n);
+}
+
+inline int32_t hsum_epi32(__m256i v) {
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0x4E));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xB1));
+    return _mm_cvtsi128_si32(x);
+}
+
+// Lane i of the result is the horizontal sum of ai.
+inline __m128i hsum4_epi32(__m256i a0, __m256i a1, __m256i a2, __m256i a3) {
+    const __m256i h = _mm256_hadd_epi32(_mm256_hadd_epi32(a0, a1), _mm256_hadd_epi32(a2, a3));
+    return _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+}
+
+// int8 x int8 -> int32 over 32 bytes: maddubs needs an unsigned operand, so
+// multiply |q| by k carrying q's sign. |q|,|k| <= 127 keeps the int16 pair
+// sums (<= 2*127*127) clear of saturation.
+inline __m256i dot_i8x32(__m256i acc, __m256i q, __m256i k) {
+    const __m256i p16 = _mm256_maddubs_epi16(_mm256_abs_epi8(q), _mm256_sign_epi8(k, q));
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(p16, _mm256_set1_epi16(1)));
+}
+
+inline __m256i load_i8x32(const int8_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+void qk_i8_avx2(const int8_t* q, const int8_t* k, std::ptrdiff_t ldk, int nk, int D, int32_t* out) {
+    int c = 0;
+    for (; c + 4 <= nk; c += 4) {
+        const int8_t* k0 = k + (c+0)*ldk;
+        const int8_t* k1 = k + (c+1)*ldk;
+        const int8_t* k2 = k + (c+2)*ldk;
+        const int8_t* k3 = k + (c+3)*ldk;
+        __m256i a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256();
+        __m256i a2 = _mm256_setzero_si256(), a3 = _mm256_setzero_si256();
+        int d = 0;
+        for (; d + 32 <= D; d += 32) {
+            const __m256i qv = load_i8x32(q + d);
+            a0 = dot_i8x32(a0, qv, load_i8x32(k0 + d));
+            a1 = dot_i8x32(a1, qv, load_i8x32(k1 + d));
+            a2 = dot_i8x32(a2, qv, load_i8x32(k2 + d));
+            a3 = dot_i8x32(a3, qv, load_i8x32(k3 + d));
+        }
+        alignas(16) int32_t t[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(t), hsum4_epi32(a0, a1, a2, a3));
+        for (; d < D; ++d) {
+            const int32_t qd = q[d];
+            t[0] += qd*k0[d]; t[1] += qd*k1[d]; t[2] += qd*k2[d]; t[3] += qd*k3[d];
+        }
+        out[c+0] = t[0]; out[c+1] = t[1]; out[c+2] = t[2]; out[c+3] = t[3];
+    }
+    for (; c < nk; ++c) {
+        const int8_t* kc = k + c*ldk;
+        __m256i a = _mm256_setzero_si256();
+        int d = 0;
+        for (; d + 32 <= D; d += 32) a = dot_i8x32(a, load_i8x32(q + d), load_i8x32(kc + d));
+        int32_t s = hsum_epi32(a);
+        for (; d < D; ++d) s += int32_t(q[d])*kc[d];
+        out[c] = s;
+    }
+}
+
+inline __m256 load_i8x8_ps(const int8_t* p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+}
+
+// Dequantization is the int8 -> fp32 widen right before the FMA; the scale
+// is already folded into p.
+void pv_i8_avx2(const float* p, const int8_t* v, std::ptrdiff_t ldv, int nk, int D, float* acc) {
+    int d = 0;
+    for (; d + 32 <= D; d += 32) {
+        __m256 a0 = _mm256_loadu_ps(acc + d),      a1 = _mm256_loadu_ps(acc + d + 8);
+        __m256 a2 = _mm256_loadu_ps(acc + d + 16), a3 = _mm256_loadu_ps(acc + d + 24);
+        for (int c = 0; c < nk; ++c) {
+            const __m256 w = _mm256_set1_ps(p[c]);
+            const int8_t* vc = v + c*ldv + d;
+            a0 = _mm256_fmadd_ps(w, load_i8x8_ps(vc),      a0);
+            a1 = _mm256_fmadd_ps(w, load_i8x8_ps(vc + 8),  a1);
+            a2 = _mm256_fmadd_ps(w, load_i8x8_ps(vc + 16), a2);
+            a3 = _mm256_fmadd_ps(w, load_i8x8_ps(vc + 24), a3);
+        }
+        _mm256_storeu_ps(acc + d, a0);      _mm256_storeu_ps(acc + d + 8, a1);
+        _mm256_storeu_ps(acc + d + 16, a2); _mm256_storeu_ps(acc + d + 24, a3);
+    }
+    for (; d + 8 <= D; d += 8) {
+        __m256 a = _mm256_loadu_ps(acc + d);
+        for (int c = 0; c < nk; ++c)
+            a = _mm256_fmadd_ps(_mm256_set1_ps(p[c]), load_i8x8_ps(v + c*ldv + d), a);
+        _mm256_storeu_ps(acc + d, a);
+    }
+    for (; d < D; ++d) {
+        float a = acc[d];
+        for (int c = 0; c < nk; ++c) a += p[c]*float(v[c*ldv + d]);
+        acc[d] = a;
+    }
+}
+
+// Two panels per pass: four accumulators of 8 keys, one broadcast of q[d]
+// feeding four FMAs.
+void qk_panels_avx2(const float* q, const float* kt, int nk, int D, float* out) {
+    const std::ptrdiff_t ps = (std::ptrdiff_t)D*kPanelKeys;
+    int c0 = 0;
+    for (; c0 + 2*kPanelKeys <= nk; c0 += 2*kPanelKeys, kt += 2*ps) {
+        const float* k1 = kt + ps;
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+        for (int d = 0; d < D; ++d) {
+            const __m256 qv = _mm256_set1_ps(q[d]);
+            a0 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(kt + d*kPanelKeys),     a0);
+            a1 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(kt + d*kPanelKeys + 8), a1);
+            a2 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k1 + d*kPanelKeys),     a2);
+            a3 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k1 + d*kPanelKeys + 8), a3);
+        }
+        _mm256_storeu_ps(out + c0, a0);      _mm256_storeu_ps(out + c0 + 8, a1);
+        _mm256_storeu_ps(out + c0 + 16, a2); _mm256_storeu_ps(out + c0 + 24, a3);
+    }
+    for (; c0 < nk; c0 += kPanelKeys, kt += ps) {
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        for (int d = 0; d < D; ++d) {
+            const __m256 qv = _mm256_set1_ps(q[d]);
+            a0 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(kt + d*kPanelKeys),     a0);
+            a1 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(kt + d*kPanelKeys + 8), a1);
+        }
+        alignas(32) float t[kPanelKeys];
+        _mm256_store_ps(t, a0);
+        _mm256_store_ps(t + 8, a1);
+        const int n = nk - c0 < kPanelKeys ? nk - c0 : kPanelKeys;
+        for (int c = 0; c < n; ++c) out[c0 + c] = t[c];
+    }
+}
+
+} // namespace
+
+const MicroKernels& avx2_kernels() {
+    static const MicroKernels k{Isa::AVX2, "avx2",
+                                qk_avx2, pv_avx2, dot_avx2, axpy_avx2, scale_avx2,
+                                exp_avx2, max_avx2, exp_sum_avx2, max_sumexp_avx2,
+                                exp_scale_avx2,
+                                bf16_to_f32_avx2, f32_to_bf16_avx2,
+                                f16_to_f32_avx2, f32_to_f16_avx2,
+                                qk_i8_avx2, pv_i8_avx2, qk_panels_avx2};
+    return k;
+}
+
+} // namespace fa::simd::detail
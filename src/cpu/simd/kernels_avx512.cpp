@@ -0,0 +1,402 @@
+// Compiled with -mavx512f -mavx512bw -mavx512dq -mavx512vl -mfma (see
+// CMakeLists.txt). Only reached through dispatch.cpp after CPUID confirms
+// support. Tails use masked loads/stores instead of scalar loops.
+#include "cpu/simd/kernels.hpp"
+#include <immintrin.h>
+#include <cstdint>
+
+namespace fa::simd::detail {
+
+namespace {
+
+inline __mmask16 tail_mask(int n) { return (__mmask16)((1u << n) - 1u); }
+
+// Local reductions. The unmasked shuffle/extract intrinsics (and therefore
+// _mm512_reduce_add_ps) use an "undefined" passthrough that GCC 12 flags with
+// -Wuninitialized; the zero-masked forms are equivalent and warning-free.
+inline float hsum(__m512 v) {
+    v = _mm512_add_ps(v, _mm512_maskz_shuffle_f32x4((__mmask16)0xFFFF, v, v, 0x4E));
+    const __m256 h = _mm512_maskz_extractf32x8_ps((__mmask8)0xFF, v, 0);
+    __m128 lo = _mm_add_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+    return _mm_cvtss_f32(lo);
+}
+
+inline float hmax(__m512 v) {
+    v = _mm512_maskz_max_ps((__mmask16)0xFFFF, v, _mm512_maskz_shuffle_f32x4((__mmask16)0xFFFF, v, v, 0x4E));
+    const __m256 h = _mm512_maskz_extractf32x8_ps((__mmask8)0xFF, v, 0);
+    __m128 lo = _mm_max_ps(_mm256_castps256_ps128(h), _mm256_extractf128_ps(h, 1));
+    lo = _mm_max_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_max_ss(lo, _mm_movehdup_ps(lo));
+    return _mm_cvtss_f32(lo);
+}
+
+void qk_avx512(const float* q, const float* k, std::ptrdiff_t ldk, int nk, int D, float* out) {
+    const int full = D & ~15;
+    const __mmask16 tm = tail_mask(D - full);
+    int c = 0;
+    for (; c + 4 <= nk; c += 4) {
+        const float* k0 = k + (c+0)*ldk;
+        const float* k1 = k + (c+1)*ldk;
+        const float* k2 = k + (c+2)*ldk;
+        const float* k3 = k + (c+3)*ldk;
+        __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps();
+        __m512 a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+        for (int d = 0; d < full; d += 16) {
+            const __m512 qv = _mm512_loadu_ps(q + d);
+            a0 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(k0 + d), a0);
+            a1 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(k1 + d), a1);
+            a2 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(k2 + d), a2);
+            a3 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(k3 + d), a3);
+        }
+        if (tm) {
+            const __m512 qv = _mm512_maskz_loadu_ps(tm, q + full);
+            a0 = _mm512_fmadd_ps(qv, _mm512_maskz_loadu_ps(tm, k0 + full), a0);
+            a1 = _mm512_fmadd_ps(qv, _mm512_maskz_loadu_ps(tm, k1 + full), a1);
+            a2 = _mm512_fmadd_ps(qv, _mm512_maskz_loadu_ps(tm, k2 + full), a2);
+            a3 = _mm512_fmadd_ps(qv, _mm512_maskz_loadu_ps(tm, k3 + full), a3);
+        }
+        out[c+0] = hsum(a0);
+        out[c+1] = hsum(a1);
+        out[c+2] = hsum(a2);
+        out[c+3] = hsum(a3);
+    }
+    for (; c < nk; ++c) {
+        const float* kc = k + c*ldk;
+        __m512 a = _mm512_setzero_ps();
+        for (int d = 0; d < full; d += 16)
+            a = _mm512_fmadd_ps(_mm512_loadu_ps(q + d), _mm512_loadu_ps(kc + d), a);
+        if (tm)
+            a = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(tm, q + full), _mm512_maskz_loadu_ps(tm, kc + full), a);
+        out[c] = hsum(a);
+    }
+}
+
+void pv_avx512(const float* p, const float* v, std::ptrdiff_t ldv, int nk, int D, float* acc) {
+    int d = 0;
+    for (; d + 64 <= D; d += 64) {
+        __m512 a0 = _mm512_loadu_ps(acc + d),      a1 = _mm512_loadu_ps(acc + d + 16);
+        __m512 a2 = _mm512_loadu_ps(acc + d + 32), a3 = _mm512_loadu_ps(acc + d + 48);
+        for (int c = 0; c < nk; ++c) {
+            if (p[c] == 0.0f) continue;   // as pv_scalar: masked V rows never reach acc
+            const __m512 w = _mm512_set1_ps(p[c]);
+            const float* vc = v + c*ldv + d;
+            a0 = _mm512_fmadd_ps(w, _mm512_loadu_ps(vc),      a0);
+            a1 = _mm512_fmadd_ps(w, _mm512_loadu_ps(vc + 16), a1);
+            a2 = _mm512_fmadd_ps(w, _mm512_loadu_ps(vc + 32), a2);
+            a3 = _mm512_fmadd_ps(w, _mm512_loadu_ps(vc + 48), a3);
+        }
+        _mm512_storeu_ps(acc + d, a0);      _mm512_storeu_ps(acc + d + 16, a1);
+        _mm512_storeu_ps(acc + d + 32, a2); _mm512_storeu_ps(acc + d + 48, a3);
+    }
+    for (; d < D; d += 16) {
+        const __mmask16 m = D - d >= 16 ? (__mmask16)0xFFFF : tail_mask(D - d);
+        __m512 a = _mm512_maskz_loadu_ps(m, acc + d);
+        for (int c = 0; c < nk; ++c)
+            if (p[c] != 0.0f) a = _mm512_fmadd_ps(_mm512_set1_ps(p[c]), _mm512_maskz_loadu_ps(m, v + c*ldv + d), a);
+        _mm512_mask_storeu_ps(acc + d, m, a);
+    }
+}
+
+float dot_avx512(const float* x, const float* y, int n) {
+    __m512 a = _mm512_setzero_ps();
+    int i = 0;
+    for (; i + 16 <= n; i += 16) a = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), a);
+    if (i < n) {
+        const __mmask16 m = tail_mask(n - i);
+        a = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x + i), _mm512_maskz_loadu_ps(m, y + i), a);
+    }
+    return hsum(a);
+}
+
+void axpy_avx512(float a, const float* x, float* y, int n) {
+    const __m512 av = _mm512_set1_ps(a);
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 m = n - i >= 16 ? (__mmask16)0xFFFF : tail_mask(n - i);
+        const __m512 r = _mm512_fmadd_ps(av, _mm512_maskz_loadu_ps(m, x + i), _mm512_maskz_loadu_ps(m, y + i));
+        _mm512_mask_storeu_ps(y + i, m, r);
+    }
+}
+
+void scale_avx512(float a, float* x, int n) {
+    const __m512 av = _mm512_set1_ps(a);
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 m = n - i >= 16 ? (__mmask16)0xFFFF : tail_mask(n - i);
+        _mm512_mask_storeu_ps(x + i, m, _mm512_mul_ps(av, _mm512_maskz_loadu_ps(m, x + i)));
+    }
+}
+
+inline __mmask16 lanes(int n) { return n >= 16 ? (__mmask16)0xFFFF : tail_mask(n); }
+
+// Lane-wise fa::math::fast_exp. scalef applies 2^n with a single rounding,
+// which matches the scalar two-factor split bit for bit. Zero-masked forms
+// are used throughout for the same GCC 12 reason as hsum.
+inline __m512 exp_ps(__m512 x) {
+    const __mmask16 all = 0xFFFF;
+    x = _mm512_maskz_min_ps(all, _mm512_set1_ps(89.0f), _mm512_maskz_max_ps(all, _mm512_set1_ps(-104.0f), x));
+    const __m512 n = _mm512_maskz_roundscale_ps(all, _mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f)),
+                                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375f), x);
+    r = _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4f), r);
+    __m512 p = _mm512_set1_ps(1.9875691500e-4f);
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.3981999507e-3f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(8.3334519073e-3f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(4.1665795894e-2f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.6666665459e-1f));
+    p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(5.0000001201e-1f));
+    const __m512 y = _mm512_add_ps(_mm512_fmadd_ps(p, _mm512_mul_ps(r, r), r), _mm512_set1_ps(1.0f));
+    return _mm512_maskz_scalef_ps(all, y, n);
+}
+
+void exp_avx512(const float* x, float* y, int n) {
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 m = lanes(n - i);
+        _mm512_mask_storeu_ps(y + i, m, exp_ps(_mm512_maskz_loadu_ps(m, x + i)));
+    }
+}
+
+float max_avx512(const float* x, int n) {
+    const __m512 ninf = _mm512_set1_ps(kNegInf);
+    __m512 a = ninf;
+    for (int i = 0; i < n; i += 16)
+        a = _mm512_maskz_max_ps(0xFFFF, a, _mm512_mask_loadu_ps(ninf, lanes(n - i), x + i));
+    return hmax(a);
+}
+
+float exp_sum_avx512(float* x, int n, float m) {
+    const __m512 mv = _mm512_set1_ps(m);
+    __m512 acc = _mm512_setzero_ps();
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 k = lanes(n - i);
+        const __m512 e = _mm512_maskz_mov_ps(k, exp_ps(_mm512_sub_ps(_mm512_maskz_loadu_ps(k, x + i), mv)));
+        _mm512_mask_storeu_ps(x + i, k, e);
+        acc = _mm512_add_ps(acc, e);
+    }
+    return hsum(acc);
+}
+
+// Per-lane online max/sum with one exp per element (see max_sumexp_scalar).
+void max_sumexp_avx512(const float* x, int n, float* m_out, float* s_out) {
+    const __m512 ninf = _mm512_set1_ps(kNegInf);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    __m512 m = ninf;
+    __m512 s = _mm512_setzero_ps();
+    for (int i = 0; i < n; i += 16) {
+        const __m512 xv = _mm512_mask_loadu_ps(ninf, lanes(n - i), x + i);
+        const __m512 d = _mm512_sub_ps(xv, m);
+        const __mmask16 valid = _mm512_cmp_ps_mask(d, d, _CMP_ORD_Q);
+        const __m512 neg_abs = _mm512_castsi512_ps(
+            _mm512_or_si512(_mm512_castps_si512(d), _mm512_set1_epi32(int(0x80000000u))));
+        const __m512 e = _mm512_maskz_mov_ps(valid, exp_ps(neg_abs));   // exp(-|d|)
+        const __mmask16 up = _mm512_cmp_ps_mask(xv, m, _CMP_GT_OQ);
+        s = _mm512_mask_blend_ps(up, _mm512_add_ps(s, e), _mm512_fmadd_ps(s, e, one));
+        m = _mm512_maskz_max_ps(0xFFFF, m, xv);
+    }
+    const float mx = hmax(m);
+    *m_out = mx;
+    if (mx == kNegInf) { *s_out = 0.0f; return; }
+    *s_out = hsum(_mm512_mul_ps(s, exp_ps(_mm512_sub_ps(m, _mm512_set1_ps(mx)))));
+}
+
+void exp_scale_avx512(const float* x, int n, float m, float scale, float* w) {
+    const __m512 mv = _mm512_set1_ps(m);
+    const __m512 sv = _mm512_set1_ps(scale);
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 k = lanes(n - i);
+        const __m512 e = exp_ps(_mm512_sub_ps(_mm512_maskz_loadu_ps(k, x + i), mv));
+        _mm512_mask_storeu_ps(w + i, k, _mm512_mul_ps(e, sv));
+    }
+}
+
+// Same rounding as the AVX2 path; dispatch.cpp swaps in the native
+// vcvtneps2bf16 store when the CPU has AVX512_BF16.
+inline __m512 bf16_load16(const uint16_t* p, __mmask16 k) {
+    const __m512i w = _mm512_maskz_cvtepu16_epi32((__mmask16)0xFFFF, _mm256_maskz_loadu_epi16(k, p));
+    return _mm512_castsi512_ps(_mm512_maskz_slli_epi32((__mmask16)0xFFFF, w, 16));
+}
+
+inline __m256i bf16_round16(__m512 v) {
+    const __mmask16 all = (__mmask16)0xFFFF;
+    const __m512i u = _mm512_castps_si512(v);
+    const __m512i hi = _mm512_maskz_srli_epi32(all, u, 16);
+    const __m512i lsb = _mm512_and_si512(hi, _mm512_set1_epi32(1));
+    __m512i r = _mm512_maskz_srli_epi32(all, _mm512_add_epi32(u, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7FFF))), 16);
+    const __mmask16 nan = _mm512_cmp_ps_mask(v, v, _CMP_UNORD_Q);
+    r = _mm512_mask_or_epi32(r, nan, hi, _mm512_set1_epi32(0x40));
+    return _mm512_maskz_cvtepi32_epi16(all, r);
+}
+
+void bf16_to_f32_avx512(const bf16* x, float* y, int n) {
+    const uint16_t* src = reinterpret_cast<const uint16_t*>(x);
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 k = lanes(n - i);
+        _mm512_mask_storeu_ps(y + i, k, bf16_load16(src + i, k));
+    }
+}
+
+void f32_to_bf16_avx512(const float* x, bf16* y, int n) {
+    uint16_t* dst = reinterpret_cast<uint16_t*>(y);
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 k = lanes(n - i);
+        _mm256_mask_storeu_epi16(dst + i, k, bf16_round16(_mm512_maskz_loadu_ps(k, x + i)));
+    }
+}
+
+void f16_to_f32_avx512(const fp16* x, float* y, int n) {
+    const uint16_t* src = reinterpret_cast<const uint16_t*>(x);
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 k = lanes(n - i);
+        _mm512_mask_storeu_ps(y + i, k, _mm512_maskz_cvtph_ps(k, _mm256_maskz_loadu_epi16(k, src + i)));
+    }
+}
+
+void f32_to_f16_avx512(const float* x, fp16* y, int n) {
+    uint16_t* dst = reinterpret_cast<uint16_t*>(y);
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 k = lanes(n - i);
+        const __m256i h = _mm512_maskz_cvtps_ph(k, _mm512_maskz_loadu_ps(k, x + i),
+                                                _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_mask_storeu_epi16(dst + i, k, h);
+    }
+}
+
+inline __mmask64 byte_lanes(int n) { return n >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << n) - 1); }
+
+inline int32_t hsum_epi32(__m512i v) {
+    const __m256i h = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64((__mmask8)0xFF, v, 0),
+                                       _mm512_maskz_extracti64x4_epi64((__mmask8)0xFF, v, 1));
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0x4E));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xB1));
+    return _mm_cvtsi128_si32(x);
+}
+
+// Lane i of the result is the horizontal sum of ai.
+inline __m256i fold_epi32(__m512i v) {
+    return _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64((__mmask8)0xFF, v, 0),
+                            _mm512_maskz_extracti64x4_epi64((__mmask8)0xFF, v, 1));
+}
+
+inline __m128i hsum4_epi32(__m512i a0, __m512i a1, __m512i a2, __m512i a3) {
+    const __m256i h = _mm256_hadd_epi32(_mm256_hadd_epi32(fold_epi32(a0), fold_epi32(a1)),
+                                        _mm256_hadd_epi32(fold_epi32(a2), fold_epi32(a3)));
+    return _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+}
+
+// |q| (unsigned) times k with q's sign, as in the AVX2 kernel; |q|,|k| <= 127
+// keeps maddubs from saturating. dispatch.cpp swaps in a vpdpbusd version of
+// qk_i8 when the CPU has AVX512_VNNI.
+inline __m512i dot_i8x64(__m512i acc, __m512i q, __m512i k) {
+    const __mmask64 all = ~(__mmask64)0;
+    const __m512i a = _mm512_maskz_abs_epi8(all, q);
+    const __m512i b = _mm512_mask_sub_epi8(k, _mm512_movepi8_mask(q), _mm512_setzero_si512(), k);
+    const __m512i p16 = _mm512_maskz_maddubs_epi16((__mmask32)0xFFFFFFFF, a, b);
+    return _mm512_add_epi32(acc, _mm512_maskz_madd_epi16((__mmask16)0xFFFF, p16, _mm512_set1_epi16(1)));
+}
+
+void qk_i8_avx512(const int8_t* q, const int8_t* k, std::ptrdiff_t ldk, int nk, int D, int32_t* out) {
+    int c = 0;
+    for (; c + 4 <= nk; c += 4) {
+        const int8_t* k0 = k + (c+0)*ldk;
+        const int8_t* k1 = k + (c+1)*ldk;
+        const int8_t* k2 = k + (c+2)*ldk;
+        const int8_t* k3 = k + (c+3)*ldk;
+        __m512i a0 = _mm512_setzero_si512(), a1 = _mm512_setzero_si512();
+        __m512i a2 = _mm512_setzero_si512(), a3 = _mm512_setzero_si512();
+        for (int d = 0; d < D; d += 64) {
+            const __mmask64 m = byte_lanes(D - d);
+            const __m512i qv = _mm512_maskz_loadu_epi8(m, q + d);
+            a0 = dot_i8x64(a0, qv, _mm512_maskz_loadu_epi8(m, k0 + d));
+            a1 = dot_i8x64(a1, qv, _mm512_maskz_loadu_epi8(m, k1 + d));
+            a2 = dot_i8x64(a2, qv, _mm512_maskz_loadu_epi8(m, k2 + d));
+            a3 = dot_i8x64(a3, qv, _mm512_maskz_loadu_epi8(m, k3 + d));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + c), hsum4_epi32(a0, a1, a2, a3));
+    }
+    for (; c < nk; ++c) {
+        const int8_t* kc = k + c*ldk;
+        __m512i a = _mm512_setzero_si512();
+        for (int d = 0; d < D; d += 64) {
+            const __mmask64 m = byte_lanes(D - d);
+            a = dot_i8x64(a, _mm512_maskz_loadu_epi8(m, q + d), _mm512_maskz_loadu_epi8(m, kc + d));
+        }
+        out[c] = hsum_epi32(a);
+    }
+}
+
+inline __m512 load_i8x16_ps(const int8_t* p, __mmask16 k) {
+    const __m512i w = _mm512_maskz_cvtepi8_epi32((__mmask16)0xFFFF, _mm_maskz_loadu_epi8(k, p));
+    return _mm512_maskz_cvtepi32_ps((__mmask16)0xFFFF, w);
+}
+
+// Dequantization is the int8 -> fp32 widen right before the FMA; the scale
+// is already folded into p.
+void pv_i8_avx512(const float* p, const int8_t* v, std::ptrdiff_t ldv, int nk, int D, float* acc) {
+    const __mmask16 all = (__mmask16)0xFFFF;
+    int d = 0;
+    for (; d + 64 <= D; d += 64) {
+        __m512 a0 = _mm512_loadu_ps(acc + d),      a1 = _mm512_loadu_ps(acc + d + 16);
+        __m512 a2 = _mm512_loadu_ps(acc + d + 32), a3 = _mm512_loadu_ps(acc + d + 48);
+        for (int c = 0; c < nk; ++c) {
+            const __m512 w = _mm512_set1_ps(p[c]);
+            const int8_t* vc = v + c*ldv + d;
+            a0 = _mm512_fmadd_ps(w, load_i8x16_ps(vc, all),      a0);
+            a1 = _mm512_fmadd_ps(w, load_i8x16_ps(vc + 16, all), a1);
+            a2 = _mm512_fmadd_ps(w, load_i8x16_ps(vc + 32, all), a2);
+            a3 = _mm512_fmadd_ps(w, load_i8x16_ps(vc + 48, all), a3);
+        }
+        _mm512_storeu_ps(acc + d, a0);      _mm512_storeu_ps(acc + d + 16, a1);
+        _mm512_storeu_ps(acc + d + 32, a2); _mm512_storeu_ps(acc + d + 48, a3);
+    }
+    for (; d < D; d += 16) {
+        const __mmask16 k = lanes(D - d);
+        __m512 a = _mm512_maskz_loadu_ps(k, acc + d);
+        for (int c = 0; c < nk; ++c)
+            a = _mm512_fmadd_ps(_mm512_set1_ps(p[c]), load_i8x16_ps(v + c*ldv + d, k), a);
+        _mm512_mask_storeu_ps(acc + d, k, a);
+    }
+}
+
+// Four panels per pass (four independent FMA chains), then single panels
+// with a masked store for the tail.
+void qk_panels_avx512(const float* q, const float* kt, int nk, int D, float* out) {
+    const std::ptrdiff_t ps = (std::ptrdiff_t)D*kPanelKeys;
+    int c0 = 0;
+    for (; c0 + 4*kPanelKeys <= nk; c0 += 4*kPanelKeys, kt += 4*ps) {
+        __m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps();
+        __m512 a2 = _mm512_setzero_ps(), a3 = _mm512_setzero_ps();
+        for (int d = 0; d < D; ++d) {
+            const __m512 qv = _mm512_set1_ps(q[d]);
+            const float* r = kt + d*kPanelKeys;
+            a0 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(r),          a0);
+            a1 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(r + ps),     a1);
+            a2 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(r + 2*ps),   a2);
+            a3 = _mm512_fmadd_ps(qv, _mm512_loadu_ps(r + 3*ps),   a3);
+        }
+        _mm512_storeu_ps(out + c0, a0);      _mm512_storeu_ps(out + c0 + 16, a1);
+        _mm512_storeu_ps(out + c0 + 32, a2); _mm512_storeu_ps(out + c0 + 48, a3);
+    }
+    for (; c0 < nk; c0 += kPanelKeys, kt += ps) {
+        __m512 a = _mm512_setzero_ps();
+        for (int d = 0; d < D; ++d)
+            a = _mm512_fmadd_ps(_mm512_set1_ps(q[d]), _mm512_loadu_ps(kt + d*kPanelKeys), a);
+        const int n = nk - c0 < kPanelKeys ? nk - c0 : kPanelKeys;
+        _mm512_mask_storeu_ps(out + c0, tail_mask(n), a);
+    }
+}
+
+} // namespace
+
+const MicroKernels& avx512_kernels() {
+    static const MicroKernels k{Isa::AVX512, "avx512",
+                                qk_avx512, pv_avx512, dot_avx512, axpy_avx512, scale_avx512,
+                                exp_avx512, max_avx512, exp_sum_avx512, max_sumexp_avx512,
+                                exp_scale_avx512,
+                                bf16_to_f32_avx512, f32_to_bf16_avx512,
+                                f16_to_f32_avx512, f32_to_f16_avx512,
+                                qk_i8_avx512, pv_i8_avx512, qk_panels_avx512};
+    return k;
+}
+
+} // namespace fa::simd::detail
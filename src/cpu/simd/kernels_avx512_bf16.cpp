@@ -0,0 +1,20 @@
+// Compiled with -mavx512f -mavx512bw -mavx512vl -mavx512bf16 (see
+// CMakeLists.txt). dispatch.cpp installs this store into the AVX-512 table
+// only after CPUID reports AVX512_BF16.
+#include "cpu/simd/kernels.hpp"
+#include <immintrin.h>
+#include <cstdint>
+
+namespace fa::simd::detail {
+
+// vcvtneps2bf16: round to nearest even, NaNs quieted, fp32 subnormals -> 0.
+void f32_to_bf16_avx512bf16(const float* x, bf16* y, int n) {
+    uint16_t* dst = reinterpret_cast<uint16_t*>(y);
+    for (int i = 0; i < n; i += 16) {
+        const __mmask16 k = n - i >= 16 ? (__mmask16)0xFFFF : (__mmask16)((1u << (n - i)) - 1u);
+        const __m256bh h = _mm512_cvtneps_pbh(_mm512_maskz_loadu_ps(k, x + i));
+        _mm256_mask_storeu_epi16(dst + i, k, (__m256i)h);
+    }
+}
+
+} // namespace fa::simd::detail
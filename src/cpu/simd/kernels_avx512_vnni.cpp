@@ -0,0 +1,75 @@
+// Compiled with -mavx512f -mavx512bw -mavx512vl -mavx512vnni (see
+// CMakeLists.txt). dispatch.cpp installs this into the AVX-512 table only
+// after CPUID reports AVX512_VNNI.
+#include "cpu/simd/kernels.hpp"
+#include <immintrin.h>
+#include <cstdint>
+
+namespace fa::simd::detail {
+
+namespace {
+
+inline __mmask64 byte_lanes(int n) { return n >= 64 ? ~(__mmask64)0 : (((__mmask64)1 << n) - 1); }
+
+inline int32_t hsum_epi32(__m512i v) {
+    const __m256i h = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64((__mmask8)0xFF, v, 0),
+                                       _mm512_maskz_extracti64x4_epi64((__mmask8)0xFF, v, 1));
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0x4E));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xB1));
+    return _mm_cvtsi128_si32(x);
+}
+
+// Lane i of the result is the horizontal sum of ai.
+inline __m256i fold_epi32(__m512i v) {
+    return _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64((__mmask8)0xFF, v, 0),
+                            _mm512_maskz_extracti64x4_epi64((__mmask8)0xFF, v, 1));
+}
+
+inline __m128i hsum4_epi32(__m512i a0, __m512i a1, __m512i a2, __m512i a3) {
+    const __m256i h = _mm256_hadd_epi32(_mm256_hadd_epi32(fold_epi32(a0), fold_epi32(a1)),
+                                        _mm256_hadd_epi32(fold_epi32(a2), fold_epi32(a3)));
+    return _mm_add_epi32(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+}
+
+// vpdpbusd multiplies unsigned by signed bytes and sums groups of four into
+// int32 lanes without intermediate saturation: |q| times k with q's sign.
+inline __m512i dot_i8x64(__m512i acc, __m512i q, __m512i k) {
+    const __m512i a = _mm512_maskz_abs_epi8(~(__mmask64)0, q);
+    const __m512i b = _mm512_mask_sub_epi8(k, _mm512_movepi8_mask(q), _mm512_setzero_si512(), k);
+    return _mm512_dpbusd_epi32(acc, a, b);
+}
+
+} // namespace
+
+void qk_i8_avx512vnni(const int8_t* q, const int8_t* k, std::ptrdiff_t ldk, int nk, int D, int32_t* out) {
+    int c = 0;
+    for (; c + 4 <= nk; c += 4) {
+        const int8_t* k0 = k + (c+0)*ldk;
+        const int8_t* k1 = k + (c+1)*ldk;
+        const int8_t* k2 = k + (c+2)*ldk;
+        const int8_t* k3 = k + (c+3)*ldk;
+        __m512i a0 = _mm512_setzero_si512(), a1 = _mm512_setzero_si512();
+        __m512i a2 = _mm512_setzero_si512(), a3 = _mm512_setzero_si512();
+        for (int d = 0; d < D; d += 64) {
+            const __mmask64 m = byte_lanes(D - d);
+            const __m512i qv = _mm512_maskz_loadu_epi8(m, q + d);
+            a0 = dot_i8x64(a0, qv, _mm512_maskz_loadu_epi8(m, k0 + d));
+            a1 = dot_i8x64(a1, qv, _mm512_maskz_loadu_epi8(m, k1 + d));
+            a2 = dot_i8x64(a2, qv, _mm512_maskz_loadu_epi8(m, k2 + d));
+            a3 = dot_i8x64(a3, qv, _mm512_maskz_loadu_epi8(m, k3 + d));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + c), hsum4_epi32(a0, a1, a2, a3));
+    }
+    for (; c < nk; ++c) {
+        const int8_t* kc = k + c*ldk;
+        __m512i a = _mm512_setzero_si512();
+        for (int d = 0; d < D; d += 64) {
+            const __mmask64 m = byte_lanes(D - d);
+            a = dot_i8x64(a, _mm512_maskz_loadu_epi8(m, q + d), _mm512_maskz_loadu_epi8(m, kc + d));
+        }
+        out[c] = hsum_epi32(a);
+    }
+}
+
+} // namespace fa::simd::detail
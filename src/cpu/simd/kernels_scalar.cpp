@@ -0,0 +1,141 @@
+#include "cpu/simd/kernels.hpp"
+#include "fa/dtype.hpp"
+#include "fa/math.hpp"
+#include <cmath>
+#include <limits>
+
+namespace fa::simd::detail {
+
+namespace {
+
+void qk_scalar(const float* q, const float* k, std::ptrdiff_t ldk, int nk, int D, float* out) {
+    for (int c = 0; c < nk; ++c) {
+        const float* kc = k + c*ldk;
+        float s = 0.0f;
+        for (int d = 0; d < D; ++d) s += q[d]*kc[d];
+        out[c] = s;
+    }
+}
+
+void pv_scalar(const float* p, const float* v, std::ptrdiff_t ldv, int nk, int D, float* acc) {
+    for (int c = 0; c < nk; ++c) {
+        const float w = p[c];
+        if (w == 0.0f) continue;
+        const float* vc = v + c*ldv;
+        for (int d = 0; d < D; ++d) acc[d] += w*vc[d];
+    }
+}
+
+float dot_scalar(const float* x, const float* y, int n) {
+    float s = 0.0f;
+    for (int i = 0; i < n; ++i) s += x[i]*y[i];
+    return s;
+}
+
+void axpy_scalar(float a, const float* x, float* y, int n) {
+    for (int i = 0; i < n; ++i) y[i] += a*x[i];
+}
+
+void scale_scalar(float a, float* x, int n) {
+    for (int i = 0; i < n; ++i) x[i] *= a;
+}
+
+void exp_scalar(const float* x, float* y, int n) {
+    for (int i = 0; i < n; ++i) y[i] = fa::math::fast_exp(x[i]);
+}
+
+float max_scalar(const float* x, int n) {
+    float m = -std::numeric_limits<float>::infinity();
+    for (int i = 0; i < n; ++i) m = x[i] > m ? x[i] : m;
+    return m;
+}
+
+float exp_sum_scalar(float* x, int n, float m) {
+    float s = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        x[i] = fa::math::fast_exp(x[i] - m);
+        s += x[i];
+    }
+    return s;
+}
+
+// Online form with one exp per element: e = exp(-|x - m|) is either the new
+// term (x <= m) or the factor that rescales the running sum (x > m).
+void max_sumexp_scalar(const float* x, int n, float* m_out, float* s_out) {
+    float m = -std::numeric_limits<float>::infinity();
+    float s = 0.0f;
+    for (int i = 0; i < n; ++i) {
+        const float d = x[i] - m;
+        if (d != d) continue;                    // -inf - -inf: contributes nothing
+        const float e = fa::math::fast_exp(-std::fabs(d));
+        if (x[i] > m) { s = s*e + 1.0f; m = x[i]; }
+        else          { s += e; }
+    }
+    *m_out = m;
+    *s_out = s;
+}
+
+void exp_scale_scalar(const float* x, int n, float m, float scale, float* w) {
+    for (int i = 0; i < n; ++i) w[i] = fa::math::fast_exp(x[i] - m) * scale;
+}
+
+void bf16_to_f32_scalar(const bf16* x, float* y, int n) {
+    for (int i = 0; i < n; ++i) y[i] = static_cast<float>(x[i]);
+}
+
+void f32_to_bf16_scalar(const float* x, bf16* y, int n) {
+    for (int i = 0; i < n; ++i) y[i] = bf16(x[i]);
+}
+
+void f16_to_f32_scalar(const fp16* x, float* y, int n) {
+    for (int i = 0; i < n; ++i) y[i] = static_cast<float>(x[i]);
+}
+
+void f32_to_f16_scalar(const float* x, fp16* y, int n) {
+    for (int i = 0; i < n; ++i) y[i] = fp16(x[i]);
+}
+
+void qk_i8_scalar(const int8_t* q, const int8_t* k, std::ptrdiff_t ldk, int nk, int D, int32_t* out) {
+    for (int c = 0; c < nk; ++c) {
+        const int8_t* kc = k + c*ldk;
+        int32_t s = 0;
+        for (int d = 0; d < D; ++d) s += int32_t(q[d])*int32_t(kc[d]);
+        out[c] = s;
+    }
+}
+
+void pv_i8_scalar(const float* p, const int8_t* v, std::ptrdiff_t ldv, int nk, int D, float* acc) {
+    for (int c = 0; c < nk; ++c) {
+        const float w = p[c];
+        if (w == 0.0f) continue;
+        const int8_t* vc = v + c*ldv;
+        for (int d = 0; d < D; ++d) acc[d] += w*float(vc[d]);
+    }
+}
+
+void qk_panels_scalar(const float* q, const float* kt, int nk, int D, float* out) {
+    for (int c0 = 0; c0 < nk; c0 += kPanelKeys, kt += (std::ptrdiff_t)D*kPanelKeys) {
+        float a[kPanelKeys] = {};
+        for (int d = 0; d < D; ++d) {
+            const float* row = kt + (std::ptrdiff_t)d*kPanelKeys;
+            for (int c = 0; c < kPanelKeys; ++c) a[c] += q[d]*row[c];
+        }
+        const int n = nk - c0 < kPanelKeys ? nk - c0 : kPanelKeys;
+        for (int c = 0; c < n; ++c) out[c0 + c] = a[c];
+    }
+}
+
+} // namespace
+
+const MicroKernels& scalar_kernels() {
+    static const MicroKernels k{Isa::Scalar, "scalar",
+                                qk_scalar, pv_scalar, dot_scalar, axpy_scalar, scale_scalar,
+                                exp_scalar, max_scalar, exp_sum_scalar, max_sumexp_scalar,
+                                exp_scale_scalar,
+                                bf16_to_f32_scalar, f32_to_bf16_scalar,
+                                f16_to_f32_scalar, f32_to_f16_scalar,
+                                qk_i8_scalar, pv_i8_scalar, qk_panels_scalar};
+    return k;
+}
+
+} // namespace fa::simd::detail
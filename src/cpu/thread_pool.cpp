@@ -0,0 +1,213 @@
+#include "cpu/thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace fa::cpu {
+
+namespace {
+
+thread_local bool t_in_pool_task = false;
+
+constexpr uint64_t pack(uint32_t lo, uint32_t hi) { return (uint64_t(lo) << 32) | hi; }
+constexpr uint32_t lo_of(uint64_t v) { return uint32_t(v >> 32); }
+constexpr uint32_t hi_of(uint64_t v) { return uint32_t(v); }
+
+} // namespace
+
+// Threads and job state behind one or more ThreadPool handles. A job runs
+// on workers [0, active): the caller as worker 0 and threads 1..active-1,
+// which are the only ones woken. Threads are added (never removed) when a
+// job needs more than there are.
+struct ThreadPool::Workers {
+    // Packed [lo, hi) range: lo in the high 32 bits, hi in the low 32 bits.
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bits{0};
+    };
+
+    std::vector<std::thread> threads;                          // worker w is threads[w - 1]
+    std::vector<std::unique_ptr<std::condition_variable>> wake; // per worker, [0] unused
+    std::unique_ptr<Range[]> ranges;
+    int capacity = 1;                                          // workers including the caller
+
+    std::mutex run_mu;            // one job at a time
+    std::mutex mu;
+    std::condition_variable done;
+    uint64_t generation = 0;
+    int active = 1;
+    int busy_workers = 0;
+    bool stop = false;
+
+    TaskFn fn = nullptr;
+    void* ctx = nullptr;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+
+    Workers() : ranges(new Range[1]) {}
+    ~Workers();
+
+    void grow(int n);
+    void run(int workers, int n, TaskFn f, void* c);
+    void worker_loop(int worker);
+    void drain(int worker);
+    bool pop_own(int worker, int* task);
+    bool steal(int thief, int* task);
+};
+
+int ThreadPool::resolve_threads(int num_threads) {
+    if (num_threads > 0) return num_threads;
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw ? int(hw) : 1;
+}
+
+ThreadPool& ThreadPool::instance(int num_threads) {
+    static std::mutex mu;
+    static const std::shared_ptr<Workers> workers = std::make_shared<Workers>();
+    static std::map<int, std::unique_ptr<ThreadPool>> pools;   // handles only
+    const int n = resolve_threads(num_threads);
+    std::lock_guard<std::mutex> lock(mu);
+    auto& slot = pools[n];
+    if (!slot) slot.reset(new ThreadPool(n, workers));
+    return *slot;
+}
+
+ThreadPool::ThreadPool(int num_threads)
+    : ThreadPool(num_threads, std::make_shared<Workers>()) {}
+
+ThreadPool::ThreadPool(int num_threads, std::shared_ptr<Workers> workers)
+    : num_threads_(std::max(1, num_threads)), workers_(std::move(workers)) {}
+
+ThreadPool::~ThreadPool() = default;
+
+void ThreadPool::run(int n, TaskFn fn, void* ctx) {
+    if (n <= 0) return;
+    if (num_threads_ == 1 || n == 1 || t_in_pool_task) {
+        for (int t = 0; t < n; ++t) fn(ctx, t, 0);
+        return;
+    }
+    workers_->run(num_threads_, n, fn, ctx);
+}
+
+ThreadPool::Workers::~Workers() {
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        stop = true;
+    }
+    for (int w = 1; w < capacity; ++w) wake[w]->notify_one();
+    for (auto& t : threads) t.join();
+}
+
+// Called with run_mu held and no job in flight, so no worker reads ranges.
+void ThreadPool::Workers::grow(int n) {
+    std::lock_guard<std::mutex> lock(mu);
+    ranges.reset(new Range[n]);
+    wake.resize(n);
+    threads.reserve(n - 1);
+    for (int w = capacity; w < n; ++w) {
+        wake[w] = std::make_unique<std::condition_variable>();
+        threads.emplace_back([this, w] { worker_loop(w); });
+        capacity = w + 1;
+    }
+}
+
+bool ThreadPool::Workers::pop_own(int worker, int* task) {
+    auto& r = ranges[worker].bits;
+    uint64_t cur = r.load(std::memory_order_acquire);
+    while (lo_of(cur) < hi_of(cur)) {
+        if (r.compare_exchange_weak(cur, pack(lo_of(cur) + 1, hi_of(cur)),
+                                    std::memory_order_acq_rel)) {
+            *task = int(lo_of(cur));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::Workers::steal(int thief, int* task) {
+    for (int k = 1; k < active; ++k) {
+        auto& r = ranges[(thief + k) % active].bits;
+        uint64_t cur = r.load(std::memory_order_acquire);
+        while (lo_of(cur) < hi_of(cur)) {
+            if (r.compare_exchange_weak(cur, pack(lo_of(cur), hi_of(cur) - 1),
+                                        std::memory_order_acq_rel)) {
+                *task = int(hi_of(cur) - 1);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Workers::drain(int worker) {
+    t_in_pool_task = true;
+    int task;
+    while (pop_own(worker, &task) || steal(worker, &task)) {
+        if (failed.load(std::memory_order_relaxed)) continue;   // skip the rest
+        try {
+            fn(ctx, task, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mu);
+            if (!error) error = std::current_exception();
+            failed.store(true, std::memory_order_relaxed);
+        }
+    }
+    t_in_pool_task = false;
+}
+
+void ThreadPool::Workers::worker_loop(int worker) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            wake[worker]->wait(lock, [&] { return stop || (generation != seen && worker < active); });
+            if (stop) return;
+            seen = generation;
+        }
+        drain(worker);
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            if (--busy_workers == 0) done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::Workers::run(int workers, int n, TaskFn f, void* c) {
+    std::lock_guard<std::mutex> run_lock(run_mu);
+    if (capacity < workers) grow(workers);
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        fn = f;
+        ctx = c;
+        error = nullptr;
+        failed.store(false, std::memory_order_relaxed);
+        for (int w = 0; w < workers; ++w) {
+            const uint32_t lo = uint32_t((int64_t)n * w / workers);
+            const uint32_t hi = uint32_t((int64_t)n * (w + 1) / workers);
+            ranges[w].bits.store(pack(lo, hi), std::memory_order_relaxed);
+        }
+        active = workers;
+        busy_workers = workers - 1;
+        ++generation;
+    }
+    for (int w = 1; w < workers; ++w) wake[w]->notify_one();
+
+    drain(0);
+
+    std::exception_ptr err;
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        done.wait(lock, [&] { return busy_workers == 0; });
+        err = error;
+        error = nullptr;
+    }
+    if (err) std::rethrow_exception(err);
+}
+
+} // namespace fa::cpu
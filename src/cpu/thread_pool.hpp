@@ -0,0 +1,56 @@
+#pragma once
+// Persistent fork-join pool with per-worker task ranges and work stealing.
+// Internal to fa_cpu; engines reach it through ThreadPool::instance().
+#include <memory>
+#include <type_traits>
+
+namespace fa::cpu {
+
+class ThreadPool {
+public:
+    // num_threads counts the calling thread, so a pool of 1 spawns nothing.
+    // Threads are started by the first parallel_for that needs them.
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return num_threads_; }
+
+    // Runs fn(task, worker) for every task in [0, n) and returns when all are
+    // done. worker is in [0, size()) and is stable for the duration of one
+    // task, so callers can index per-worker scratch with it. The caller runs
+    // as worker 0. Tasks start as equal contiguous ranges per worker; a worker
+    // that drains its range steals single tasks from the back of others'.
+    // The first exception thrown by a task is rethrown here. Calls made from
+    // inside a task run inline on the current worker.
+    template <class F>
+    void parallel_for(int n, F&& fn) {
+        using Fn = std::remove_reference_t<F>;
+        run(n, [](void* ctx, int task, int worker) { (*static_cast<Fn*>(ctx))(task, worker); },
+            const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+    // Process-wide pool with exactly num_threads workers (<= 0 means
+    // hardware_concurrency). All sizes share one set of threads, grown to
+    // the largest size used so far and kept until exit; a pool of n runs its
+    // jobs on the first n - 1 of them. So the process holds at most
+    // max(num_threads) - 1 threads however many sizes are requested, and
+    // jobs of pools of different sizes take turns like jobs of one pool.
+    static ThreadPool& instance(int num_threads);
+
+    static int resolve_threads(int num_threads);
+
+private:
+    using TaskFn = void (*)(void*, int, int);
+    struct Workers;
+
+    ThreadPool(int num_threads, std::shared_ptr<Workers> workers);
+    void run(int n, TaskFn fn, void* ctx);
+
+    const int num_threads_;
+    std::shared_ptr<Workers> workers_;
+};
+
+} // namespace fa::cpu
@@ -0,0 +1,90 @@
+#include "fa/kv_cache.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace fa {
+
+KVCache::KVCache(int batch, int heads, int head_dim, int page_size, mem::Allocator* alloc)
+    : batch_(batch), heads_(heads), dim_(head_dim), page_size_(page_size),
+      alloc_(alloc ? alloc : &mem::default_allocator()) {
+    if (batch <= 0 || heads <= 0 || head_dim <= 0)
+        throw std::invalid_argument("KVCache: batch, heads and head_dim must be positive");
+    if (page_size <= 0) throw std::invalid_argument("KVCache: page_size must be positive");
+    lengths_.assign(batch_, 0);
+    pages_.resize(batch_);
+}
+
+KVCache::~KVCache() {
+    for (float* p : blocks_) alloc_->deallocate(p, page_bytes(), mem::kAlignment);
+}
+
+int KVCache::max_length() const {
+    return *std::max_element(lengths_.begin(), lengths_.end());
+}
+
+std::size_t KVCache::pages_in_use() const {
+    std::size_t n = 0;
+    for (const auto& t : pages_) n += t.size();
+    return n;
+}
+
+float* KVCache::take_page() {
+    if (!free_.empty()) {
+        float* p = free_.back();
+        free_.pop_back();
+        return p;
+    }
+    float* p = static_cast<float*>(alloc_->allocate(page_bytes(), mem::kAlignment));
+    blocks_.push_back(p);
+    return p;
+}
+
+void KVCache::append(const ConstTensorView& K, const ConstTensorView& V) {
+    if (K.ndim() != 4 || K.dim(0) != batch_)
+        throw std::invalid_argument("KVCache::append: K must be (B,H,T,D) with B = cache batch");
+    for (int b = 0; b < batch_; ++b) append_row(b, K, V, b);
+}
+
+void KVCache::append(int b, const ConstTensorView& K, const ConstTensorView& V) {
+    if (b < 0 || b >= batch_) throw std::out_of_range("KVCache::append: batch row out of range");
+    if (K.ndim() != 4 || K.dim(0) != 1)
+        throw std::invalid_argument("KVCache::append: K must be (1,H,T,D)");
+    append_row(b, K, V, 0);
+}
+
+// Copies K/V batch entry kb into row b of the cache.
+void KVCache::append_row(int b, const ConstTensorView& K, const ConstTensorView& V, int kb) {
+    if (K.shape() != V.shape()) throw std::invalid_argument("KVCache::append: K and V shapes differ");
+    if (K.dim(1) != heads_) throw std::invalid_argument("KVCache::append: H mismatch");
+    if (K.dim(3) != dim_) throw std::invalid_argument("KVCache::append: D mismatch");
+    const int T = K.dim(2);
+    const std::size_t head_stride = (std::size_t)page_size_*dim_;
+    int& len = lengths_[b];
+    for (int t = 0; t < T; ++t, ++len) {
+        const int slot = len % page_size_;
+        if (slot == 0) pages_[b].push_back(take_page());
+        float* kp = pages_[b].back() + (std::size_t)slot*dim_;
+        float* vp = kp + page_floats();
+        for (int h = 0; h < heads_; ++h) {
+            float* kr = kp + h*head_stride;
+            float* vr = vp + h*head_stride;
+            for (int d = 0; d < dim_; ++d) {
+                kr[d] = K.data()[kb*K.stride(0) + h*K.stride(1) + t*K.stride(2) + d*K.stride(3)];
+                vr[d] = V.data()[kb*V.stride(0) + h*V.stride(1) + t*V.stride(2) + d*V.stride(3)];
+            }
+        }
+    }
+}
+
+void KVCache::reset(int b) {
+    if (b < 0 || b >= batch_) throw std::out_of_range("KVCache::reset: batch row out of range");
+    free_.insert(free_.end(), pages_[b].begin(), pages_[b].end());
+    pages_[b].clear();
+    lengths_[b] = 0;
+}
+
+void KVCache::clear() {
+    for (int b = 0; b < batch_; ++b) reset(b);
+}
+
+} // namespace fa
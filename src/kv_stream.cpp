@@ -0,0 +1,46 @@
+#include "fa/kv_stream.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace fa {
+
+ViewKVSource::ViewKVSource(const ConstTensorView& K, const ConstTensorView& V) : K_(K), V_(V) {
+    if (K.ndim() != 4 || K.shape() != V.shape())
+        throw std::invalid_argument("ViewKVSource: K and V must be 4D (B,H_kv,N,D) of the same shape");
+}
+
+// Rows of one (b, h) are copied whole when D is contiguous, else gathered.
+void ViewKVSource::read(int j0, int n, float* k, float* v) {
+    if (j0 < 0 || n < 0 || j0 > length() - n)
+        throw std::invalid_argument("ViewKVSource::read: rows out of range");
+    const int B = batch(), H = heads(), D = head_dim();
+    auto copy = [&](const ConstTensorView& X, float* out) {
+        for (int b = 0; b < B; ++b) {
+            for (int h = 0; h < H; ++h) {
+                for (int r = 0; r < n; ++r, out += D) {
+                    const float* x = X.data() + b*X.stride(0) + h*X.stride(1) + (long long)(j0 + r)*X.stride(2);
+                    if (X.stride(3) == 1) {
+                        std::copy(x, x + D, out);
+                    } else {
+                        for (int d = 0; d < D; ++d) out[d] = x[d*X.stride(3)];
+                    }
+                }
+            }
+        }
+    };
+    copy(K_, k);
+    copy(V_, v);
+}
+
+FileKVSource::FileKVSource(const std::string& path, const std::string& k_name, const std::string& v_name)
+    : file_(path), views_(file_.view<float>(k_name), file_.view<float>(v_name)) {}
+
+CallbackKVSource::CallbackKVSource(int batch, int heads, int length, int head_dim, ReadFn fn)
+    : batch_(batch), heads_(heads), length_(length), dim_(head_dim), fn_(std::move(fn)) {
+    if (batch <= 0 || heads <= 0 || head_dim <= 0 || length < 0)
+        throw std::invalid_argument("CallbackKVSource: batch, heads and head_dim must be positive, length non-negative");
+    if (!fn_) throw std::invalid_argument("CallbackKVSource: empty read function");
+}
+
+} // namespace fa
@@ -1,26 +1,163 @@
 #include "fa/mask.hpp"
 #include "fa/math.hpp"
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 #include <limits>
 
 namespace fa {
 
-void apply_logits_mask_inplace(float* /*row_logits*/, int /*N*/, const Tensor& /*mask_row*/, int /*key_row_index*/) {
-    // Base commit: no-op. PR2 will implement masking logic.
+namespace {
+
+inline int popcount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int c = 0;
+    for (; x; x &= x - 1) ++c;
+    return c;
+#endif
+}
+
+} // namespace
+
+PaddingBitmask::PaddingBitmask(int batch, int keys, bool keep)
+    : batch_(batch), keys_(keys), words_((keys + 63) / 64)
+{
+    if (batch <= 0 || keys <= 0) throw std::invalid_argument("PaddingBitmask: batch and keys must be positive");
+    bits_.assign((size_t)batch*words_, keep ? ~uint64_t(0) : 0);
+    if (keep && (keys & 63)) {
+        const uint64_t tail = (uint64_t(1) << (keys & 63)) - 1;   // bits past N stay clear
+        for (int b=0; b<batch; ++b) bits_[(size_t)b*words_ + words_ - 1] = tail;
+    }
+}
+
+PaddingBitmask PaddingBitmask::from_tensor(const ConstTensorView& M) {
+    if (M.ndim()!=4 || M.dim(1)!=1 || M.dim(2)!=1) throw std::invalid_argument("mask must be (B,1,1,N)");
+    PaddingBitmask P(M.dim(0), M.dim(3), false);
+    for (int b=0; b<P.batch_; ++b)
+        for (int j=0; j<P.keys_; ++j)
+            if (M.at(b,0,0,j) != 0.0f) P.bits_[(size_t)b*P.words_ + (j >> 6)] |= uint64_t(1) << (j & 63);
+    return P;
+}
+
+PaddingBitmask PaddingBitmask::from_lengths(const std::vector<int>& lengths, int keys) {
+    PaddingBitmask P((int)lengths.size(), keys, false);
+    for (int b=0; b<P.batch_; ++b) {
+        if (lengths[b] < 0 || lengths[b] > keys)
+            throw std::invalid_argument("PaddingBitmask: length out of range");
+        for (int j=0; j<lengths[b]; ++j) P.bits_[(size_t)b*P.words_ + (j >> 6)] |= uint64_t(1) << (j & 63);
+    }
+    return P;
+}
+
+void PaddingBitmask::set(int b, int j, bool keep) {
+    if (b < 0 || b >= batch_ || j < 0 || j >= keys_) throw std::out_of_range("PaddingBitmask index out of range");
+    uint64_t& w = bits_[(size_t)b*words_ + (j >> 6)];
+    const uint64_t bit = uint64_t(1) << (j & 63);
+    w = keep ? (w | bit) : (w & ~bit);
+}
+
+int PaddingBitmask::count(int b, int j0, int n) const {
+    const uint64_t* r = row(b);
+    int c = 0;
+    int j = j0;
+    const int j1 = j0 + n;
+    while (j < j1) {
+        const int off = j & 63;
+        const int take = std::min(64 - off, j1 - j);
+        uint64_t w = r[j >> 6] >> off;
+        if (take < 64) w &= (uint64_t(1) << take) - 1;
+        c += popcount64(w);
+        j += take;
+    }
+    return c;
+}
+
+BlockSparseMask::BlockSparseMask(int block_q, int block_k, int q_blocks, int k_blocks,
+                                 const std::vector<uint8_t>& layout)
+    : block_q_(block_q), block_k_(block_k), q_blocks_(q_blocks), k_blocks_(k_blocks)
+{
+    if (block_q <= 0 || block_k <= 0 || q_blocks <= 0 || k_blocks <= 0)
+        throw std::invalid_argument("BlockSparseMask: block sizes and counts must be positive");
+    if (layout.size() != (size_t)q_blocks*k_blocks)
+        throw std::invalid_argument("BlockSparseMask: layout must be q_blocks x k_blocks");
+    offsets_.assign(q_blocks + 1, 0);
+    for (int qb=0; qb<q_blocks; ++qb) {
+        for (int kb=0; kb<k_blocks; ++kb)
+            if (layout[(size_t)qb*k_blocks + kb]) cols_.push_back(kb);
+        offsets_[qb + 1] = (int)cols_.size();
+    }
+}
+
+bool BlockSparseMask::active(int qb, int kb) const {
+    return std::binary_search(begin(qb), end(qb), kb);
+}
+
+double BlockSparseMask::density() const {
+    return q_blocks_ ? double(cols_.size()) / (double(q_blocks_)*k_blocks_) : 0.0;
+}
+
+void apply_logits_mask_inplace(float* row_logits, int N, const Tensor& mask_row, int key_row_index) {
+    fa::mask::validate_padding_mask_b11n(mask_row.shape().empty() ? 0 : mask_row.dim(0), N, mask_row.view());
+    if (key_row_index < 0 || key_row_index >= mask_row.dim(0))
+        throw std::out_of_range("apply_logits_mask_inplace: row " + std::to_string(key_row_index) + " out of range");
+    const float ninf = fa::math::neg_inf();
+    for (int j=0; j<N; ++j)
+        if (mask_row.at(key_row_index,0,0,j) == 0.0f) row_logits[j] = ninf;
+}
+
+void apply_logits_mask_inplace(float* row_logits, int N, const PaddingBitmask& mask, int key_row_index) {
+    if (N != mask.keys()) throw std::invalid_argument("mask N mismatch");
+    if (key_row_index < 0 || key_row_index >= mask.batch())
+        throw std::out_of_range("apply_logits_mask_inplace: row " + std::to_string(key_row_index) + " out of range");
+    const float ninf = fa::math::neg_inf();
+    const uint64_t* r = mask.row(key_row_index);
+    for (int w=0; w<mask.words_per_row(); ++w) {
+        if (r[w] == ~uint64_t(0)) continue;            // whole word kept
+        const int j1 = std::min(N, (w + 1)*64);
+        for (int j=w*64; j<j1; ++j)
+            if (!((r[w] >> (j & 63)) & 1u)) row_logits[j] = ninf;
+    }
 }
 
 } // namespace fa
 
 namespace fa::mask {
 
-void validate_padding_mask_b11n(const Tensor& Q, const Tensor& M) {
+void validate_padding_mask_b11n(const Tensor& K, const Tensor& M) {
+    validate_padding_mask_b11n(K.view(), M.view());
+}
+
+void validate_padding_mask_b11n(const ConstTensorView& K, const ConstTensorView& M) {
+    validate_padding_mask_b11n(K.dim(0), K.dim(2), M);
+}
+
+void validate_padding_mask_b11n(int B, int N, const ConstTensorView& M) {
     if (M.ndim()!=4) throw std::invalid_argument("mask must be 4D (B,1,1,N)");
-    if (M.dim(0)!=Q.dim(0)) throw std::invalid_argument("mask B mismatch");
+    if (M.dim(0)!=B) throw std::invalid_argument("mask B mismatch");
     if (M.dim(1)!=1 || M.dim(2)!=1) throw std::invalid_argument("mask must be (B,1,1,N)");
-    if (M.dim(3)!=Q.dim(2)) throw std::invalid_argument("mask N mismatch");
+    if (M.dim(3)!=N) throw std::invalid_argument("mask N mismatch");
+}
+
+void validate_attention_mask(int B, int Nq, int Nk, const AttentionMask& M) {
+    if (M.padding) {
+        if (M.padding->batch()!=B) throw std::invalid_argument("padding mask B mismatch");
+        if (M.padding->keys()!=Nk) throw std::invalid_argument("padding mask N mismatch");
+    }
+    if (M.blocks) {
+        const BlockSparseMask& S = *M.blocks;
+        if (S.q_blocks() != (Nq + S.block_q() - 1) / S.block_q() ||
+            S.k_blocks() != (Nk + S.block_k() - 1) / S.block_k())
+            throw std::invalid_argument("block-sparse layout does not cover (N_q, N_k)");
+    }
 }
 
 void apply_padding_mask_logits(std::vector<float>& logits, const Tensor& M, int b, int N) {
+    apply_padding_mask_logits(logits, M.view(), b, N);
+}
+
+void apply_padding_mask_logits(std::vector<float>& logits, const ConstTensorView& M, int b, int N) {
     const float ninf = fa::math::neg_inf();
     for (int j=0;j<N;++j) {
         const float keep = M.at(b,0,0,j);
@@ -0,0 +1,40 @@
+#include "fa/packed_kv.hpp"
+#include <stdexcept>
+
+namespace fa {
+
+PackedKV pack_kv(const ConstTensorView& K, const ConstTensorView* V) {
+    if (K.ndim() != 4) throw std::invalid_argument("pack_kv: K must be 4D (B,H,N,D)");
+    if (V && V->shape() != K.shape()) throw std::invalid_argument("pack_kv: K and V shapes differ");
+    const int B = K.dim(0), H = K.dim(1), N = K.dim(2), D = K.dim(3);
+    constexpr int P = simd::kPanelKeys;
+
+    PackedKV out;
+    out.shape = K.shape();
+    const int np = out.panels_per_head();
+    out.k.assign((std::size_t)B*H*np*D*P, 0.0f);   // padding keys stay zero
+    for (int b = 0; b < B; ++b) {
+        for (int h = 0; h < H; ++h) {
+            const float* src = K.data() + b*K.stride(0) + h*K.stride(1);
+            for (int n = 0; n < N; ++n) {
+                float* dst = out.k.data() + (((std::size_t)b*H + h)*np + n / P)*D*P + n % P;
+                const float* row = src + (long long)n*K.stride(2);
+                for (int d = 0; d < D; ++d) dst[(std::size_t)d*P] = row[d*K.stride(3)];
+            }
+        }
+    }
+
+    if (!V) return out;
+    out.has_v = true;
+    out.v.resize((std::size_t)V->numel());
+    float* dst = out.v.data();
+    for (int b = 0; b < B; ++b)
+        for (int h = 0; h < H; ++h)
+            for (int n = 0; n < N; ++n, dst += D) {
+                const float* row = V->data() + b*V->stride(0) + h*V->stride(1) + (long long)n*V->stride(2);
+                for (int d = 0; d < D; ++d) dst[d] = row[d*V->stride(3)];
+            }
+    return out;
+}
+
+} // namespace fa
@@ -0,0 +1,63 @@
+#include "fa/quantize.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace fa {
+
+QuantizedTensor quantize_int8(const ConstTensorView& X, int block_rows) {
+    if (X.ndim() != 4) throw std::invalid_argument("quantize_int8: input must be 4D (B,H,N,D)");
+    if (block_rows < 0) throw std::invalid_argument("quantize_int8: block_rows must be non-negative");
+    const int B = X.dim(0), H = X.dim(1), N = X.dim(2), D = X.dim(3);
+
+    QuantizedTensor out;
+    out.shape = X.shape();
+    out.block_rows = block_rows == 0 ? N : std::min(block_rows, N);
+    out.values.resize((size_t)X.numel());
+    const int nb = out.blocks_per_head();
+    out.scales.assign((size_t)B*H*nb, 0.0f);
+
+    for (int b = 0; b < B; ++b) {
+        for (int h = 0; h < H; ++h) {
+            for (int blk = 0; blk < nb; ++blk) {
+                const int n0 = blk*out.block_rows;
+                const int n1 = std::min(N, n0 + out.block_rows);
+                float amax = 0.0f;
+                for (int n = n0; n < n1; ++n) {
+                    for (int d = 0; d < D; ++d) {
+                        const float x = X.at(b, h, n, d);
+                        if (!std::isfinite(x)) throw std::invalid_argument("quantize_int8: non-finite value");
+                        amax = std::max(amax, std::fabs(x));
+                    }
+                }
+                const float scale = amax / 127.0f;
+                const float inv = amax > 0.0f ? 127.0f / amax : 0.0f;
+                out.scales[((size_t)b*H + h)*nb + blk] = scale;
+                for (int n = n0; n < n1; ++n) {
+                    int8_t* dst = out.values.data() + (((size_t)b*H + h)*N + n)*D;
+                    for (int d = 0; d < D; ++d) {
+                        const float r = std::nearbyint(X.at(b, h, n, d)*inv);
+                        dst[d] = static_cast<int8_t>(std::clamp(r, -127.0f, 127.0f));
+                    }
+                }
+            }
+        }
+    }
+    return out;
+}
+
+Tensor dequantize(const QuantizedTensor& X) {
+    const int B = X.dim(0), H = X.dim(1), N = X.dim(2), D = X.dim(3);
+    Tensor out = Tensor::empty(X.shape);
+    float* o = out.data();
+    for (int b = 0; b < B; ++b)
+        for (int h = 0; h < H; ++h)
+            for (int n = 0; n < N; ++n) {
+                const float s = X.scale(b, h, n);
+                const int8_t* src = X.row(b, h, n);
+                for (int d = 0; d < D; ++d) *o++ = s*float(src[d]);
+            }
+    return out;
+}
+
+} // namespace fa
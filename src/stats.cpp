@@ -0,0 +1,56 @@
+#include "fa/stats.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace fa {
+
+bool stats_compiled_in() {
+#if defined(FA_STATS) && FA_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::string chrome_trace_json(const AttentionStats& stats) {
+  // Timestamps in microseconds from the first recorded event, fixed to three
+  // decimals so nanoseconds survive however long the trace runs.
+  int64_t t0 = 0;
+  if (!stats.trace.empty()) {
+    t0 = stats.trace.front().start_ns;
+    for (const TraceEvent& e : stats.trace) t0 = std::min(t0, e.start_ns);
+  }
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  for (size_t k=0; k<stats.trace.size(); ++k) {
+    const TraceEvent& e = stats.trace[k];
+    out << (k ? ",\n" : "\n")
+        << "{\"name\":\"query_block\",\"cat\":\"attention\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.worker
+        << ",\"ts\":" << (e.start_ns - t0) / 1000.0 << ",\"dur\":" << e.dur_ns / 1000.0
+        << ",\"args\":{\"b\":" << e.b << ",\"h\":" << e.h << ",\"row\":" << e.row << "}}";
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{"
+      << "\"calls\":" << stats.calls
+      << ",\"qk_ns\":" << stats.qk_ns
+      << ",\"mask_ns\":" << stats.mask_ns
+      << ",\"softmax_ns\":" << stats.softmax_ns
+      << ",\"pv_ns\":" << stats.pv_ns
+      << ",\"tiles_visited\":" << stats.tiles_visited
+      << ",\"tiles_skipped\":" << stats.tiles_skipped
+      << ",\"rows_fully_masked\":" << stats.rows_fully_masked
+      << ",\"bytes_read\":" << stats.bytes_read
+      << ",\"bytes_written\":" << stats.bytes_written
+      << "}}\n";
+  return out.str();
+}
+
+void write_chrome_trace(const AttentionStats& stats, const std::string& path) {
+  std::ofstream f(path);
+  if (!f) throw std::runtime_error("write_chrome_trace: cannot open " + path);
+  f << chrome_trace_json(stats);
+}
+
+} // namespace fa
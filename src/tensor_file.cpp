@@ -0,0 +1,288 @@
+#include "fa/tensor_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fa::io {
+
+namespace {
+
+constexpr char kMagic[8] = {'F','A','T','E','N','S','R','\0'};
+constexpr char kTag[4] = {'T','N','S','R'};
+constexpr uint32_t kByteOrder = 0x01020304u;
+constexpr std::size_t kFileHeader = 64;
+
+struct RecordHeader {
+  char tag[4];
+  uint32_t dtype;
+  uint32_t ndim;
+  uint32_t name_len;
+  uint64_t payload_offset;
+  uint64_t payload_bytes;
+};
+static_assert(sizeof(RecordHeader) == 32, "record header is 32 bytes on disk");
+
+std::size_t round_up(std::size_t n, std::size_t a) { return (n + a - 1) / a * a; }
+
+bool valid_dtype(uint32_t t) { return t >= uint32_t(DType::F32) && t <= uint32_t(DType::I8); }
+
+[[noreturn]] void malformed(const std::string& path, const std::string& why) {
+  throw std::runtime_error("MappedTensorFile: " + path + ": " + why);
+}
+
+} // namespace
+
+std::size_t dtype_size(DType t) {
+  switch (t) {
+    case DType::F32:  return 4;
+    case DType::BF16: return 2;
+    case DType::F16:  return 2;
+    case DType::I8:   return 1;
+  }
+  throw std::invalid_argument("tensor file: unknown dtype");
+}
+
+// ---------------------------------------------------------------- writer --
+
+TensorFileWriter::TensorFileWriter(const std::string& path, std::size_t alignment)
+  : path_(path), out_(path, std::ios::binary | std::ios::trunc), align_(alignment) {
+  if (alignment < 64 || (alignment & (alignment - 1)))
+    throw std::invalid_argument("TensorFileWriter: alignment must be a power of two >= 64");
+  if (!out_) throw std::runtime_error("TensorFileWriter: cannot open " + path);
+  char header[kFileHeader] = {};
+  const uint32_t fields[3] = {kTensorFileVersion, (uint32_t)alignment, kByteOrder};
+  std::memcpy(header, kMagic, sizeof kMagic);
+  std::memcpy(header + 8, fields, sizeof fields);
+  out_.write(header, sizeof header);
+  pos_ = sizeof header;
+  pad_to_alignment();
+}
+
+TensorFileWriter::~TensorFileWriter() {
+  try { close(); } catch (...) {}
+}
+
+void TensorFileWriter::pad_to_alignment() {
+  static const char zeros[4096] = {};
+  std::size_t n = round_up(pos_, align_) - pos_;
+  pos_ += n;
+  while (n > 0) {
+    const std::size_t k = std::min(n, sizeof zeros);
+    out_.write(zeros, (std::streamsize)k);
+    n -= k;
+  }
+  if (!out_) throw std::runtime_error("TensorFileWriter: write failed on " + path_);
+}
+
+void TensorFileWriter::begin(const std::string& name, DType dtype, const std::vector<int>& shape) {
+  if (!out_.is_open()) throw std::invalid_argument("TensorFileWriter: file is closed");
+  if (open_record_) throw std::invalid_argument("TensorFileWriter: begin() before end() of the previous tensor");
+  if (shape.empty()) throw std::invalid_argument("TensorFileWriter: tensor '" + name + "' has no dimensions");
+  std::size_t numel = 1;
+  for (int s : shape) {
+    if (s <= 0) throw std::invalid_argument("TensorFileWriter: tensor '" + name + "' dims must be positive");
+    numel *= (std::size_t)s;
+  }
+  std::vector<int64_t> dims(shape.begin(), shape.end()), strides(shape.size());
+  int64_t stride = 1;
+  for (int k = (int)shape.size() - 1; k >= 0; --k) {
+    strides[k] = stride;
+    stride *= shape[k];
+  }
+
+  RecordHeader h{};
+  std::memcpy(h.tag, kTag, sizeof kTag);
+  h.dtype = (uint32_t)dtype;
+  h.ndim = (uint32_t)shape.size();
+  h.name_len = (uint32_t)name.size();
+  h.payload_bytes = numel*dtype_size(dtype);
+  const std::size_t meta = sizeof h + 2*sizeof(int64_t)*shape.size() + name.size();
+  h.payload_offset = round_up(pos_ + meta, align_);
+
+  out_.write(reinterpret_cast<const char*>(&h), sizeof h);
+  out_.write(reinterpret_cast<const char*>(dims.data()), (std::streamsize)(sizeof(int64_t)*dims.size()));
+  out_.write(reinterpret_cast<const char*>(strides.data()), (std::streamsize)(sizeof(int64_t)*strides.size()));
+  out_.write(name.data(), (std::streamsize)name.size());
+  pos_ += meta;
+  pad_to_alignment();
+  pending_ = h.payload_bytes;
+  open_record_ = true;
+}
+
+void TensorFileWriter::append(const void* data, std::size_t bytes) {
+  if (!open_record_) throw std::invalid_argument("TensorFileWriter: append() outside begin()/end()");
+  if (bytes > pending_) throw std::invalid_argument("TensorFileWriter: append() past the end of the tensor");
+  out_.write(static_cast<const char*>(data), (std::streamsize)bytes);
+  if (!out_) throw std::runtime_error("TensorFileWriter: write failed on " + path_);
+  pos_ += bytes;
+  pending_ -= bytes;
+}
+
+void TensorFileWriter::end() {
+  if (!open_record_) throw std::invalid_argument("TensorFileWriter: end() without begin()");
+  if (pending_ != 0)
+    throw std::invalid_argument("TensorFileWriter: tensor ended " + std::to_string(pending_) + " bytes short");
+  open_record_ = false;
+  pad_to_alignment();
+}
+
+void TensorFileWriter::close() {
+  if (!out_.is_open()) return;
+  if (open_record_) {
+    out_.close();
+    throw std::invalid_argument("TensorFileWriter: closed with an unfinished tensor");
+  }
+  out_.close();
+  if (!out_) throw std::runtime_error("TensorFileWriter: write failed on " + path_);
+}
+
+// ---------------------------------------------------------------- reader --
+
+struct MappedTensorFile::Impl {
+  const char* data = nullptr;
+  std::size_t size = 0;
+  uint32_t version = 0;
+  std::size_t alignment = 0;
+  std::vector<TensorRecord> records;
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+#endif
+
+  ~Impl() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+    if (data) munmap(const_cast<char*>(data), size);
+#endif
+  }
+
+  void map(const std::string& path) {
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("MappedTensorFile: cannot open " + path);
+    LARGE_INTEGER n;
+    if (!GetFileSizeEx(file, &n)) throw std::runtime_error("MappedTensorFile: cannot stat " + path);
+    size = (std::size_t)n.QuadPart;
+    if (size < kFileHeader) malformed(path, "too short for a header");
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) throw std::runtime_error("MappedTensorFile: cannot map " + path);
+    data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!data) throw std::runtime_error("MappedTensorFile: cannot map " + path);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("MappedTensorFile: cannot open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("MappedTensorFile: cannot stat " + path);
+    }
+    size = (std::size_t)st.st_size;
+    if (size < kFileHeader) {
+      ::close(fd);
+      malformed(path, "too short for a header");
+    }
+    void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // the mapping keeps the file
+    if (p == MAP_FAILED) throw std::runtime_error("MappedTensorFile: cannot map " + path);
+    data = static_cast<const char*>(p);
+#endif
+  }
+
+  // Header and every record are checked against the file size, so a view
+  // can never reach past the mapping.
+  void parse(const std::string& path) {
+    if (std::memcmp(data, kMagic, sizeof kMagic) != 0) malformed(path, "not a tensor file");
+    uint32_t fields[3];
+    std::memcpy(fields, data + 8, sizeof fields);
+    version = fields[0];
+    alignment = fields[1];
+    if (fields[2] != kByteOrder) malformed(path, "byte order differs from this machine");
+    if (version != kTensorFileVersion) malformed(path, "unsupported version " + std::to_string(version));
+    if (alignment < 64 || (alignment & (alignment - 1))) malformed(path, "bad alignment");
+
+    std::size_t pos = round_up(kFileHeader, alignment);
+    while (pos < size) {
+      RecordHeader h;
+      if (size - pos < sizeof h) malformed(path, "truncated record header");
+      std::memcpy(&h, data + pos, sizeof h);
+      if (std::memcmp(h.tag, kTag, sizeof kTag) != 0) malformed(path, "bad record tag");
+      if (!valid_dtype(h.dtype)) malformed(path, "unknown dtype " + std::to_string(h.dtype));
+      if (h.ndim == 0 || h.ndim > 16) malformed(path, "bad rank");
+      const std::size_t meta = sizeof h + 2*sizeof(int64_t)*h.ndim + h.name_len;
+      if (h.name_len > size || size - pos < meta) malformed(path, "truncated record");
+
+      TensorRecord r;
+      r.dtype = DType(h.dtype);
+      std::vector<int64_t> dims(h.ndim), strides(h.ndim);
+      std::memcpy(dims.data(), data + pos + sizeof h, sizeof(int64_t)*h.ndim);
+      std::memcpy(strides.data(), data + pos + sizeof h + sizeof(int64_t)*h.ndim, sizeof(int64_t)*h.ndim);
+      r.name.assign(data + pos + sizeof h + 2*sizeof(int64_t)*h.ndim, h.name_len);
+
+      // Highest element offset + 1, in elements. It has to fit in the file,
+      // so every step is checked against that bound before it is taken and
+      // crafted strides cannot wrap it.
+      const std::size_t esize = dtype_size(r.dtype);
+      const uint64_t limit = size / esize;
+      uint64_t extent = 1;
+      for (uint32_t k = 0; k < h.ndim; ++k) {
+        if (dims[k] <= 0 || dims[k] > std::numeric_limits<int>::max() || strides[k] <= 0)
+          malformed(path, "tensor '" + r.name + "' has a bad shape or stride");
+        const uint64_t steps = (uint64_t)(dims[k] - 1);
+        if (steps != 0 && (uint64_t)strides[k] > (limit - extent) / steps)
+          malformed(path, "tensor '" + r.name + "' reaches past the end of the file");
+        extent += steps*(uint64_t)strides[k];
+        r.shape.push_back((int)dims[k]);
+        r.strides.push_back((long long)strides[k]);
+      }
+      if (h.payload_offset % alignment != 0 || h.payload_offset < pos + meta)
+        malformed(path, "tensor '" + r.name + "' payload is misplaced");
+      if (h.payload_bytes < extent*esize || h.payload_offset > size || size - h.payload_offset < h.payload_bytes)
+        malformed(path, "tensor '" + r.name + "' payload is truncated");
+      r.offset = (std::size_t)h.payload_offset;
+      r.bytes = (std::size_t)h.payload_bytes;
+      records.push_back(std::move(r));
+      pos = round_up(h.payload_offset + h.payload_bytes, alignment);
+    }
+  }
+};
+
+MappedTensorFile::MappedTensorFile(const std::string& path) : impl_(std::make_unique<Impl>()) {
+  impl_->map(path);
+  impl_->parse(path);
+}
+
+MappedTensorFile::~MappedTensorFile() = default;
+MappedTensorFile::MappedTensorFile(MappedTensorFile&&) noexcept = default;
+MappedTensorFile& MappedTensorFile::operator=(MappedTensorFile&&) noexcept = default;
+
+uint32_t MappedTensorFile::version() const { return impl_->version; }
+std::size_t MappedTensorFile::alignment() const { return impl_->alignment; }
+const std::vector<TensorRecord>& MappedTensorFile::records() const { return impl_->records; }
+const char* MappedTensorFile::base() const { return impl_->data; }
+
+bool MappedTensorFile::contains(const std::string& name) const {
+  for (const TensorRecord& r : impl_->records) if (r.name == name) return true;
+  return false;
+}
+
+const TensorRecord& MappedTensorFile::record(const std::string& name) const {
+  for (const TensorRecord& r : impl_->records) if (r.name == name) return r;
+  throw std::invalid_argument("MappedTensorFile: no tensor named '" + name + "'");
+}
+
+} // namespace fa::io
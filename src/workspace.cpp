@@ -0,0 +1,57 @@
+#include "fa/workspace.hpp"
+#include "attention_tile.hpp"
+
+namespace fa {
+
+struct AttentionWorkspace::Impl {
+  mem::Allocator* alloc;
+  char* arena = nullptr;
+  std::size_t bytes = 0;
+  detail::TileScratchSet tiles;
+
+  explicit Impl(mem::Allocator* a) : alloc(a ? a : &mem::default_allocator()) {}
+  ~Impl() { release(); }
+
+  void release() {
+    if (arena) alloc->deallocate(arena, bytes, mem::kAlignment);
+    arena = nullptr;
+    bytes = 0;
+  }
+};
+
+AttentionWorkspace::AttentionWorkspace() : impl_(std::make_unique<Impl>(nullptr)) {}
+
+AttentionWorkspace::AttentionWorkspace(std::size_t bytes, mem::Allocator* alloc)
+  : impl_(std::make_unique<Impl>(alloc)) {
+  reserve(bytes);
+}
+
+AttentionWorkspace::~AttentionWorkspace() = default;
+AttentionWorkspace::AttentionWorkspace(AttentionWorkspace&&) noexcept = default;
+AttentionWorkspace& AttentionWorkspace::operator=(AttentionWorkspace&&) noexcept = default;
+
+void AttentionWorkspace::reserve(std::size_t bytes) {
+  if (!impl_) impl_ = std::make_unique<Impl>(nullptr);   // moved-from
+  if (bytes <= impl_->bytes) return;
+  impl_->release();
+  impl_->arena = static_cast<char*>(impl_->alloc->allocate(bytes, mem::kAlignment));
+  impl_->bytes = bytes;
+}
+
+std::size_t AttentionWorkspace::capacity() const { return impl_ ? impl_->bytes : 0; }
+
+namespace detail {
+
+TileScratchSet& workspace_scratch(AttentionWorkspace& ws, int workers, int rows, int bc, int d,
+                                  std::size_t extra, char** extra_out) {
+  // tile buffers first, then `extra` bytes (64-aligned, since bytes() is)
+  const std::size_t tiles = (std::size_t)workers*TileScratch::bytes(rows, bc, d);
+  ws.reserve(tiles + extra);
+  ws.impl_->tiles.reset(ws.impl_->arena, workers, rows, bc, d);
+  if (extra_out) *extra_out = ws.impl_->arena + tiles;
+  return ws.impl_->tiles;
+}
+
+} // namespace detail
+
+} // namespace fa
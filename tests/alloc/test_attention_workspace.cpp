@@ -0,0 +1,149 @@
+#include "gtest/gtest.h"
+#include "fa/allocator.hpp"
+#include "fa/attention.hpp"
+#include "fa/mask.hpp"
+#include "fa/tensor.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+using namespace fa;
+
+// Heap allocations made by any thread while `counting` is set. This file is
+// its own executable (alloc_tests): the replacements below cover every
+// global new/delete form, plain, array, nothrow, sized and aligned, so no
+// allocation escapes the count and no pair is mismatched under sanitizers.
+static std::atomic<bool> counting{false};
+static std::atomic<int> heap_allocs{0};
+
+static void* counted(std::size_t n) noexcept {
+  if (counting.load(std::memory_order_relaxed)) ++heap_allocs;
+  return std::malloc(n ? n : 1);
+}
+static void* counted_aligned(std::size_t n, std::align_val_t al) noexcept {
+  if (counting.load(std::memory_order_relaxed)) ++heap_allocs;
+  const std::size_t a = static_cast<std::size_t>(al);
+  n = (n ? n + a - 1 : a) / a * a;   // aligned_alloc wants a multiple of a
+#if defined(_WIN32)
+  return _aligned_malloc(n, a);
+#else
+  return std::aligned_alloc(a, n);
+#endif
+}
+static void release_aligned(void* p) noexcept {
+#if defined(_WIN32)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+static void* or_throw(void* p) {
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(std::size_t n) { return or_throw(counted(n)); }
+void* operator new[](std::size_t n) { return or_throw(counted(n)); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return counted(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return counted(n); }
+void* operator new(std::size_t n, std::align_val_t a) { return or_throw(counted_aligned(n, a)); }
+void* operator new[](std::size_t n, std::align_val_t a) { return or_throw(counted_aligned(n, a)); }
+void* operator new(std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return counted_aligned(n, a); }
+void* operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { return counted_aligned(n, a); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { release_aligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { release_aligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { release_aligned(p); }
+
+namespace {
+struct CountingAllocator final : mem::Allocator {
+  std::atomic<int> allocs{0};
+  mem::AlignedAllocator inner;
+  void* allocate(size_t n, size_t a) override { ++allocs; return inner.allocate(n, a); }
+  void deallocate(void* p, size_t n, size_t a) noexcept override { inner.deallocate(p, n, a); }
+};
+
+// Runs fn with heap and Tensor allocations counted; returns their sum.
+template <class F>
+int allocations_during(F&& fn) {
+  CountingAllocator tensors;
+  mem::Allocator* prev = mem::set_default_allocator(&tensors);
+  heap_allocs = 0;
+  counting = true;
+  fn();
+  counting = false;
+  mem::set_default_allocator(prev);
+  return heap_allocs.load() + tensors.allocs.load();
+}
+}
+
+// 1) Steady-state calls allocate nothing and match the tiled engine bitwise
+TEST(AttentionWorkspace, NoAllocationsAfterWarmup) {
+  const int B=2,H=4,Hkv=2,N=70,D=32;
+  Tensor Q = Tensor::randn({B,H,N,D}, 1);
+  Tensor K = Tensor::randn({B,Hkv,N,D}, 2), V = Tensor::randn({B,Hkv,N,D}, 3);
+  PaddingBitmask pad = PaddingBitmask::from_lengths({70, 41}, N);
+  AttentionMask mask; mask.padding = &pad;
+  for (int threads : {1, 3}) {
+    AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.causal = true;
+    opts.block_q = 16; opts.block_k = 16; opts.num_threads = threads;
+    Tensor want = attention_forward(Q.view(), K.view(), V.view(), mask, opts);
+
+    // views carry their shape vectors, so they are made before counting
+    Tensor out = Tensor::zeros({B,H,N,D});
+    const ConstTensorView q = Q.view(), k = K.view(), v = V.view();
+    const TensorView o = out.view();
+    AttentionWorkspace ws(attention_workspace_size(q, k, mask, opts));
+    const size_t cap = ws.capacity();
+    attention_forward(q, k, v, mask, opts, o, ws);   // warm-up
+    const int n = allocations_during([&] {
+      for (int r=0; r<5; ++r) attention_forward(q, k, v, mask, opts, o, ws);
+    });
+    EXPECT_EQ(n, 0) << "threads=" << threads;
+    EXPECT_EQ(ws.capacity(), cap);
+    EXPECT_EQ(0, std::memcmp(want.data(), out.data(), sizeof(float)*(size_t)want.numel())) << "threads=" << threads;
+  }
+}
+
+// 2) out may be strided, e.g. a (B,N,H,D) buffer; an empty workspace grows once
+TEST(AttentionWorkspace, StridedOutputAndGrowth) {
+  const int B=1,H=3,N=29,D=8;
+  Tensor Q = Tensor::randn({B,H,N,D}, 4), K = Tensor::randn({B,H,N,D}, 5), V = Tensor::randn({B,H,N,D}, 6);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_q = 8; opts.block_k = 8;
+  Tensor want = attention_forward(Q.view(), K.view(), V.view(), AttentionMask{}, opts);
+
+  Tensor bnhd = Tensor::zeros({B,N,H,D});
+  TensorView out = bnhd.view().transpose(1,2);
+  AttentionWorkspace ws;
+  EXPECT_EQ(ws.capacity(), 0u);
+  attention_forward(Q.view(), K.view(), V.view(), AttentionMask{}, opts, out, ws);
+  EXPECT_EQ(ws.capacity(), attention_workspace_size(Q.view(), K.view(), AttentionMask{}, opts));
+  for (int h=0;h<H;++h) for (int i=0;i<N;++i) for (int d=0;d<D;++d)
+    ASSERT_EQ(out.at(0,h,i,d), want.at(0,h,i,d)) << h << "," << i << "," << d;
+}
+
+// 3) Shape and stride checks on out
+TEST(AttentionWorkspace, BadOutputThrows) {
+  Tensor Q = Tensor::randn({1,2,6,4}, 7);
+  AttentionWorkspace ws;
+  Tensor small = Tensor::zeros({1,2,5,4});
+  EXPECT_THROW(attention_forward(Q.view(), Q.view(), Q.view(), AttentionMask{}, AttentionOpts{}, small.view(), ws),
+               std::invalid_argument);
+  Tensor dn = Tensor::zeros({1,2,4,6});
+  EXPECT_THROW(attention_forward(Q.view(), Q.view(), Q.view(), AttentionMask{}, AttentionOpts{},
+                                 dn.view().transpose(2,3), ws),
+               std::invalid_argument);
+}
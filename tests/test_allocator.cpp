@@ -0,0 +1,75 @@
+#include "gtest/gtest.h"
+#include "fa/allocator.hpp"
+#include "fa/tensor.hpp"
+#include "fa/attention.hpp"
+#include <atomic>
+#include <cstdint>
+
+using namespace fa;
+
+namespace {
+// Counts calls and forwards to aligned new/delete.
+struct CountingAllocator final : mem::Allocator {
+  std::atomic<int> allocs{0}, frees{0};
+  mem::AlignedAllocator inner;
+  void* allocate(size_t n, size_t a) override { ++allocs; return inner.allocate(n, a); }
+  void deallocate(void* p, size_t n, size_t a) noexcept override { ++frees; inner.deallocate(p, n, a); }
+};
+}
+
+// 1) Tensor storage is 64-byte aligned; zeros / uninitialized constructors
+TEST(Allocator, TensorStorageAlignedAndZeroed) {
+  for (int n : {1, 3, 17, 1000}) {
+    Tensor z = Tensor::zeros({1,1,n,3});
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(z.data()) % mem::kAlignment, 0u);
+    for (long long i=0;i<z.numel();++i) ASSERT_EQ(z.at_index(i), 0.0f);
+    Tensor e = Tensor::empty({1,1,n,3});
+    EXPECT_EQ(e.numel(), 3LL*n);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(e.data()) % mem::kAlignment, 0u);
+  }
+}
+
+// 2) Repeated same-shape attention calls are served from the pool
+TEST(Allocator, RepeatedCallsReusePoolBlocks) {
+  Tensor Q = Tensor::randn({1,2,32,16}, 1);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled;
+  (void)attention_forward(Q,Q,Q,nullptr,opts);      // warm the size classes
+  const auto before = mem::builtin_pool().stats();
+  for (int r=0;r<10;++r) (void)attention_forward(Q,Q,Q,nullptr,opts);
+  const auto after = mem::builtin_pool().stats();
+  EXPECT_EQ(after.misses, before.misses);
+  EXPECT_GE(after.hits, before.hits + 10);
+}
+
+// 3) A pluggable allocator sees every tensor allocation, copies included
+TEST(Allocator, PluggableDefaultAllocator) {
+  CountingAllocator counting;
+  mem::Allocator* prev = mem::set_default_allocator(&counting);
+  {
+    Tensor a({2,3});
+    Tensor b = a;
+    Tensor c({4}, &mem::builtin_pool());   // explicit allocator bypasses the default
+    EXPECT_EQ(counting.allocs.load(), 2);
+  }
+  EXPECT_EQ(counting.frees.load(), 2);
+  mem::set_default_allocator(prev);
+}
+
+// 4) Pool keeps separate size classes, honours its cache cap and release()
+TEST(Allocator, PoolSizeClassesAndRelease) {
+  mem::PoolAllocator pool(/*max_block=*/1 << 20, /*max_cached=*/1 << 12);
+  void* a = pool.allocate(100, 64);
+  void* b = pool.allocate(4000, 64);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0u);
+  pool.deallocate(a, 100, 64);
+  pool.deallocate(b, 4000, 64);           // 4 KiB class would exceed the cap
+  EXPECT_EQ(pool.stats().cached_bytes, 128u);
+  void* c = pool.allocate(120, 64);       // same 128 B class -> hit
+  EXPECT_EQ(c, a);
+  EXPECT_EQ(pool.stats().hits, 1u);
+  pool.deallocate(c, 120, 64);
+  void* big = pool.allocate(2 << 20, 64); // above max_block -> direct
+  pool.deallocate(big, 2 << 20, 64);
+  pool.release();
+  EXPECT_EQ(pool.stats().cached_bytes, 0u);
+}
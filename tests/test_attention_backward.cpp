@@ -0,0 +1,151 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/mask.hpp"
+#include "fa/tensor.hpp"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace fa;
+
+// L = sum(dO * attention_forward(Q,K,V)), in double
+static double loss(const Tensor& Q, const Tensor& K, const Tensor& V, const Tensor& dO,
+                   const AttentionMask& mask, const AttentionOpts& opts) {
+  Tensor O = attention_forward(Q.view(), K.view(), V.view(), mask, opts);
+  double s = 0.0;
+  for (long long k=0;k<O.numel();++k) s += (double)O.data()[k]*dO.data()[k];
+  return s;
+}
+
+// Central differences of L against every element of X (one of Q/K/V).
+static void expect_grad(Tensor& X, const Tensor& analytic, const Tensor& Q, const Tensor& K,
+                        const Tensor& V, const Tensor& dO, const AttentionMask& mask,
+                        const AttentionOpts& opts, const char* name) {
+  const float eps = 1e-2f;
+  for (long long k=0;k<X.numel();++k) {
+    const float x = X.data()[k];
+    X.data()[k] = x + eps; const double lp = loss(Q,K,V,dO,mask,opts);
+    X.data()[k] = x - eps; const double lm = loss(Q,K,V,dO,mask,opts);
+    X.data()[k] = x;
+    const double fd = (lp - lm) / (2.0*eps);
+    EXPECT_NEAR(analytic.data()[k], fd, 2e-3 + 2e-2*std::fabs(fd)) << name << "[" << k << "]";
+  }
+}
+
+static void check_gradients(int B, int H, int Hkv, int N, int D, const AttentionMask& mask,
+                            const AttentionOpts& opts, int Nk = 0) {
+  if (Nk == 0) Nk = N;
+  Tensor Q = Tensor::randn({B,H,N,D}, 1);
+  Tensor K = Tensor::randn({B,Hkv,Nk,D}, 2);
+  Tensor V = Tensor::randn({B,Hkv,Nk,D}, 3);
+  Tensor dO = Tensor::randn({B,H,N,D}, 4);
+  Tensor lse;
+  Tensor O = attention_forward(Q.view(), K.view(), V.view(), mask, opts, &lse);
+  AttentionGrads g = attention_backward(Q.view(), K.view(), V.view(), O.view(), dO.view(),
+                                        lse.view(), mask, opts);
+  ASSERT_EQ(g.dQ.shape(), Q.shape());
+  ASSERT_EQ(g.dK.shape(), K.shape());
+  ASSERT_EQ(g.dV.shape(), V.shape());
+  expect_grad(Q, g.dQ, Q, K, V, dO, mask, opts, "dQ");
+  expect_grad(K, g.dK, Q, K, V, dO, mask, opts, "dK");
+  expect_grad(V, g.dV, Q, K, V, dO, mask, opts, "dV");
+}
+
+// 1) Finite differences, plain attention with small tiles (several blocks)
+TEST(AttentionBackward, FiniteDifferences_B2H2N11D4) {
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_q = 4; opts.block_k = 3;
+  check_gradients(2, 2, 2, 11, 4, AttentionMask{}, opts);
+}
+
+// 2) Causal + GQA + padding + temperature
+TEST(AttentionBackward, FiniteDifferences_CausalGqaPadded) {
+  PaddingBitmask pad = PaddingBitmask::from_lengths({9, 6}, 9);
+  AttentionMask mask; mask.padding = &pad;
+  AttentionOpts opts; opts.causal = true; opts.temperature = 1.7f;
+  opts.block_q = 2; opts.block_k = 4;
+  check_gradients(2, 4, 2, 9, 4, mask, opts);
+}
+
+// 3) Sliding window and block-sparse layout
+TEST(AttentionBackward, FiniteDifferences_WindowAndBlockSparse) {
+  AttentionOpts opts; opts.window = 3; opts.block_q = 4; opts.block_k = 4;
+  check_gradients(1, 2, 1, 10, 4, AttentionMask{}, opts);
+
+  BlockSparseMask blocks(4, 4, 3, 3, {1,0,0, 1,1,0, 0,1,1});
+  AttentionMask mask; mask.blocks = &blocks;
+  AttentionOpts sparse; sparse.engine = AttentionEngine::Tiled;
+  check_gradients(1, 2, 2, 12, 4, mask, sparse);
+}
+
+// 4) Dropout: the same seed drops the same entries in both directions
+TEST(AttentionBackward, FiniteDifferences_Dropout) {
+  AttentionOpts opts; opts.dropout_prob = 0.3f; opts.dropout_seed = 11;
+  opts.engine = AttentionEngine::Tiled; opts.block_q = 4; opts.block_k = 4;
+  check_gradients(1, 2, 2, 10, 4, AttentionMask{}, opts);
+}
+
+// 4b) Cross-attention: N_q != N_k, causal from the bottom-right
+TEST(AttentionBackward, FiniteDifferences_CrossAttention) {
+  PaddingBitmask pad = PaddingBitmask::from_lengths({11}, 11);
+  AttentionMask mask; mask.padding = &pad;
+  AttentionOpts opts; opts.causal = true; opts.block_q = 2; opts.block_k = 4;
+  check_gradients(1, 2, 1, 5, 4, mask, opts, 11);
+  opts.causal = false; opts.window = 3;
+  check_gradients(1, 2, 2, 9, 4, AttentionMask{}, opts, 6);
+}
+
+// 5) lse: both engines agree and match log(sum(exp(logits))); masked rows -inf
+TEST(AttentionBackward, LseMatchesDirectAndEngines) {
+  const int B=2,H=2,N=37,D=8;
+  Tensor Q = Tensor::randn({B,H,N,D}, 5), K = Tensor::randn({B,H,N,D}, 6), V = Tensor::randn({B,H,N,D}, 7);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  for (int j=0;j<N;++j) M.at(0,0,0,j) = 1.0f;   // batch 1 fully masked
+  AttentionOpts opts; opts.causal = true; opts.temperature = 2.0f;
+  Tensor lr, lt;
+  attention_forward(Q, K, V, &M, opts, &lr);
+  opts.engine = AttentionEngine::Tiled; opts.block_q = 8; opts.block_k = 16;
+  attention_forward(Q, K, V, &M, opts, &lt);
+  ASSERT_EQ(lr.shape(), (std::vector<int>{B,H,N}));
+  auto at = [&](const Tensor& L, int b, int h, int i) { return L.data()[((size_t)b*H + h)*N + i]; };
+  for (int h=0;h<H;++h) for (int i=0;i<N;++i) {
+    double s = 0.0;
+    for (int j=0;j<=i;++j) {
+      double dot = 0.0;
+      for (int d=0;d<D;++d) dot += (double)Q.at(0,h,i,d)*K.at(0,h,j,d);
+      s += std::exp(dot / 2.0);
+    }
+    EXPECT_NEAR(at(lr,0,h,i), std::log(s), 1e-4);
+    EXPECT_NEAR(at(lt,0,h,i), std::log(s), 1e-4);
+    EXPECT_TRUE(std::isinf(at(lt,1,h,i)) && at(lt,1,h,i) < 0.0f);
+    EXPECT_TRUE(std::isinf(at(lr,1,h,i)) && at(lr,1,h,i) < 0.0f);
+  }
+}
+
+// 6) Gradients are bitwise identical for any thread count
+TEST(AttentionBackward, ThreadCountInvariant) {
+  const int B=2,H=4,N=50,D=16;
+  Tensor Q = Tensor::randn({B,H,N,D}, 8), K = Tensor::randn({B,2,N,D}, 9), V = Tensor::randn({B,2,N,D}, 10);
+  Tensor dO = Tensor::randn({B,H,N,D}, 11);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.causal = true;
+  opts.block_q = 8; opts.block_k = 8; opts.dropout_prob = 0.1f;
+  Tensor lse;
+  Tensor O = attention_forward(Q, K, V, nullptr, opts, &lse);
+  AttentionGrads s = attention_backward(Q, K, V, O, dO, lse, nullptr, opts);
+  for (int t : {3, 0}) {
+    opts.num_threads = t;
+    AttentionGrads p = attention_backward(Q, K, V, O, dO, lse, nullptr, opts);
+    for (auto [a, b] : {std::pair{&s.dQ, &p.dQ}, {&s.dK, &p.dK}, {&s.dV, &p.dV}})
+      EXPECT_EQ(0, std::memcmp(a->data(), b->data(), sizeof(float)*(size_t)a->numel())) << "threads=" << t;
+  }
+}
+
+// 7) Shape checks
+TEST(AttentionBackward, MismatchedShapesThrow) {
+  Tensor Q = Tensor::randn({1,2,6,4}, 12);
+  Tensor lse;
+  Tensor O = attention_forward(Q, Q, Q, nullptr, AttentionOpts{}, &lse);
+  Tensor bad = Tensor::zeros({1,2,5,4});
+  EXPECT_THROW(attention_backward(Q, Q, Q, O, bad, lse, nullptr, AttentionOpts{}), std::invalid_argument);
+  Tensor bad_lse = Tensor::zeros({1,2,6,1});
+  EXPECT_THROW(attention_backward(Q, Q, Q, O, O, bad_lse, nullptr, AttentionOpts{}), std::invalid_argument);
+}
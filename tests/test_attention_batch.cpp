@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/mask.hpp"
+#include "fa/tensor.hpp"
+#include <cstring>
+#include <vector>
+
+using namespace fa;
+
+static bool bitwise_equal(const Tensor& A, const Tensor& B) {
+  return A.shape()==B.shape() &&
+         std::memcmp(A.data(), B.data(), sizeof(float)*(size_t)A.numel())==0;
+}
+
+// 1) Mixed shapes, GQA, masks and options: each result equals its own call
+TEST(AttentionBatch, MatchesSingleCalls_MixedShapes) {
+  std::vector<Tensor> qs, ks, vs;
+  PaddingBitmask pad = PaddingBitmask::from_lengths({20, 13}, 20);
+  BlockSparseMask blocks(8, 8, 3, 3, {1,0,0, 1,1,0, 0,1,1});
+  struct Shape { int B, H, Hkv, N, D; };
+  const std::vector<Shape> shapes = {{1,4,4,7,16}, {2,8,2,20,32}, {1,2,1,33,16}, {2,4,4,20,64}, {1,2,2,24,16}};
+  for (size_t k=0; k<shapes.size(); ++k) {
+    const Shape s = shapes[k];
+    qs.push_back(Tensor::randn({s.B,s.H,s.N,s.D}, 10*k+1));
+    ks.push_back(Tensor::randn({s.B,s.Hkv,s.N,s.D}, 10*k+2));
+    vs.push_back(Tensor::randn({s.B,s.Hkv,s.N,s.D}, 10*k+3));
+  }
+  std::vector<AttentionProblem> problems(shapes.size());
+  for (size_t k=0; k<shapes.size(); ++k) {
+    problems[k].Q = qs[k].view(); problems[k].K = ks[k].view(); problems[k].V = vs[k].view();
+    problems[k].opts.block_q = 8; problems[k].opts.block_k = 16;
+  }
+  problems[1].opts.causal = true;
+  problems[1].mask.padding = &pad;
+  problems[2].opts.window = 5;
+  problems[2].opts.temperature = 3.0f;
+  problems[3].mask.padding = &pad;
+  problems[3].opts.dropout_prob = 0.2f;
+  problems[4].mask.blocks = &blocks;
+
+  for (int threads : {1, 3, 0}) {
+    std::vector<Tensor> out = attention_forward_batch(problems, threads);
+    ASSERT_EQ(out.size(), problems.size());
+    for (size_t k=0; k<problems.size(); ++k) {
+      AttentionOpts opts = problems[k].opts;
+      opts.engine = AttentionEngine::Tiled; opts.kv_splits = 1;
+      Tensor ref = attention_forward(problems[k].Q, problems[k].K, problems[k].V, problems[k].mask, opts);
+      EXPECT_TRUE(bitwise_equal(ref, out[k])) << "problem " << k << " threads " << threads;
+    }
+  }
+}
+
+// 2) Empty batch and error reporting with the problem index
+TEST(AttentionBatch, EmptyAndInvalid) {
+  EXPECT_TRUE(attention_forward_batch({}, 2).empty());
+  Tensor Q = Tensor::randn({1,2,5,4}, 1), K = Tensor::randn({1,2,5,8}, 2);
+  std::vector<AttentionProblem> problems(2);
+  problems[0].Q = problems[0].K = problems[0].V = Q.view();
+  problems[1].Q = Q.view(); problems[1].K = problems[1].V = K.view();
+  try {
+    attention_forward_batch(problems);
+    FAIL() << "expected std::invalid_argument";
+  } catch (const std::invalid_argument& e) {
+    EXPECT_NE(std::string(e.what()).find("problem 1"), std::string::npos) << e.what();
+  }
+  problems[1] = problems[0];
+  problems[1].opts.kv_splits = 2;   // batches never split the keys
+  EXPECT_THROW(attention_forward_batch(problems), std::invalid_argument);
+}
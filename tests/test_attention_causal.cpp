@@ -63,4 +63,32 @@ TEST(AttentionCausal, CausalPlusPaddingMask) {
   AttentionOpts opts; opts.causal = true;
   Tensor O = attention_forward(Q,K,V,&M,opts); // F2P on base
   EXPECT_TRUE(all_finite(O));
-}
\ No newline at end of file
+}
+
+// 5) Tiled causal skips tiles above the diagonal: every tile shape (diagonal
+//    crossing mid-tile, Br != Bc, tiles larger than N) matches the reference,
+//    and the triangular work order is bitwise thread-count independent
+TEST(AttentionCausal, TiledBlockSkippingMatchesReference_B2H2N77D12) {
+  const int B=2,H=2,N=77,D=12;
+  Tensor Q = Tensor::randn({B,H,N,D}, 31);
+  Tensor K = Tensor::randn({B,H,N,D}, 32);
+  Tensor V = Tensor::randn({B,H,N,D}, 33);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  for (int b=0;b<B;++b) for (int j=0;j<N;++j) M.at(b,0,0,j) = (b==1 && j<5) ? 0.0f : 1.0f;  // early rows of b=1 see nothing
+
+  AttentionOpts opts; opts.causal = true; opts.temperature = 0.7f;
+  Tensor R = attention_forward(Q,K,V,&M,opts);
+  opts.engine = AttentionEngine::Tiled;
+  const int shapes[][2] = {{16,16}, {8,32}, {32,8}, {7,13}, {1,5}, {128,128}};
+  for (const auto& bs : shapes) {
+    opts.block_q = bs[0]; opts.block_k = bs[1]; opts.num_threads = 1;
+    Tensor T1 = attention_forward(Q,K,V,&M,opts);
+    opts.num_threads = 3;
+    Tensor T3 = attention_forward(Q,K,V,&M,opts);
+    for (long long i=0;i<R.numel();++i) {
+      ASSERT_NEAR(T1.at_index(i), R.at_index(i), 1e-5f) << bs[0] << "x" << bs[1];
+      ASSERT_EQ(T1.at_index(i), T3.at_index(i));
+    }
+    for (int d=0; d<D; ++d) EXPECT_EQ(T1.at(1,0,3,d), 0.0f);
+  }
+}
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/mask.hpp"
+#include "fa/tensor.hpp"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace fa;
+
+// Rows [r0, r0+n) of a (B,H,N,D) tensor as a new (B,H,n,D) tensor.
+static Tensor rows(const Tensor& X, int r0, int n) {
+  return Tensor::from(X.view().slice(2, r0, n));
+}
+
+// 1) N_q != N_k: tiled matches the reference, with GQA and key padding
+TEST(AttentionCross, TiledMatchesReference_NqNeNk) {
+  const int B=2,H=4,Hkv=2,D=16;
+  for (auto [Nq, Nk] : {std::pair{7, 93}, {40, 13}, {1, 70}}) {
+    Tensor Q = Tensor::randn({B,H,Nq,D}, 1);
+    Tensor K = Tensor::randn({B,Hkv,Nk,D}, 2), V = Tensor::randn({B,Hkv,Nk,D}, 3);
+    Tensor M = Tensor::zeros({B,1,1,Nk});
+    for (int b=0;b<B;++b) for (int j=0;j<Nk;++j) M.at(b,0,0,j) = (b==1 && j%5==2) ? 0.0f : 1.0f;
+    for (bool causal : {false, true}) {
+      AttentionOpts opts; opts.causal = causal;
+      Tensor R = attention_forward(Q,K,V,&M,opts);
+      ASSERT_EQ(R.shape(), Q.shape());
+      opts.engine = AttentionEngine::Tiled; opts.block_q = 8; opts.block_k = 16;
+      Tensor T = attention_forward(Q,K,V,&M,opts);
+      for (long long i=0;i<R.numel();++i)
+        ASSERT_NEAR(T.data()[i], R.data()[i], 1e-5) << "Nq=" << Nq << " Nk=" << Nk << " causal=" << causal << " @" << i;
+    }
+  }
+}
+
+// 2) Chunked causal prefill (each chunk over its whole prefix) reproduces
+//    the rows of full prefill, for both engines
+TEST(AttentionCross, ChunkedPrefillMatchesFullPrefill) {
+  const int B=1,H=2,N=75,D=8,chunk=20;
+  Tensor Q = Tensor::randn({B,H,N,D}, 4), K = Tensor::randn({B,H,N,D}, 5), V = Tensor::randn({B,H,N,D}, 6);
+  for (auto engine : {AttentionEngine::Reference, AttentionEngine::Tiled}) {
+    AttentionOpts opts; opts.causal = true; opts.engine = engine; opts.block_q = 8; opts.block_k = 16;
+    opts.dropout_prob = 0.2f; opts.dropout_seed = 3;
+    Tensor full = attention_forward(Q,K,V,nullptr,opts);
+    for (int r0=0; r0<N; r0+=chunk) {
+      const int n = std::min(chunk, N - r0);
+      Tensor O = attention_forward(rows(Q, r0, n), rows(K, 0, r0 + n), rows(V, 0, r0 + n), nullptr, opts);
+      Tensor want = rows(full, r0, n);
+      for (long long i=0;i<O.numel();++i)
+        ASSERT_NEAR(O.data()[i], want.data()[i], 1e-6) << "chunk " << r0 << " @" << i;
+    }
+  }
+}
+
+// 3) Bottom-right alignment: with N_q > N_k the first N_q - N_k causal rows
+//    see no key and are zero; window bands are measured from the same place
+TEST(AttentionCross, BottomRightAlignment) {
+  const int Nq=12,Nk=5,D=4;
+  Tensor Q = Tensor::randn({1,1,Nq,D}, 7), K = Tensor::randn({1,1,Nk,D}, 8), V = Tensor::randn({1,1,Nk,D}, 9);
+  AttentionOpts opts; opts.causal = true; opts.engine = AttentionEngine::Tiled; opts.block_q = 4; opts.block_k = 2;
+  Tensor lse;
+  Tensor O = attention_forward(Q,K,V,nullptr,opts,&lse);
+  for (int i=0;i<Nq;++i) {
+    const bool empty = i < Nq - Nk;
+    EXPECT_EQ(std::isinf(lse.data()[i]), empty) << i;
+    if (empty) for (int d=0;d<D;++d) EXPECT_EQ(O.at(0,0,i,d), 0.0f);
+  }
+  // the last query sees every key: plain softmax over all of them
+  Tensor last = attention_forward(rows(Q, Nq-1, 1), K, V, nullptr, AttentionOpts{});
+  for (int d=0;d<D;++d) EXPECT_NEAR(O.at(0,0,Nq-1,d), last.at(0,0,0,d), 1e-6);
+
+  opts.causal = false; opts.window = 2;
+  Tensor T = attention_forward(Q,K,V,nullptr,opts);
+  opts.engine = AttentionEngine::Reference;
+  Tensor R = attention_forward(Q,K,V,nullptr,opts);
+  for (long long i=0;i<R.numel();++i) ASSERT_NEAR(T.data()[i], R.data()[i], 1e-6) << i;
+}
+
+// 4) Masks follow the key length
+TEST(AttentionCross, MaskCoversKeys) {
+  Tensor Q = Tensor::randn({1,1,3,4}, 10), K = Tensor::randn({1,1,9,4}, 11);
+  Tensor short_mask = Tensor::zeros({1,1,1,3});
+  EXPECT_THROW(attention_forward(Q,K,K,&short_mask,AttentionOpts{}), std::invalid_argument);
+  Tensor key_mask = Tensor::zeros({1,1,1,9});
+  for (int j=0;j<9;++j) key_mask.at(0,0,0,j) = 1.0f;
+  EXPECT_NO_THROW(attention_forward(Q,K,K,&key_mask,AttentionOpts{}));
+  PaddingBitmask pad = PaddingBitmask::from_lengths({3}, 3);
+  AttentionMask m; m.padding = &pad;
+  EXPECT_THROW(attention_forward(Q.view(),K.view(),K.view(),m,AttentionOpts{}), std::invalid_argument);
+  // the public validator checks against K's key count as well
+  EXPECT_NO_THROW(mask::validate_padding_mask_b11n(K, key_mask));
+  EXPECT_THROW(mask::validate_padding_mask_b11n(K, short_mask), std::invalid_argument);
+}
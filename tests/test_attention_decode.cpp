@@ -0,0 +1,127 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/kv_cache.hpp"
+#include "fa/tensor.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace fa;
+
+// Plain softmax(q.k / temp) v over the first L rows of K/V for one (b,h) row.
+static std::vector<float> naive_row(const Tensor& Q, int b, int h, int i,
+                                    const Tensor& K, const Tensor& V, int L, float temp) {
+  const int D = Q.dim(3);
+  std::vector<double> w(L);
+  double m = -INFINITY, sum = 0;
+  for (int j=0;j<L;++j) {
+    double s = 0; for (int d=0;d<D;++d) s += (double)Q.at(b,h,i,d)*K.at(b,h,j,d);
+    w[j] = s / temp; m = std::max(m, w[j]);
+  }
+  for (int j=0;j<L;++j) { w[j] = std::exp(w[j]-m); sum += w[j]; }
+  std::vector<float> o(D, 0.0f);
+  for (int d=0;d<D;++d) { double a = 0; for (int j=0;j<L;++j) a += w[j]*V.at(b,h,j,d); o[d] = (float)(a/sum); }
+  return o;
+}
+
+// 1) Token-by-token causal decode reproduces the full causal forward pass
+TEST(AttentionDecode, StepwiseMatchesFullCausal_B2H2N37D16) {
+  const int B=2,H=2,N=37,D=16;
+  Tensor Q = Tensor::randn({B,H,N,D}, 1);
+  Tensor K = Tensor::randn({B,H,N,D}, 2);
+  Tensor V = Tensor::randn({B,H,N,D}, 3);
+  AttentionOpts opts; opts.causal = true; opts.temperature = 1.3f;
+  Tensor R = attention_forward(Q,K,V,nullptr,opts);
+
+  KVCache cache(B,H,D,8);
+  for (int t=0;t<N;++t) {
+    cache.append(K.view().slice(2,t,1), V.view().slice(2,t,1));
+    Tensor O = attention_decode(Q.view().slice(2,t,1), cache, opts);
+    ASSERT_EQ(O.shape(), (std::vector<int>{B,H,1,D}));
+    for (int b=0;b<B;++b) for (int h=0;h<H;++h) for (int d=0;d<D;++d)
+      ASSERT_NEAR(O.at(b,h,0,d), R.at(b,h,t,d), 1e-5f) << "t=" << t;
+  }
+  EXPECT_EQ(cache.length(0), N);
+  EXPECT_EQ(cache.pages_in_use(), (size_t)B*((N+7)/8));
+}
+
+// 2) Prefill then a multi-token step; causal is bottom-right aligned, and
+//    the non-causal step sees every cached key
+TEST(AttentionDecode, MultiTokenStepAfterPrefill) {
+  const int B=1,H=3,N=29,D=24,P=16,T=5;
+  Tensor Q = Tensor::randn({B,H,N,D}, 4);
+  Tensor K = Tensor::randn({B,H,N,D}, 5);
+  Tensor V = Tensor::randn({B,H,N,D}, 6);
+  AttentionOpts opts; opts.causal = true;
+  Tensor R = attention_forward(Q,K,V,nullptr,opts);
+
+  KVCache cache(B,H,D,P);
+  cache.append(K.view().slice(2,0,N-T), V.view().slice(2,0,N-T));
+  cache.append(K.view().slice(2,N-T,T), V.view().slice(2,N-T,T));
+  const ConstTensorView q = Q.view().slice(2,N-T,T);
+  Tensor O = attention_decode(q, cache, opts);
+  for (int h=0;h<H;++h) for (int t=0;t<T;++t) for (int d=0;d<D;++d)
+    EXPECT_NEAR(O.at(0,h,t,d), R.at(0,h,N-T+t,d), 1e-5f);
+
+  opts.causal = false; opts.num_threads = 2;
+  Tensor F = attention_decode(q, cache, opts);
+  for (int h=0;h<H;++h) for (int t=0;t<T;++t) {
+    const std::vector<float> ref = naive_row(Q,0,h,N-T+t,K,V,N,1.0f);
+    for (int d=0;d<D;++d) EXPECT_NEAR(F.at(0,h,t,d), ref[d], 1e-5f);
+  }
+}
+
+// 3) Ragged batch rows: each row attends over its own cached length
+TEST(AttentionDecode, RaggedRowsAndEmptyRow) {
+  const int B=3,H=2,D=8,P=4;
+  Tensor K = Tensor::randn({B,H,11,D}, 7);
+  Tensor V = Tensor::randn({B,H,11,D}, 8);
+  Tensor Q = Tensor::randn({B,H,1,D}, 9);
+  KVCache cache(B,H,D,P);
+  cache.append(0, K.view().slice(0,0,1).slice(2,0,11), V.view().slice(0,0,1).slice(2,0,11));
+  cache.append(1, K.view().slice(0,1,1).slice(2,0,3), V.view().slice(0,1,1).slice(2,0,3));
+  EXPECT_EQ(cache.length(0), 11);
+  EXPECT_EQ(cache.length(1), 3);
+  EXPECT_EQ(cache.length(2), 0);
+  EXPECT_EQ(cache.max_length(), 11);
+
+  AttentionOpts opts;
+  Tensor O = attention_decode(Q.view(), cache, opts);
+  for (int h=0;h<H;++h) {
+    const std::vector<float> r0 = naive_row(Q,0,h,0,K,V,11,1.0f);
+    const std::vector<float> r1 = naive_row(Q,1,h,0,K,V,3,1.0f);
+    for (int d=0;d<D;++d) {
+      EXPECT_NEAR(O.at(0,h,0,d), r0[d], 1e-5f);
+      EXPECT_NEAR(O.at(1,h,0,d), r1[d], 1e-5f);
+      EXPECT_EQ(O.at(2,h,0,d), 0.0f);   // nothing cached: zeros
+    }
+  }
+}
+
+// 4) Pages are reused after reset; bad shapes and premature causal decode throw
+TEST(AttentionDecode, PageReuseAndValidation) {
+  const int B=2,H=2,D=4,P=4;
+  Tensor K = Tensor::randn({B,H,10,D}, 10);
+  Tensor V = Tensor::randn({B,H,10,D}, 11);
+  KVCache cache(B,H,D,P);
+  cache.append(K.view(), V.view());
+  EXPECT_EQ(cache.pages_in_use(), 6u);
+  const size_t reserved = cache.bytes_reserved();
+  cache.reset(0);
+  EXPECT_EQ(cache.length(0), 0);
+  EXPECT_EQ(cache.pages_in_use(), 3u);
+  cache.append(0, K.view().slice(0,0,1), V.view().slice(0,0,1));
+  EXPECT_EQ(cache.bytes_reserved(), reserved);   // no new pages
+  cache.clear();
+  EXPECT_EQ(cache.pages_in_use(), 0u);
+  cache.append(K.view().slice(2,0,2), V.view().slice(2,0,2));
+
+  AttentionOpts opts; opts.causal = true;
+  Tensor Q3 = Tensor::randn({B,H,3,D}, 12);
+  EXPECT_THROW(attention_decode(Q3.view(), cache, opts), std::invalid_argument);  // T > length
+  EXPECT_THROW(attention_decode(Tensor::randn({B,H+1,1,D}, 13).view(), cache, opts), std::invalid_argument);
+  EXPECT_THROW(attention_decode(Tensor::randn({B,H,1,D+1}, 14).view(), cache, opts), std::invalid_argument);
+  EXPECT_THROW(cache.append(Tensor::randn({B,H,1,D+1}, 15).view(), Tensor::randn({B,H,1,D+1}, 16).view()),
+               std::invalid_argument);
+  EXPECT_THROW(cache.append(2, K.view().slice(0,0,1), V.view().slice(0,0,1)), std::out_of_range);
+  EXPECT_THROW(KVCache(1,1,4,0), std::invalid_argument);
+}
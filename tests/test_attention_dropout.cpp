@@ -1,6 +1,10 @@
 #include "gtest/gtest.h"
 #include "fa/tensor.hpp"
 #include "fa/attention.hpp"
+#include "fa/random.hpp"
+#include <cmath>
+#include <cstring>
+#include <limits>
 using namespace fa;
 
 // 1) Invalid dropout_prob < 0
@@ -21,14 +25,21 @@ TEST(AttentionDropout, GreaterThanOneThrows) {
   EXPECT_THROW(attention_forward(Q,K,V,nullptr,opts), std::invalid_argument);
 }
 
-// 3) Valid range [0,1] → no-op (P2P)
-TEST(AttentionDropout, ValidRangeNoChange) {
+// 3) Valid p actually drops: output differs from p = 0 and stays finite
+TEST(AttentionDropout, ValidRangeDropsWeights) {
   Tensor Q = Tensor::randn({1,1,4,4}, 10);
   Tensor K = Q;
   Tensor V = Tensor::randn({1,1,4,4}, 11);
-  AttentionOpts opts; opts.dropout_prob = 0.5f;
+  AttentionOpts opts;
+  Tensor O0 = attention_forward(Q,K,V,nullptr,opts);
+  opts.dropout_prob = 0.5f;
   Tensor O = attention_forward(Q,K,V,nullptr,opts);
-  EXPECT_TRUE(std::isfinite(O.at(0,0,0,0)));
+  float diff = 0.0f;
+  for (long long k=0;k<O.numel();++k) {
+    EXPECT_TRUE(std::isfinite(O.data()[k]));
+    diff = std::max(diff, std::fabs(O.data()[k] - O0.data()[k]));
+  }
+  EXPECT_GT(diff, 1e-3f);
 }
 
 // 4) NaN dropout_prob should also throw
@@ -43,3 +54,73 @@ TEST(AttentionDropout, InvalidNaNProbThrows) {
   EXPECT_THROW(attention_forward(Q,K,V,nullptr,opts), std::invalid_argument);
 }
 
+
+static float max_abs_diff(const Tensor& A, const Tensor& B) {
+  float m = 0.0f;
+  for (long long k=0;k<A.numel();++k) m = std::max(m, std::fabs(A.data()[k]-B.data()[k]));
+  return m;
+}
+
+// 5) Tiled engine drops exactly the (b,h,i,j) the reference drops
+TEST(AttentionDropout, TiledMatchesReference_CausalGQA) {
+  const int B=2,H=4,N=45,D=8;
+  Tensor Q = Tensor::randn({B,H,N,D}, 40);
+  Tensor K = Tensor::randn({B,2,N,D}, 41);
+  Tensor V = Tensor::randn({B,2,N,D}, 42);
+  AttentionOpts opts; opts.dropout_prob = 0.3f; opts.dropout_seed = 1234; opts.causal = true;
+  Tensor R = attention_forward(Q,K,V,nullptr,opts);
+  opts.engine = AttentionEngine::Tiled;
+  for (int bq : {1, 8, 16}) for (int bk : {4, 16, 64}) {
+    opts.block_q = bq; opts.block_k = bk;
+    EXPECT_LT(max_abs_diff(R, attention_forward(Q,K,V,nullptr,opts)), 1e-4f) << bq << "x" << bk;
+  }
+}
+
+// 6) Same seed: bitwise identical for any thread count; new seed: new mask
+TEST(AttentionDropout, ThreadInvariantAndSeeded) {
+  Tensor Q = Tensor::randn({2,3,64,16}, 50);
+  Tensor K = Tensor::randn({2,3,64,16}, 51);
+  Tensor V = Tensor::randn({2,3,64,16}, 52);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_q = 16; opts.block_k = 16;
+  opts.dropout_prob = 0.2f; opts.dropout_seed = 7;
+  Tensor S = attention_forward(Q,K,V,nullptr,opts);
+  for (int t : {2, 5, 0}) {
+    opts.num_threads = t;
+    Tensor P = attention_forward(Q,K,V,nullptr,opts);
+    EXPECT_EQ(0, std::memcmp(S.data(), P.data(), sizeof(float)*(size_t)S.numel())) << "threads=" << t;
+  }
+  opts.dropout_seed = 8;
+  EXPECT_GT(max_abs_diff(S, attention_forward(Q,K,V,nullptr,opts)), 1e-3f);
+}
+
+// 7) Keep rate is 1 - p and a run of keys matches the per-element decision
+TEST(AttentionDropout, KeepRateAndApplyConsistency) {
+  const float p = 0.25f;
+  fa::rnd::DropoutRng rng(99, p);
+  int kept = 0, total = 0;
+  for (int i=0;i<64;++i) for (int j=0;j<256;++j) { kept += rng.keep(0,1,i,j); ++total; }
+  EXPECT_NEAR(double(kept)/total, 1.0 - p, 0.02);
+
+  std::vector<float> s(37, 1.0f);
+  rng.apply(0, 1, 5, 3, 37, s.data());   // unaligned start and length
+  for (int c=0;c<37;++c)
+    EXPECT_EQ(s[c], rng.keep(0,1,5,3+c) ? rng.scale() : 0.0f) << c;
+}
+
+// 8) Philox randn: thread-count independent with unit moments
+TEST(AttentionDropout, ParallelRandnDeterministic) {
+  const long long n = 100003;
+  std::vector<float> a(n), b(n);
+  fa::rnd::fill_randn(a.data(), n, 5, 1);
+  fa::rnd::fill_randn(b.data(), n, 5, 4);
+  EXPECT_EQ(0, std::memcmp(a.data(), b.data(), sizeof(float)*n));
+  double mean = 0.0, var = 0.0;
+  for (float x : a) { ASSERT_TRUE(std::isfinite(x)); mean += x; }
+  mean /= n;
+  for (float x : a) var += (x-mean)*(x-mean);
+  var /= n;
+  EXPECT_NEAR(mean, 0.0, 0.02);
+  EXPECT_NEAR(var, 1.0, 0.03);
+  Tensor T1 = Tensor::randn({7,11,13}, 5), T2 = Tensor::randn({7,11,13}, 5, 3);
+  EXPECT_EQ(0, std::memcmp(T1.data(), T2.data(), sizeof(float)*(size_t)T1.numel()));
+}
@@ -0,0 +1,105 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/kv_cache.hpp"
+#include "fa/quantize.hpp"
+#include "fa/tensor.hpp"
+#include <cstring>
+#include <vector>
+
+using namespace fa;
+
+// K/V with every head repeated G times: the MHA problem GQA must reproduce.
+template <class T>
+static TensorT<T> repeat_heads(const TensorT<T>& X, int G) {
+  TensorT<T> R({X.dim(0), X.dim(1)*G, X.dim(2), X.dim(3)});
+  for (int b=0;b<X.dim(0);++b) for (int h=0;h<R.dim(1);++h) for (int n=0;n<X.dim(2);++n)
+    for (int d=0;d<X.dim(3);++d) R.at(b,h,n,d) = X.at(b,h/G,n,d);
+  return R;
+}
+
+template <class T>
+static void expect_bitwise(const TensorT<T>& A, const TensorT<T>& B) {
+  ASSERT_EQ(A.shape(), B.shape());
+  for (long long i=0;i<A.numel();++i) ASSERT_EQ(0, std::memcmp(&A.data()[i], &B.data()[i], sizeof(T))) << i;
+}
+
+// 1) GQA and MQA equal MHA on replicated K/V, bitwise, for both engines,
+//    with causal + padding and any thread count
+TEST(AttentionGqa, MatchesReplicatedKv_B2Hq6N70D16) {
+  const int B=2,Hq=6,N=70,D=16;
+  Tensor Q = Tensor::randn({B,Hq,N,D}, 1);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  for (int b=0;b<B;++b) for (int j=0;j<N;++j) M.at(b,0,0,j) = (b==1 && j%7==3) ? 0.0f : 1.0f;
+  for (int Hkv : {3, 2, 1}) {
+    Tensor K = Tensor::randn({B,Hkv,N,D}, 2), V = Tensor::randn({B,Hkv,N,D}, 3);
+    Tensor Kr = repeat_heads(K, Hq/Hkv), Vr = repeat_heads(V, Hq/Hkv);
+    AttentionOpts opts; opts.causal = true;
+    expect_bitwise(attention_forward(Q,K,V,&M,opts), attention_forward(Q,Kr,Vr,&M,opts));
+    opts.engine = AttentionEngine::Tiled; opts.block_q = 16; opts.block_k = 32;
+    Tensor T = attention_forward(Q,K,V,&M,opts);
+    expect_bitwise(T, attention_forward(Q,Kr,Vr,&M,opts));
+    opts.num_threads = 3; opts.block_q = 128;   // one query block: groups get split
+    expect_bitwise(attention_forward(Q,K,V,&M,opts), T);
+  }
+}
+
+// 2) 16-bit and int8 K/V share heads the same way
+TEST(AttentionGqa, LowpAndInt8MatchReplicatedKv) {
+  const int B=1,Hq=4,Hkv=2,N=45,D=24;
+  TensorBF16 Qb = TensorBF16::randn({B,Hq,N,D}, 4);
+  TensorBF16 Kb = TensorBF16::randn({B,Hkv,N,D}, 5), Vb = TensorBF16::randn({B,Hkv,N,D}, 6);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.causal = true;
+  expect_bitwise(attention_forward_bf16(Qb.view(), Kb.view(), Vb.view(), nullptr, opts),
+                 attention_forward_bf16(Qb.view(), repeat_heads(Kb,2).view(), repeat_heads(Vb,2).view(),
+                                        nullptr, opts));
+
+  Tensor Q = cast<float>(Qb), K = cast<float>(Kb), V = cast<float>(Vb);
+  QuantizedTensor Kq = quantize_int8(K, 16), Vq = quantize_int8(V, 16);
+  QuantizedTensor Kqr = quantize_int8(repeat_heads(K,2), 16), Vqr = quantize_int8(repeat_heads(V,2), 16);
+  expect_bitwise(attention_forward_int8(Q.view(), Kq, Vq, nullptr, opts),
+                 attention_forward_int8(Q.view(), Kqr, Vqr, nullptr, opts));
+}
+
+// 3) Decode over a cache with H_kv heads, and packed varlen with H_kv heads
+TEST(AttentionGqa, DecodeAndVarlen) {
+  const int B=2,Hq=8,Hkv=2,N=40,D=8;
+  Tensor Q = Tensor::randn({B,Hq,N,D}, 7);
+  Tensor K = Tensor::randn({B,Hkv,N,D}, 8), V = Tensor::randn({B,Hkv,N,D}, 9);
+  AttentionOpts opts; opts.causal = true;
+  Tensor R = attention_forward(Q,K,V,nullptr,opts);
+
+  KVCache cache(B,Hkv,D,16);
+  cache.append(K.view().slice(2,0,N-1), V.view().slice(2,0,N-1));
+  cache.append(K.view().slice(2,N-1,1), V.view().slice(2,N-1,1));
+  opts.num_threads = 4;
+  Tensor O = attention_decode(Q.view().slice(2,N-1,1), cache, opts);
+  for (int b=0;b<B;++b) for (int h=0;h<Hq;++h) for (int d=0;d<D;++d)
+    EXPECT_NEAR(O.at(b,h,0,d), R.at(b,h,N-1,d), 1e-5f);
+
+  // Batch row b as one packed sequence: (N,H,D) views of the (B,H,N,D) data.
+  const std::vector<int> cu = {0, N};
+  for (int b=0;b<B;++b) {
+    auto packed = [&](const Tensor& X) { return X.view().slice(0,b,1).permute({0,2,1,3}); };
+    auto tok = [&](const Tensor& X) {
+      const ConstTensorView v = packed(X);
+      return ConstTensorView(v.data(), {N, X.dim(1), D}, {v.stride(1), v.stride(2), v.stride(3)});
+    };
+    Tensor Ov = attention_forward_varlen(tok(Q), tok(K), tok(V), cu, opts);
+    for (int n=0;n<N;++n) for (int h=0;h<Hq;++h) for (int d=0;d<D;++d)
+      ASSERT_NEAR(Ov.data()[((size_t)n*Hq + h)*D + d], R.at(b,h,n,d), 1e-5f);
+  }
+}
+
+// 4) H_q must be a multiple of H_kv, and K/V must agree
+TEST(AttentionGqa, HeadCountValidation) {
+  AttentionOpts opts;
+  Tensor Q = Tensor::randn({1,6,8,4}, 10);
+  Tensor K4 = Tensor::randn({1,4,8,4}, 11), K3 = Tensor::randn({1,3,8,4}, 12), K2 = Tensor::randn({1,2,8,4}, 13);
+  EXPECT_THROW(attention_forward(Q,K4,K4,nullptr,opts), std::invalid_argument);
+  EXPECT_THROW(attention_forward(Q,K3,K2,nullptr,opts), std::invalid_argument);
+  EXPECT_NO_THROW(attention_forward(Q,K3,K3,nullptr,opts));
+  KVCache cache(1,4,4);
+  cache.append(K4.view(), K4.view());
+  EXPECT_THROW(attention_decode(Q.view().slice(2,0,1), cache, opts), std::invalid_argument);
+  EXPECT_THROW(attention_forward(K3,Q,Q,nullptr,opts), std::invalid_argument);   // H_kv > H_q
+}
@@ -0,0 +1,126 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/quantize.hpp"
+#include "fa/simd.hpp"
+#include "fa/tensor.hpp"
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace fa;
+
+static float max_abs_diff(const Tensor& A, const Tensor& B) {
+  float m = 0.0f;
+  for (long long i=0;i<A.numel();++i) m = std::max(m, std::fabs(A.at_index(i)-B.at_index(i)));
+  return m;
+}
+
+// 1) Per-block absmax quantization: error <= scale/2, ~4x smaller storage
+TEST(AttentionInt8, QuantizeRoundTripAndStorage) {
+  Tensor X = Tensor::randn({2,3,50,24}, 1);
+  for (int j=0;j<24;++j) X.at(1,2,7,j) = 0.0f;
+  for (int block : {0, 16, 50, 64}) {
+    QuantizedTensor q = quantize_int8(X, block);
+    const int expect_rows = block == 0 ? 50 : std::min(block, 50);
+    EXPECT_EQ(q.block_rows, expect_rows);
+    EXPECT_EQ((int)q.scales.size(), 2*3*q.blocks_per_head());
+    Tensor R = dequantize(q);
+    for (int b=0;b<2;++b) for (int h=0;h<3;++h) for (int n=0;n<50;++n) for (int d=0;d<24;++d) {
+      const int8_t v = q.row(b,h,n)[d];
+      ASSERT_GE(v, -127);
+      ASSERT_LE(std::fabs(R.at(b,h,n,d) - X.at(b,h,n,d)), 0.5f*q.scale(b,h,n) + 1e-7f);
+    }
+    EXPECT_LT(q.bytes(), (size_t)X.numel()*sizeof(float)/3);
+  }
+  Tensor bad = Tensor::randn({1,1,4,4}, 2);
+  bad.at(0,0,1,1) = NAN;
+  EXPECT_THROW(quantize_int8(bad), std::invalid_argument);
+  EXPECT_THROW(quantize_int8(Tensor::randn({2,4,4}, 3)), std::invalid_argument);
+  EXPECT_THROW(quantize_int8(X, -1), std::invalid_argument);
+}
+
+// 2) int8 micro-kernels: exact int32 QK, fp32-accurate PV, on every ISA
+TEST(AttentionInt8, KernelsMatchScalarOnEveryIsa) {
+  const simd::MicroKernels& ref = simd::kernels_for(simd::Isa::Scalar);
+  for (simd::Isa isa : {simd::Isa::Scalar, simd::Isa::AVX2, simd::Isa::AVX512}) {
+    if (!simd::isa_supported(isa)) continue;
+    const simd::MicroKernels& k = simd::kernels_for(isa);
+    for (int D : {1, 7, 32, 33, 64, 65, 130}) for (int nk : {1, 3, 4, 9}) {
+      const int ld = D + 5;
+      std::vector<int8_t> q(D), kv((size_t)nk*ld);
+      for (int d=0;d<D;++d) q[d] = (int8_t)((d*37 % 255) - 127);
+      for (size_t i=0;i<kv.size();++i) kv[i] = (int8_t)(((int)i*91 + 13) % 255 - 127);
+      std::vector<int32_t> a(nk), b(nk);
+      k.qk_i8(q.data(), kv.data(), ld, nk, D, a.data());
+      ref.qk_i8(q.data(), kv.data(), ld, nk, D, b.data());
+      for (int c=0;c<nk;++c) ASSERT_EQ(a[c], b[c]) << simd::isa_name(isa) << " D=" << D;
+
+      std::vector<float> p(nk), acc(D, 0.25f), acc_ref(D, 0.25f);
+      for (int c=0;c<nk;++c) p[c] = 0.01f*(c+1);
+      k.pv_i8(p.data(), kv.data(), ld, nk, D, acc.data());
+      ref.pv_i8(p.data(), kv.data(), ld, nk, D, acc_ref.data());
+      for (int d=0;d<D;++d) EXPECT_NEAR(acc[d], acc_ref[d], 1e-4f) << simd::isa_name(isa) << " D=" << D;
+    }
+  }
+}
+
+// 3) Accuracy against the fp32 attention_forward reference (reported as
+//    test properties): causal + padding mask, per-block scales
+TEST(AttentionInt8, AccuracyVsFloatReference_B2H2N150D64) {
+  const int B=2,H=2,N=150,D=64;
+  Tensor Q = Tensor::randn({B,H,N,D}, 11);
+  Tensor K = Tensor::randn({B,H,N,D}, 12);
+  Tensor V = Tensor::randn({B,H,N,D}, 13);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  for (int j=0;j<N;++j) { M.at(0,0,0,j) = 1.0f; M.at(1,0,0,j) = (j%5 != 2) ? 1.0f : 0.0f; }
+  AttentionOpts opts; opts.causal = true; opts.temperature = std::sqrt((float)D);
+  const ConstTensorView mv = M.view();
+
+  Tensor R = attention_forward(Q, K, V, &M, opts);
+  for (int block : {0, 32}) {
+    QuantizedTensor Kq = quantize_int8(K, block), Vq = quantize_int8(V, block);
+    Tensor O = attention_forward_int8(Q.view(), Kq, Vq, &mv, opts);
+    const float err = max_abs_diff(O, R);
+    double mean = 0;
+    for (long long i=0;i<O.numel();++i) mean += std::fabs(O.at_index(i) - R.at_index(i));
+    mean /= O.numel();
+    const std::string tag = block ? "block32" : "per_head";
+    RecordProperty("max_abs_err_" + tag, std::to_string(err));
+    RecordProperty("mean_abs_err_" + tag, std::to_string(mean));
+    EXPECT_LT(err, 5e-2f) << tag;
+    EXPECT_LT(mean, 1e-2) << tag;
+
+    // Against fp32 attention on the dequantized K/V only Q rounding remains.
+    Tensor Rd = attention_forward(Q, dequantize(Kq), dequantize(Vq), &M, opts);
+    EXPECT_LT(max_abs_diff(O, Rd), 3e-2f) << tag;
+  }
+}
+
+// 4) Same threading / strided-Q / validation behaviour as the other engines
+TEST(AttentionInt8, ThreadsStridedQAndValidation) {
+  const int B=1,H=2,N=70,D=16;
+  Tensor Qs = Tensor::randn({B,N,H,D}, 21);
+  Tensor K = Tensor::randn({B,H,N,D}, 22);
+  Tensor V = Tensor::randn({B,H,N,D}, 23);
+  QuantizedTensor Kq = quantize_int8(K, 16), Vq = quantize_int8(V, 16);
+  const ConstTensorView Q = Qs.view().transpose(1,2);
+
+  AttentionOpts opts; opts.block_q = 16; opts.block_k = 32;
+  Tensor O1 = attention_forward_int8(Q, Kq, Vq, nullptr, opts);
+  opts.num_threads = 3;
+  Tensor O3 = attention_forward_int8(Q, Kq, Vq, nullptr, opts);
+  EXPECT_EQ(max_abs_diff(O1, O3), 0.0f);
+  Tensor Oc = attention_forward_int8(Tensor::from(Q).view(), Kq, Vq, nullptr, opts);
+  EXPECT_EQ(max_abs_diff(O1, Oc), 0.0f);
+  opts.block_q = 1;   // single-row blocks take the fused int8 PV path
+  Tensor Or = attention_forward_int8(Q, Kq, Vq, nullptr, opts);
+  EXPECT_LT(max_abs_diff(O1, Or), 1e-5f);
+
+  QuantizedTensor bad = Kq;
+  bad.scales.pop_back();
+  EXPECT_THROW(attention_forward_int8(Q, bad, Vq, nullptr, opts), std::invalid_argument);
+  QuantizedTensor short_k = quantize_int8(Tensor::randn({B,H,N-1,D}, 24));
+  EXPECT_THROW(attention_forward_int8(Q, short_k, Vq, nullptr, opts), std::invalid_argument);
+  opts.temperature = 0.0f;
+  EXPECT_THROW(attention_forward_int8(Q, Kq, Vq, nullptr, opts), std::invalid_argument);
+}
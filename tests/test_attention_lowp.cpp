@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/dtype.hpp"
+#include "fa/simd.hpp"
+#include "fa/tensor.hpp"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace fa;
+
+static float max_abs_diff(const Tensor& A, const Tensor& B) {
+  float m = 0.0f;
+  for (long long i=0;i<A.numel();++i) m = std::max(m, std::fabs(A.at_index(i)-B.at_index(i)));
+  return m;
+}
+
+static float bits_to_float(uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+
+// 1) Every ISA's bulk conversions agree bit-for-bit with the scalar ones
+TEST(AttentionLowp, ConversionKernelsMatchScalar) {
+  std::vector<uint16_t> all(65536);
+  for (int i=0;i<65536;++i) all[i] = (uint16_t)i;
+  // fp32 sample: strided walk over every exponent, plus ties and specials.
+  std::vector<float> f;
+  for (uint64_t u=0; u<=0xFFFFFFFFull; u+=4099) f.push_back(bits_to_float((uint32_t)u));
+  for (float x : {1.0f + 1.0f/256, 1.0f + 3.0f/256, 1.0f + 1.0f/2048, 65504.0f, 65520.0f,
+                  5.96e-8f, 2.98e-8f, INFINITY, -INFINITY, NAN})
+    f.push_back(x);
+
+  for (simd::Isa isa : {simd::Isa::Scalar, simd::Isa::AVX2, simd::Isa::AVX512}) {
+    if (!simd::isa_supported(isa)) continue;
+    const simd::MicroKernels& k = simd::kernels_for(isa);
+    const int n = 65536 - 5;   // odd length: exercises the tails
+    std::vector<float> wide(n);
+    k.bf16_to_f32(reinterpret_cast<const bf16*>(all.data()), wide.data(), n);
+    for (int i=0;i<n;++i) {
+      const float want = bf16_bits_to_f32(all[i]);
+      if (std::isnan(want)) EXPECT_TRUE(std::isnan(wide[i]));
+      else ASSERT_EQ(wide[i], want) << simd::isa_name(isa) << " bf16 " << i;
+    }
+    k.f16_to_f32(reinterpret_cast<const fp16*>(all.data()), wide.data(), n);
+    for (int i=0;i<n;++i) {
+      const float want = f16_bits_to_f32(all[i]);
+      if (std::isnan(want)) EXPECT_TRUE(std::isnan(wide[i]));
+      else ASSERT_EQ(wide[i], want) << simd::isa_name(isa) << " f16 " << i;
+    }
+
+    const int m = (int)f.size();
+    std::vector<bf16> nb(m);
+    std::vector<fp16> nh(m);
+    k.f32_to_bf16(f.data(), nb.data(), m);
+    k.f32_to_f16(f.data(), nh.data(), m);
+    for (int i=0;i<m;++i) {
+      // The native AVX512_BF16 store flushes fp32 subnormals; skip those.
+      if (std::fpclassify(f[i]) != FP_SUBNORMAL)
+        ASSERT_EQ(nb[i].bits, f32_to_bf16_bits(f[i])) << simd::isa_name(isa) << " x=" << f[i];
+      if (std::isnan(f[i])) EXPECT_TRUE(std::isnan(static_cast<float>(nh[i])));
+      else ASSERT_EQ(nh[i].bits, f32_to_f16_bits(f[i])) << simd::isa_name(isa) << " x=" << f[i];
+    }
+  }
+  // Round to nearest even on exact ties; largest fp16 and its overflow.
+  EXPECT_EQ(bf16(1.0f + 1.0f/256).bits, bf16(1.0f).bits);
+  EXPECT_EQ(static_cast<float>(fp16(65504.0f)), 65504.0f);
+  EXPECT_TRUE(std::isinf(static_cast<float>(fp16(65520.0f))));
+  EXPECT_EQ(static_cast<float>(fp16(5.96e-8f)), std::ldexp(1.0f, -24));
+}
+
+// 2) bf16 Q/K/V with fp32 output: matches the fp32 reference on the widened
+//    inputs tightly, and on the original fp32 inputs within bf16 tolerance
+TEST(AttentionLowp, Bf16MatchesFp32Reference_CausalMask_B2H2N97D40) {
+  const int B=2,H=2,N=97,D=40;
+  Tensor Q = Tensor::randn({B,H,N,D}, 11);
+  Tensor K = Tensor::randn({B,H,N,D}, 12);
+  Tensor V = Tensor::randn({B,H,N,D}, 13);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  for (int j=0;j<N;++j) { M.at(0,0,0,j) = 1.0f; M.at(1,0,0,j) = (j%4 != 1) ? 1.0f : 0.0f; }
+  TensorBF16 Qb = cast<bf16>(Q), Kb = cast<bf16>(K), Vb = cast<bf16>(V);
+
+  AttentionOpts opts; opts.causal = true; opts.temperature = 0.9f;
+  Tensor R32 = attention_forward(Q, K, V, &M, opts);
+  const ConstTensorView mv = M.view();
+  Tensor Rw = attention_forward(cast<float>(Qb).view(), cast<float>(Kb).view(),
+                                cast<float>(Vb).view(), &mv, opts);
+
+  opts.engine = AttentionEngine::Tiled;
+  opts.block_q = 16; opts.block_k = 32; opts.num_threads = 3;
+  Tensor T = attention_forward(Qb.view(), Kb.view(), Vb.view(), &mv, opts);
+  EXPECT_LT(max_abs_diff(T, Rw), 1e-5f);
+  EXPECT_LT(max_abs_diff(T, R32), 1.5e-1f);   // input rounding on unscaled logits
+
+  // The reference engine accepts bf16 too (widened up front).
+  opts.engine = AttentionEngine::Reference;
+  Tensor Rb = attention_forward(Qb.view(), Kb.view(), Vb.view(), &mv, opts);
+  EXPECT_LT(max_abs_diff(Rb, Rw), 1e-6f);
+}
+
+// 3) fp16 through a strided (B,N,H,D) view, fp32 output
+TEST(AttentionLowp, Fp16StridedViewMatchesReference_B1H3N70D24) {
+  const int B=1,H=3,N=70,D=24;
+  TensorF16 Qs = TensorF16::randn({B,N,H,D}, 21);
+  TensorF16 Ks = TensorF16::randn({B,N,H,D}, 22);
+  TensorF16 Vs = TensorF16::randn({B,N,H,D}, 23);
+  auto bhnd = [](const TensorF16& t) { return t.view().transpose(1,2); };
+
+  AttentionOpts opts;
+  Tensor R = attention_forward(cast<float>(bhnd(Qs)).view(), cast<float>(bhnd(Ks)).view(),
+                               cast<float>(bhnd(Vs)).view(), nullptr, opts);
+  opts.engine = AttentionEngine::Tiled;
+  Tensor T = attention_forward(bhnd(Qs), bhnd(Ks), bhnd(Vs), nullptr, opts);
+  EXPECT_LT(max_abs_diff(T, R), 1e-5f);
+}
+
+// 4) 16-bit output is exactly the fp32 output rounded once
+TEST(AttentionLowp, LowpOutputIsRoundedFp32Output) {
+  const int B=1,H=2,N=65,D=33;
+  TensorBF16 Qb = TensorBF16::randn({B,H,N,D}, 31);
+  TensorBF16 Kb = TensorBF16::randn({B,H,N,D}, 32);
+  TensorBF16 Vb = TensorBF16::randn({B,H,N,D}, 33);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.causal = true;
+  Tensor O32 = attention_forward(Qb.view(), Kb.view(), Vb.view(), nullptr, opts);
+  TensorBF16 Ob = attention_forward_bf16(Qb.view(), Kb.view(), Vb.view(), nullptr, opts);
+  TensorBF16 Ox = cast<bf16>(O32);
+  ASSERT_EQ(Ob.shape(), O32.shape());
+  for (long long i=0;i<Ob.numel();++i) ASSERT_EQ(Ob.data()[i].bits, Ox.data()[i].bits) << i;
+
+  TensorF16 Qh = cast<fp16>(cast<float>(Qb)), Kh = cast<fp16>(cast<float>(Kb)), Vh = cast<fp16>(cast<float>(Vb));
+  Tensor H32 = attention_forward(Qh.view(), Kh.view(), Vh.view(), nullptr, opts);
+  TensorF16 Oh = attention_forward_f16(Qh.view(), Kh.view(), Vh.view(), nullptr, opts);
+  TensorF16 Hx = cast<fp16>(H32);
+  for (long long i=0;i<Oh.numel();++i) ASSERT_EQ(Oh.data()[i].bits, Hx.data()[i].bits) << i;
+  EXPECT_THROW(attention_forward_bf16(Qb.view(), Kb.view().slice(2,0,64), Vb.view(), nullptr, opts),
+               std::invalid_argument);
+}
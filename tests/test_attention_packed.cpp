@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/mask.hpp"
+#include "fa/packed_kv.hpp"
+#include "fa/simd.hpp"
+#include "fa/tensor.hpp"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace fa;
+
+static void expect_near(const Tensor& A, const Tensor& B, float tol, const char* what) {
+  ASSERT_EQ(A.shape(), B.shape());
+  for (long long i=0;i<A.numel();++i) {
+    if (std::isinf(A.data()[i]) || std::isinf(B.data()[i])) ASSERT_EQ(A.data()[i], B.data()[i]) << what << " @" << i;
+    else ASSERT_NEAR(A.data()[i], B.data()[i], tol) << what << " @" << i;
+  }
+}
+
+// 1) Panel layout: key c of (b,h) sits in panel c / P, lane c % P, padding zero
+TEST(AttentionPacked, PackLayout) {
+  const int P = simd::kPanelKeys;
+  Tensor bnhd = Tensor::randn({2,21,3,5}, 1);
+  const ConstTensorView K = bnhd.view().transpose(1,2);   // (2,3,21,5), strided
+  PackedKV pk = pack_kv(K, K);
+  ASSERT_EQ(pk.panels_per_head(), 2);
+  EXPECT_TRUE(pk.has_v);
+  for (int b=0;b<2;++b) for (int h=0;h<3;++h) {
+    for (int n=0;n<2*P;++n) for (int d=0;d<5;++d) {
+      const float x = pk.k_panel(b,h,n/P)[d*P + n%P];
+      ASSERT_EQ(x, n < 21 ? K.at(b,h,n,d) : 0.0f) << b << h << n << d;
+    }
+    for (int n=0;n<21;++n) for (int d=0;d<5;++d) ASSERT_EQ(pk.v_row(b,h,n)[d], K.at(b,h,n,d));
+  }
+  EXPECT_FALSE(pack_kv(K).has_v);
+  EXPECT_THROW(pack_kv(Tensor::randn({2,3,4}, 2).view()), std::invalid_argument);
+  EXPECT_THROW(pack_kv(K, Tensor::randn({2,3,20,5}, 3).view()), std::invalid_argument);
+}
+
+// 2) Matches attention_forward (output and lse) across causal / window /
+//    padding / GQA / dropout / cross-attention and split-K, for every ISA
+TEST(AttentionPacked, MatchesTiled) {
+  const int B=2,H=4,Hkv=2,Nk=150,D=24;
+  PaddingBitmask pad = PaddingBitmask::from_lengths({150, 77}, Nk);
+  AttentionMask mask; mask.padding = &pad;
+  Tensor K = Tensor::randn({B,Hkv,Nk,D}, 4), V = Tensor::randn({B,Hkv,Nk,D}, 5);
+  const PackedKV kv = pack_kv(K.view(), V.view());
+  const PackedKV k_only = pack_kv(K.view());
+  const simd::Isa prev = simd::select_isa(simd::detected_isa());
+  for (simd::Isa isa : {simd::Isa::Scalar, simd::Isa::AVX2, simd::Isa::AVX512}) {
+    if (!simd::isa_supported(isa)) continue;
+    simd::select_isa(isa);
+    for (int Nq : {1, 37, 150}) {
+      Tensor Q = Tensor::randn({B,H,Nq,D}, 6);
+      for (int variant=0; variant<4; ++variant) {
+        AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_q = 16; opts.block_k = 24;
+        opts.causal = variant != 1;
+        if (variant == 1) opts.window = 30;
+        if (variant == 2) { opts.dropout_prob = 0.25f; opts.dropout_seed = 9; }
+        if (variant == 3) opts.kv_splits = 3;
+        Tensor lw, lp;
+        Tensor want = attention_forward(Q.view(), K.view(), V.view(), mask, opts, &lw);
+        Tensor got = attention_forward_packed(Q.view(), kv, mask, opts, &lp);
+        expect_near(got, want, 1e-5f, simd::isa_name(isa));
+        expect_near(lp, lw, 1e-5f, "lse");
+        Tensor got_v = attention_forward_packed(Q.view(), k_only, V.view(), mask, opts);
+        EXPECT_EQ(0, std::memcmp(got.data(), got_v.data(), sizeof(float)*(size_t)got.numel()));
+      }
+    }
+  }
+  simd::select_isa(prev);
+}
+
+// 3) Bitwise identical for any thread count
+TEST(AttentionPacked, ThreadCountInvariant) {
+  const int B=1,H=2,Nq=3,Nk=517,D=32;
+  Tensor Q = Tensor::randn({B,H,Nq,D}, 7), K = Tensor::randn({B,H,Nk,D}, 8), V = Tensor::randn({B,H,Nk,D}, 9);
+  const PackedKV kv = pack_kv(K.view(), V.view());
+  AttentionOpts opts; opts.causal = true; opts.block_k = 32; opts.kv_splits = 4;
+  Tensor ref = attention_forward_packed(Q.view(), kv, AttentionMask{}, opts);
+  for (int t : {2, 3, 0}) {
+    opts.num_threads = t;
+    Tensor O = attention_forward_packed(Q.view(), kv, AttentionMask{}, opts);
+    EXPECT_EQ(0, std::memcmp(ref.data(), O.data(), sizeof(float)*(size_t)O.numel())) << "threads=" << t;
+  }
+}
+
+// 4) Block-sparse layouts on the panel grid work; others and bad inputs throw
+TEST(AttentionPacked, BlockSparseAndInvalid) {
+  const int N=64,D=8;
+  Tensor Q = Tensor::randn({1,1,N,D}, 10), K = Tensor::randn({1,1,N,D}, 11);
+  const PackedKV kv = pack_kv(K.view(), K.view());
+  // every other key block of each query block
+  std::vector<uint8_t> layout(4*4);
+  for (int qb=0;qb<4;++qb) for (int kb=0;kb<4;++kb) layout[qb*4 + kb] = (qb + kb) % 2 == 0;
+  BlockSparseMask lay(16, 16, 4, 4, layout);
+  AttentionMask sparse; sparse.blocks = &lay;
+  AttentionOpts opts;
+  Tensor want = attention_forward(Q.view(), K.view(), K.view(), sparse, opts);
+  expect_near(attention_forward_packed(Q.view(), kv, sparse, opts), want, 1e-5f, "block-sparse");
+
+  BlockSparseMask odd(8, 8, 8, 8, std::vector<uint8_t>(64, 1));
+  AttentionMask odd_mask; odd_mask.blocks = &odd;
+  EXPECT_THROW(attention_forward_packed(Q.view(), kv, odd_mask, opts), std::invalid_argument);
+  EXPECT_THROW(attention_forward_packed(Q.view(), pack_kv(K.view()), AttentionMask{}, opts), std::invalid_argument);
+  EXPECT_THROW(attention_forward_packed(Q.view(), pack_kv(K.view()), Tensor::randn({1,1,N-1,D}, 12).view(),
+                                        AttentionMask{}, opts), std::invalid_argument);
+  PackedKV broken = kv;
+  broken.k.pop_back();
+  EXPECT_THROW(attention_forward_packed(Q.view(), broken, AttentionMask{}, opts), std::invalid_argument);
+}
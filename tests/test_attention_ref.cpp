@@ -37,11 +37,11 @@ TEST(AttentionRef, SmallExact_UniformMeans_B1H1N4D2) {
 // 2) Shape mismatches must throw std::invalid_argument
 TEST(AttentionRef, ShapeMismatch_ThrowsInvalidArgument) {
   AttentionOpts opts;
-  // N mismatch
+  // K/V N mismatch (Q may differ: cross-attention)
   {
     Tensor Q = Tensor::zeros({1,1,4,4});
     Tensor K = Tensor::zeros({1,1,5,4});
-    Tensor V = Tensor::zeros({1,1,5,4});
+    Tensor V = Tensor::zeros({1,1,4,4});
     EXPECT_THROW({
       try { (void)attention_forward(Q,K,V,nullptr,opts); }
       catch (const std::invalid_argument&) { throw; }
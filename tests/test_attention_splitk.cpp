@@ -0,0 +1,129 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/kv_cache.hpp"
+#include "fa/mask.hpp"
+#include "fa/stats.hpp"
+#include "fa/tensor.hpp"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace fa;
+
+static void expect_near(const Tensor& A, const Tensor& B, float tol, const char* what) {
+  ASSERT_EQ(A.shape(), B.shape());
+  for (long long i=0;i<A.numel();++i) {
+    if (std::isinf(A.data()[i]) || std::isinf(B.data()[i])) ASSERT_EQ(A.data()[i], B.data()[i]) << what << " @" << i;
+    else ASSERT_NEAR(A.data()[i], B.data()[i], tol) << what << " @" << i;
+  }
+}
+
+// 1) Split-K matches the reference and the unsplit pass (output and lse),
+//    across causal / window / padding / GQA / dropout and short query chunks
+TEST(AttentionSplitK, MatchesReferenceAndUnsplit) {
+  const int B=2,H=4,Hkv=2,Nk=300,D=16;
+  PaddingBitmask pad = PaddingBitmask::from_lengths({300, 170}, Nk);
+  AttentionMask mask; mask.padding = &pad;
+  for (int Nq : {1, 9, 300}) {
+    Tensor Q = Tensor::randn({B,H,Nq,D}, 1);
+    Tensor K = Tensor::randn({B,Hkv,Nk,D}, 2), V = Tensor::randn({B,Hkv,Nk,D}, 3);
+    for (int variant=0; variant<3; ++variant) {
+      AttentionOpts opts;
+      opts.causal = variant != 1;
+      if (variant == 1) opts.window = 40;
+      if (variant == 2) { opts.dropout_prob = 0.25f; opts.dropout_seed = 9; }
+      Tensor lr, lu, ls;
+      Tensor R = attention_forward(Q.view(),K.view(),V.view(),mask,opts,&lr);
+      opts.engine = AttentionEngine::Tiled; opts.block_q = 16; opts.block_k = 32; opts.kv_splits = 1;
+      Tensor U = attention_forward(Q.view(),K.view(),V.view(),mask,opts,&lu);
+      for (int s : {2, 3, 7}) {
+        opts.kv_splits = s;
+        Tensor S = attention_forward(Q.view(),K.view(),V.view(),mask,opts,&ls);
+        expect_near(S, R, 1e-5f, "vs reference");
+        expect_near(S, U, 1e-5f, "vs unsplit");
+        expect_near(ls, lu, 1e-5f, "lse");
+      }
+    }
+  }
+}
+
+// 2) A split pass is bitwise identical for any thread count
+TEST(AttentionSplitK, ThreadCountInvariant) {
+  const int B=1,H=2,Nq=3,Nk=517,D=32;
+  Tensor Q = Tensor::randn({B,H,Nq,D}, 4), K = Tensor::randn({B,H,Nk,D}, 5), V = Tensor::randn({B,H,Nk,D}, 6);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.causal = true;
+  opts.block_k = 32; opts.kv_splits = 5;
+  Tensor ref = attention_forward(Q, K, V, nullptr, opts);
+  for (int t : {2, 3, 0}) {
+    opts.num_threads = t;
+    Tensor O = attention_forward(Q, K, V, nullptr, opts);
+    EXPECT_EQ(0, std::memcmp(ref.data(), O.data(), sizeof(float)*(size_t)O.numel())) << "threads=" << t;
+  }
+}
+
+// 3) Decode over a paged cache: split pages, rows of unequal length and an
+//    empty batch row
+TEST(AttentionSplitK, DecodeMatchesUnsplit) {
+  const int B=3,H=2,D=16,P=16,T=2;
+  KVCache cache(B,H,D,P);
+  const int lens[B] = {250, 37, 0};
+  for (int b=0;b<B;++b) if (lens[b] > 0) {
+    Tensor k = Tensor::randn({1,H,lens[b],D}, 10+b), v = Tensor::randn({1,H,lens[b],D}, 20+b);
+    cache.append(b, k.view(), v.view());
+  }
+  Tensor Q = Tensor::randn({B,H,T,D}, 7);
+  AttentionOpts opts; opts.kv_splits = 1;   // non-causal: causal decode rejects the empty row
+  Tensor U = attention_decode(Q.view(), cache, opts);
+  for (int s : {2, 4, 16}) {
+    opts.kv_splits = s;
+    Tensor S = attention_decode(Q.view(), cache, opts);
+    expect_near(S, U, 1e-5f, "decode");
+  }
+  for (int h=0;h<H;++h) for (int t=0;t<T;++t) for (int d=0;d<D;++d) EXPECT_EQ(U.at(2,h,t,d), 0.0f);
+}
+
+// 4) The allocation-free overload splits too, with partials in the workspace
+TEST(AttentionSplitK, WorkspaceOverload) {
+  const int B=1,H=2,Nq=4,Nk=200,D=8;
+  Tensor Q = Tensor::randn({B,H,Nq,D}, 8), K = Tensor::randn({B,H,Nk,D}, 9), V = Tensor::randn({B,H,Nk,D}, 10);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_k = 16; opts.kv_splits = 4;
+  Tensor want = attention_forward(Q.view(), K.view(), V.view(), AttentionMask{}, opts);
+  AttentionOpts unsplit = opts; unsplit.kv_splits = 1;
+  EXPECT_GT(attention_workspace_size(Q.view(), K.view(), AttentionMask{}, opts),
+            attention_workspace_size(Q.view(), K.view(), AttentionMask{}, unsplit));
+  Tensor out = Tensor::zeros({B,H,Nq,D});
+  AttentionWorkspace ws(attention_workspace_size(Q.view(), K.view(), AttentionMask{}, opts));
+  const size_t cap = ws.capacity();
+  attention_forward(Q.view(), K.view(), V.view(), AttentionMask{}, opts, out.view(), ws);
+  EXPECT_EQ(ws.capacity(), cap);
+  EXPECT_EQ(0, std::memcmp(want.data(), out.data(), sizeof(float)*(size_t)out.numel()));
+}
+
+// 5) Stats: rows with no visible key in any chunk are counted once
+TEST(AttentionSplitK, StatsCountMaskedRowsOnce) {
+  if (!stats_compiled_in()) GTEST_SKIP() << "built without FA_ENABLE_STATS";
+  const int B=2,H=1,Nq=2,Nk=128,D=8;
+  PaddingBitmask pad = PaddingBitmask::from_lengths({128, 0}, Nk);
+  AttentionMask mask; mask.padding = &pad;
+  Tensor Q = Tensor::randn({B,H,Nq,D}, 11), K = Tensor::randn({B,H,Nk,D}, 12);
+  AttentionStats st;
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_k = 16; opts.kv_splits = 4;
+  opts.stats = &st;
+  attention_forward(Q.view(), K.view(), K.view(), mask, opts);
+  EXPECT_EQ(st.rows_fully_masked, 2);
+  EXPECT_EQ(st.tiles_visited + st.tiles_skipped, 2*8);
+}
+
+// 6) Default opts (automatic split count) are bitwise identical for any
+//    thread count: the count follows the machine, not num_threads
+TEST(AttentionSplitK, AutoThreadCountInvariant) {
+  const int B=1,H=1,Nq=1,Nk=8192,D=64;
+  Tensor Q = Tensor::randn({B,H,Nq,D}, 13), K = Tensor::randn({B,H,Nk,D}, 14), V = Tensor::randn({B,H,Nk,D}, 15);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_q = 16; opts.block_k = 64;
+  Tensor ref = attention_forward(Q, K, V, nullptr, opts);
+  for (int t : {2, 8, 0}) {
+    opts.num_threads = t;
+    Tensor O = attention_forward(Q, K, V, nullptr, opts);
+    EXPECT_EQ(0, std::memcmp(ref.data(), O.data(), sizeof(float)*(size_t)O.numel())) << "threads=" << t;
+  }
+}
@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/stats.hpp"
+#include "fa/tensor.hpp"
+#include <cstring>
+#include <string>
+
+using namespace fa;
+
+// 1) Counters on a causal, padded tiled call; output unchanged by stats
+TEST(AttentionStats, TiledCountersCausalPadded) {
+  if (!stats_compiled_in()) GTEST_SKIP() << "built without FA_ENABLE_STATS";
+  const int B=2,H=2,N=64,D=16;
+  Tensor Q = Tensor::randn({B,H,N,D}, 1), K = Tensor::randn({B,H,N,D}, 2), V = Tensor::randn({B,H,N,D}, 3);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  for (int j=0;j<N;++j) M.at(0,0,0,j) = 1.0f;   // batch 1: every key padded
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.causal = true;
+  opts.block_q = 16; opts.block_k = 16; opts.num_threads = 3;
+  Tensor plain = attention_forward(Q,K,V,&M,opts);
+
+  AttentionStats st;
+  opts.stats = &st;
+  Tensor O = attention_forward(Q,K,V,&M,opts);
+  EXPECT_EQ(0, std::memcmp(plain.data(), O.data(), sizeof(float)*(size_t)O.numel()));
+
+  // batch 0: query block qb visits qb+1 of 4 tiles; batch 1 visits none
+  EXPECT_EQ(st.calls, 1);
+  EXPECT_EQ(st.tiles_visited, H*(1+2+3+4));
+  EXPECT_EQ(st.tiles_skipped, B*H*4*4 - H*(1+2+3+4));
+  EXPECT_EQ(st.rows_fully_masked, H*N);
+  EXPECT_EQ(st.bytes_written, (int64_t)B*H*N*D*(int64_t)sizeof(float));
+  EXPECT_EQ(st.bytes_read, (int64_t)B*H*N*D*4 + (int64_t)H*(1+2+3+4)*16*2*D*4);
+  EXPECT_GT(st.qk_ns + st.softmax_ns + st.pv_ns, 0);
+  EXPECT_TRUE(st.trace.empty());
+
+  attention_forward(Q,K,V,&M,opts);   // calls accumulate until reset()
+  EXPECT_EQ(st.calls, 2);
+  st.reset();
+  EXPECT_EQ(st.calls, 0);
+  EXPECT_EQ(st.tiles_visited, 0);
+}
+
+// 2) One trace event per work item, exported as Chrome trace JSON
+TEST(AttentionStats, TraceEventsAndChromeJson) {
+  if (!stats_compiled_in()) GTEST_SKIP() << "built without FA_ENABLE_STATS";
+  Tensor Q = Tensor::randn({1,3,40,8}, 4);
+  AttentionStats st;
+  st.record_trace = true;
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_q = 8; opts.block_k = 8;
+  opts.num_threads = 2; opts.stats = &st;
+  attention_forward(Q,Q,Q,nullptr,opts);
+  ASSERT_EQ(st.trace.size(), 3u*5u);
+  for (const TraceEvent& e : st.trace) {
+    EXPECT_GE(e.worker, 0);
+    EXPECT_LT(e.worker, 2);
+    EXPECT_GE(e.dur_ns, 0);
+  }
+  const std::string json = chrome_trace_json(st);
+  EXPECT_NE(json.find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(json.find("\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(json.find("\"tiles_visited\":75"), std::string::npos);
+}
+
+// 2b) Trace times keep nanosecond resolution far from the first event
+TEST(AttentionStats, ChromeJsonKeepsNanoseconds) {
+  AttentionStats st;
+  TraceEvent e;
+  e.start_ns = 1000;
+  st.trace.push_back(e);
+  e.start_ns = 5000001234LL; e.dur_ns = 1500;   // 5 s later
+  st.trace.push_back(e);
+  const std::string json = chrome_trace_json(st);
+  EXPECT_NE(json.find("\"ts\":0.000,\"dur\":0.000"), std::string::npos) << json;
+  EXPECT_NE(json.find("\"ts\":5000000.234,\"dur\":1.500"), std::string::npos) << json;
+}
+
+// 3) Reference engine: fully masked rows and traffic, no tiles
+TEST(AttentionStats, ReferenceEngineCounters) {
+  if (!stats_compiled_in()) GTEST_SKIP() << "built without FA_ENABLE_STATS";
+  const int N=10, D=4;
+  Tensor Q = Tensor::randn({2,1,N,D}, 5);
+  Tensor M = Tensor::zeros({2,1,1,N});
+  for (int j=0;j<N;++j) M.at(1,0,0,j) = 1.0f;   // batch 0 fully padded
+  AttentionStats st;
+  AttentionOpts opts; opts.stats = &st;
+  attention_forward(Q,Q,Q,&M,opts);
+  EXPECT_EQ(st.rows_fully_masked, N);
+  EXPECT_EQ(st.tiles_visited, 0);
+  EXPECT_EQ(st.bytes_written, 2*N*D*(int64_t)sizeof(float));
+}
@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/kv_stream.hpp"
+#include "fa/mask.hpp"
+#include "fa/stats.hpp"
+#include "fa/tensor.hpp"
+#include "fa/tensor_file.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace fa;
+
+static void expect_near(const Tensor& A, const Tensor& B, float tol, const char* what) {
+  ASSERT_EQ(A.shape(), B.shape());
+  for (long long i=0;i<A.numel();++i) {
+    if (std::isinf(A.data()[i]) || std::isinf(B.data()[i])) ASSERT_EQ(A.data()[i], B.data()[i]) << what << " @" << i;
+    else ASSERT_NEAR(A.data()[i], B.data()[i], tol) << what << " @" << i;
+  }
+}
+
+// 1) Streaming matches attention_forward (output and lse) across causal /
+//    window / padding / GQA / dropout, for block sizes on and off the tile grid
+TEST(AttentionStream, MatchesInMemory) {
+  const int B=2,H=4,Hkv=2,Nk=300,D=16;
+  PaddingBitmask pad = PaddingBitmask::from_lengths({300, 170}, Nk);
+  AttentionMask mask; mask.padding = &pad;
+  Tensor K = Tensor::randn({B,Hkv,Nk,D}, 2), V = Tensor::randn({B,Hkv,Nk,D}, 3);
+  ViewKVSource src(K.view(), V.view());
+  for (int Nq : {1, 33, 300}) {
+    Tensor Q = Tensor::randn({B,H,Nq,D}, 1);
+    for (int variant=0; variant<3; ++variant) {
+      AttentionOpts opts; opts.block_q = 16; opts.block_k = 32;
+      opts.causal = variant != 1;
+      if (variant == 1) opts.window = 40;
+      if (variant == 2) { opts.dropout_prob = 0.25f; opts.dropout_seed = 9; }
+      Tensor lw, ls;
+      Tensor want = attention_forward(Q.view(), K.view(), V.view(), mask, opts, &lw);
+      for (int block : {32, 100, 4096}) {
+        Tensor got = attention_forward_stream(Q.view(), src, mask, opts, block, &ls);
+        expect_near(got, want, 1e-5f, "output");
+        expect_near(ls, lw, 1e-5f, "lse");
+      }
+    }
+  }
+}
+
+// 2) K/V from a tensor file, read through the mapping block by block
+TEST(AttentionStream, FileSource) {
+  const std::string path = ::testing::TempDir() + "fa_stream_kv.bin";
+  const int B=1,H=2,Nq=5,Nk=700,D=32;
+  Tensor Q = Tensor::randn({B,H,Nq,D}, 4), K = Tensor::randn({B,H,Nk,D}, 5), V = Tensor::randn({B,H,Nk,D}, 6);
+  {
+    io::TensorFileWriter w(path);
+    w.write("keys", K);
+    w.write("values", V);
+  }
+  AttentionOpts opts; opts.causal = true;
+  Tensor want = attention_forward(Q.view(), K.view(), V.view(), AttentionMask{}, opts);
+  {
+    FileKVSource src(path, "keys", "values");
+    EXPECT_EQ(src.length(), Nk);
+    Tensor got = attention_forward_stream(Q.view(), src, AttentionMask{}, opts, 128);
+    expect_near(got, want, 1e-5f, "file");
+  }
+  EXPECT_THROW(FileKVSource src(path), std::invalid_argument);   // no "K" record
+  std::remove(path.c_str());
+}
+
+// 3) Callback source: ascending blocks of at most block_keys rows, blocks
+//    outside the window never read, at most one read in flight
+TEST(AttentionStream, CallbackBlocks) {
+  const int B=1,H=1,Nq=4,Nk=1000,D=8,block=128;
+  Tensor Q = Tensor::randn({B,H,Nq,D}, 7), K = Tensor::randn({B,H,Nk,D}, 8), V = Tensor::randn({B,H,Nk,D}, 9);
+  ViewKVSource inner(K.view(), V.view());
+  std::vector<std::pair<int,int>> reads;
+  std::atomic<int> in_flight{0};
+  int max_in_flight = 0;
+  CallbackKVSource src(B, H, Nk, D, [&](int j0, int n, float* k, float* v) {
+    max_in_flight = std::max(max_in_flight, ++in_flight);
+    reads.emplace_back(j0, n);
+    inner.read(j0, n, k, v);
+    --in_flight;
+  });
+  AttentionOpts opts; opts.causal = true; opts.window = 200; opts.block_k = 32;
+  Tensor want = attention_forward(Q.view(), K.view(), V.view(), AttentionMask{}, opts);
+  Tensor got = attention_forward_stream(Q.view(), src, AttentionMask{}, opts, block);
+  expect_near(got, want, 1e-5f, "callback");
+
+  // query 0 sits at key 996 and sees keys from 797: blocks from 768 on
+  ASSERT_EQ(reads.size(), 2u);
+  EXPECT_EQ(reads[0], std::make_pair(768, 128));
+  EXPECT_EQ(reads[1], std::make_pair(896, 104));
+  EXPECT_EQ(max_in_flight, 1);
+}
+
+// 4) Bitwise identical for any thread count; split blocks included
+TEST(AttentionStream, ThreadCountInvariant) {
+  const int B=1,H=2,Nq=3,Nk=517,D=32;
+  Tensor Q = Tensor::randn({B,H,Nq,D}, 10), K = Tensor::randn({B,H,Nk,D}, 11), V = Tensor::randn({B,H,Nk,D}, 12);
+  ViewKVSource src(K.view(), V.view());
+  AttentionOpts opts; opts.causal = true; opts.block_k = 32; opts.kv_splits = 3;
+  Tensor ref = attention_forward_stream(Q.view(), src, AttentionMask{}, opts, 256);
+  for (int t : {2, 3, 0}) {
+    opts.num_threads = t;
+    Tensor O = attention_forward_stream(Q.view(), src, AttentionMask{}, opts, 256);
+    EXPECT_EQ(0, std::memcmp(ref.data(), O.data(), sizeof(float)*(size_t)O.numel())) << "threads=" << t;
+  }
+}
+
+// 5) Source errors propagate; empty streams give zero rows; bad arguments throw
+TEST(AttentionStream, ErrorsAndEdgeCases) {
+  Tensor Q = Tensor::randn({1,2,3,8}, 13);
+  CallbackKVSource failing(1, 2, 500, 8, [](int j0, int, float*, float*) {
+    if (j0 >= 200) throw std::runtime_error("read failed");
+  });
+  EXPECT_THROW(attention_forward_stream(Q.view(), failing, AttentionMask{}, AttentionOpts{}, 100),
+               std::runtime_error);
+
+  CallbackKVSource empty(1, 2, 0, 8, [](int, int, float*, float*) { FAIL() << "nothing to read"; });
+  Tensor lse;
+  Tensor O = attention_forward_stream(Q.view(), empty, AttentionMask{}, AttentionOpts{}, 0, &lse);
+  for (long long i=0;i<O.numel();++i) EXPECT_EQ(O.data()[i], 0.0f);
+  for (long long i=0;i<lse.numel();++i) EXPECT_TRUE(std::isinf(lse.data()[i]));
+
+  Tensor K = Tensor::randn({1,2,10,4}, 14);
+  ViewKVSource wrong_d(K.view(), K.view());
+  EXPECT_THROW(attention_forward_stream(Q.view(), wrong_d, AttentionMask{}, AttentionOpts{}), std::invalid_argument);
+  Tensor K8 = Tensor::randn({1,2,10,8}, 15);
+  ViewKVSource src(K8.view(), K8.view());
+  EXPECT_THROW(attention_forward_stream(Q.view(), src, AttentionMask{}, AttentionOpts{}, -1), std::invalid_argument);
+  float row[8];
+  EXPECT_THROW(src.read(5, 6, row, row), std::invalid_argument);
+  EXPECT_THROW(ViewKVSource bad(K.view(), K8.view()), std::invalid_argument);
+}
+
+// 6) Stats: rows with no visible key in any block are counted once
+TEST(AttentionStream, StatsCountMaskedRowsOnce) {
+  if (!stats_compiled_in()) GTEST_SKIP() << "built without FA_ENABLE_STATS";
+  const int B=2,H=1,Nq=2,Nk=128,D=8;
+  PaddingBitmask pad = PaddingBitmask::from_lengths({128, 0}, Nk);
+  AttentionMask mask; mask.padding = &pad;
+  Tensor Q = Tensor::randn({B,H,Nq,D}, 16), K = Tensor::randn({B,H,Nk,D}, 17);
+  ViewKVSource src(K.view(), K.view());
+  for (int block : {32, 128}) {
+    AttentionStats st;
+    AttentionOpts opts; opts.block_k = 16; opts.stats = &st;
+    attention_forward_stream(Q.view(), src, mask, opts, block);
+    EXPECT_EQ(st.rows_fully_masked, 2) << "block=" << block;
+  }
+}
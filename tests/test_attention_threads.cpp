@@ -0,0 +1,58 @@
+#include "gtest/gtest.h"
+#include "fa/tensor.hpp"
+#include "fa/attention.hpp"
+#include "fa/types.hpp"
+#include <cstring>
+
+using namespace fa;
+
+static bool bitwise_equal(const Tensor& A, const Tensor& B) {
+  return A.numel()==B.numel() &&
+         std::memcmp(A.data(), B.data(), sizeof(float)*(size_t)A.numel())==0;
+}
+
+// 1) Parallel output is bitwise identical to serial for a fixed tile size
+TEST(AttentionThreads, BitwiseIdenticalToSerial_B2H3N97D16) {
+  Tensor Q = Tensor::randn({2,3,97,16}, 1);
+  Tensor K = Tensor::randn({2,3,97,16}, 2);
+  Tensor V = Tensor::randn({2,3,97,16}, 3);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_q = 16; opts.block_k = 32;
+  Tensor S = attention_forward(Q,K,V,nullptr,opts);
+  for (int t : {2, 3, 8, 0}) {
+    opts.num_threads = t;
+    EXPECT_TRUE(bitwise_equal(S, attention_forward(Q,K,V,nullptr,opts))) << "threads=" << t;
+  }
+}
+
+// 2) Causal + mask (unequal per-task cost) also bitwise identical
+TEST(AttentionThreads, CausalMaskedBitwiseIdentical) {
+  const int B=3,H=2,N=70,D=8;
+  Tensor Q = Tensor::randn({B,H,N,D}, 4);
+  Tensor K = Tensor::randn({B,H,N,D}, 5);
+  Tensor V = Tensor::randn({B,H,N,D}, 6);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  for (int b=0;b<B;++b) for (int j=0;j<N-10*b;++j) M.at(b,0,0,j) = 1.0f;
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.causal = true; opts.block_q = 8;
+  Tensor S = attention_forward(Q,K,V,&M,opts);
+  opts.num_threads = 4;
+  EXPECT_TRUE(bitwise_equal(S, attention_forward(Q,K,V,&M,opts)));
+}
+
+// 3) More workers than tasks and repeated calls on the persistent pool
+TEST(AttentionThreads, MoreThreadsThanTasks_Repeated) {
+  Tensor Q = Tensor::randn({1,1,5,4}, 7);
+  Tensor K = Tensor::randn({1,1,5,4}, 8);
+  Tensor V = Tensor::randn({1,1,5,4}, 9);
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_q = 2;
+  Tensor S = attention_forward(Q,K,V,nullptr,opts);
+  opts.num_threads = 16;
+  for (int r=0; r<20; ++r)
+    ASSERT_TRUE(bitwise_equal(S, attention_forward(Q,K,V,nullptr,opts)));
+}
+
+// 4) Negative thread count rejected
+TEST(AttentionThreads, NegativeThreadsThrows) {
+  Tensor Q = Tensor::zeros({1,1,4,4});
+  AttentionOpts opts; opts.num_threads = -2;
+  EXPECT_THROW(attention_forward(Q,Q,Q,nullptr,opts), std::invalid_argument);
+}
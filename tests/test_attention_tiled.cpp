@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include "fa/tensor.hpp"
+#include "fa/attention.hpp"
+#include "fa/types.hpp"
+#include <cmath>
+
+using namespace fa;
+
+static float max_abs_diff(const Tensor& A, const Tensor& B) {
+  float m = 0.0f;
+  for (long long i=0;i<A.numel();++i) m = std::max(m, std::fabs(A.at_index(i)-B.at_index(i)));
+  return m;
+}
+
+static Tensor run(const Tensor& Q, const Tensor& K, const Tensor& V, const Tensor* M,
+                  AttentionOpts opts, AttentionEngine e) {
+  opts.engine = e;
+  return attention_forward(Q,K,V,M,opts);
+}
+
+// 1) Matches reference when N is not a multiple of the tile size (partial tiles)
+TEST(AttentionTiled, MatchesReference_PartialTiles_B2H2N100D16) {
+  Tensor Q = Tensor::randn({2,2,100,16}, 1);
+  Tensor K = Tensor::randn({2,2,100,16}, 2);
+  Tensor V = Tensor::randn({2,2,100,16}, 3);
+  AttentionOpts opts;
+  Tensor R = run(Q,K,V,nullptr,opts,AttentionEngine::Reference);
+  Tensor T = run(Q,K,V,nullptr,opts,AttentionEngine::Tiled);
+  EXPECT_LT(max_abs_diff(R,T), 1e-5f);
+}
+
+// 2) Causal + temperature across several key blocks
+TEST(AttentionTiled, MatchesReference_CausalTemperature_B1H3N150D8) {
+  Tensor Q = Tensor::randn({1,3,150,8}, 4);
+  Tensor K = Tensor::randn({1,3,150,8}, 5);
+  Tensor V = Tensor::randn({1,3,150,8}, 6);
+  AttentionOpts opts; opts.causal = true; opts.temperature = 0.7f;
+  Tensor R = run(Q,K,V,nullptr,opts,AttentionEngine::Reference);
+  Tensor T = run(Q,K,V,nullptr,opts,AttentionEngine::Tiled);
+  EXPECT_LT(max_abs_diff(R,T), 1e-5f);
+}
+
+// 3) Padding mask that hides an entire key block: running max must stay -inf safely
+TEST(AttentionTiled, MatchesReference_MaskedLeadingBlock_B2H1N130D4) {
+  const int B=2,H=1,N=130,D=4;
+  Tensor Q = Tensor::randn({B,H,N,D}, 7);
+  Tensor K = Tensor::randn({B,H,N,D}, 8);
+  Tensor V = Tensor::randn({B,H,N,D}, 9);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  for (int j=70;j<N;++j) M.at(0,0,0,j) = 1.0f;   // b=0: first 70 keys masked
+  for (int j=0;j<N;j+=3) M.at(1,0,0,j) = 1.0f;   // b=1: sparse keep
+  AttentionOpts opts; opts.causal = true;        // b=0 rows < 70 see nothing
+  Tensor R = run(Q,K,V,&M,opts,AttentionEngine::Reference);
+  Tensor T = run(Q,K,V,&M,opts,AttentionEngine::Tiled);
+  EXPECT_LT(max_abs_diff(R,T), 1e-5f);
+  for (int d=0; d<D; ++d) EXPECT_FLOAT_EQ(T.at(0,0,10,d), 0.0f);
+}
+
+// 4) Same validation as the reference engine
+TEST(AttentionTiled, InvalidArgumentsThrow) {
+  Tensor Q = Tensor::zeros({1,1,4,4});
+  Tensor K = Tensor::zeros({1,1,4,8});
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled;
+  EXPECT_THROW(attention_forward(Q,K,K,nullptr,opts), std::invalid_argument);
+  opts.temperature = -1.0f;
+  EXPECT_THROW(attention_forward(Q,Q,Q,nullptr,opts), std::invalid_argument);
+}
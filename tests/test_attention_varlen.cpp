@@ -0,0 +1,157 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/tensor.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace fa;
+
+// Element (i,j,k) of a contiguous 3D tensor.
+static float& at3(Tensor& T, int i, int j, int k) {
+  return T.data()[((size_t)i*T.dim(1) + j)*T.dim(2) + k];
+}
+
+// Packs per-sequence (1,H,n,D) tensors into a (total,H,D) buffer; empty
+// Tensors stand for zero-length sequences.
+static Tensor pack(const std::vector<Tensor>& seqs, int H, int D) {
+  int total = 0;
+  for (const Tensor& s : seqs) total += s.shape().empty() ? 0 : s.dim(2);
+  Tensor P({total, H, D});
+  int t0 = 0;
+  for (const Tensor& s : seqs) {
+    if (s.shape().empty()) continue;
+    for (int n=0;n<s.dim(2);++n) for (int h=0;h<H;++h) for (int d=0;d<D;++d)
+      at3(P,t0+n,h,d) = s.at(0,h,n,d);
+    t0 += s.dim(2);
+  }
+  return P;
+}
+
+// 1) Ragged batch (lengths vary ~10x, one empty) equals attention_forward on
+//    each sequence alone, causal and not, serial and threaded
+TEST(AttentionVarlen, MatchesPerSequenceForward_H3D16) {
+  const int H=3,D=16;
+  const std::vector<int> lens = {7, 70, 0, 23, 1};
+  std::vector<Tensor> qs, ks, vs;
+  std::vector<int> cu = {0};
+  for (size_t s=0;s<lens.size();++s) {
+    qs.push_back(lens[s] ? Tensor::randn({1,H,lens[s],D}, 100+s) : Tensor());
+    ks.push_back(lens[s] ? Tensor::randn({1,H,lens[s],D}, 200+s) : Tensor());
+    vs.push_back(lens[s] ? Tensor::randn({1,H,lens[s],D}, 300+s) : Tensor());
+    cu.push_back(cu.back() + lens[s]);
+  }
+  Tensor Q = pack(qs,H,D), K = pack(ks,H,D), V = pack(vs,H,D);
+
+  for (bool causal : {false, true}) {
+    AttentionOpts opts; opts.causal = causal; opts.temperature = 1.7f;
+    opts.block_q = 16; opts.block_k = 16;
+    Tensor O = attention_forward_varlen(Q.view(), K.view(), V.view(), cu, opts);
+    ASSERT_EQ(O.shape(), (std::vector<int>{cu.back(), H, D}));
+    opts.num_threads = 3;
+    Tensor O3 = attention_forward_varlen(Q.view(), K.view(), V.view(), cu, opts);
+    for (long long i=0;i<O.numel();++i) ASSERT_EQ(O.at_index(i), O3.at_index(i));
+
+    for (size_t s=0;s<lens.size();++s) {
+      if (lens[s] == 0) continue;
+      Tensor R = attention_forward(qs[s], ks[s], vs[s], nullptr, opts);
+      for (int n=0;n<lens[s];++n) for (int h=0;h<H;++h) for (int d=0;d<D;++d)
+        ASSERT_NEAR(at3(O,cu[s]+n,h,d), R.at(0,h,n,d), 1e-5f) << "seq " << s << " causal " << causal;
+    }
+  }
+}
+
+// 2) Same result as the padded batch with a (B,1,1,N) padding mask on the
+//    real rows
+TEST(AttentionVarlen, MatchesPaddedMaskedBatch_B3H2N40D8) {
+  const int B=3,H=2,N=40,D=8;
+  const int lens[B] = {40, 4, 17};
+  Tensor Qp = Tensor::randn({B,H,N,D}, 1);
+  Tensor Kp = Tensor::randn({B,H,N,D}, 2);
+  Tensor Vp = Tensor::randn({B,H,N,D}, 3);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  std::vector<Tensor> qs, ks, vs;
+  std::vector<int> cu = {0};
+  for (int b=0;b<B;++b) {
+    for (int j=0;j<lens[b];++j) M.at(b,0,0,j) = 1.0f;
+    qs.push_back(Tensor::from(Qp.view().slice(0,b,1).slice(2,0,lens[b])));
+    ks.push_back(Tensor::from(Kp.view().slice(0,b,1).slice(2,0,lens[b])));
+    vs.push_back(Tensor::from(Vp.view().slice(0,b,1).slice(2,0,lens[b])));
+    cu.push_back(cu.back() + lens[b]);
+  }
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled;
+  Tensor R = attention_forward(Qp, Kp, Vp, &M, opts);
+  Tensor O = attention_forward_varlen(pack(qs,H,D).view(), pack(ks,H,D).view(), pack(vs,H,D).view(), cu, opts);
+  for (int b=0;b<B;++b) for (int n=0;n<lens[b];++n) for (int h=0;h<H;++h) for (int d=0;d<D;++d)
+    EXPECT_NEAR(at3(O,cu[b]+n,h,d), R.at(b,h,n,d), 1e-5f);
+}
+
+// 2b) With dropout, sequence s draws the stream of batch entry s: equals the
+//     padded masked batch, causal and not, serial and threaded
+TEST(AttentionVarlen, DropoutMatchesPaddedBatch) {
+  const int B=3,H=2,N=40,D=8;
+  const int lens[B] = {40, 4, 17};
+  Tensor Qp = Tensor::randn({B,H,N,D}, 7);
+  Tensor Kp = Tensor::randn({B,H,N,D}, 8);
+  Tensor Vp = Tensor::randn({B,H,N,D}, 9);
+  Tensor M = Tensor::zeros({B,1,1,N});
+  std::vector<Tensor> qs, ks, vs;
+  std::vector<int> cu = {0};
+  for (int b=0;b<B;++b) {
+    for (int j=0;j<lens[b];++j) M.at(b,0,0,j) = 1.0f;
+    qs.push_back(Tensor::from(Qp.view().slice(0,b,1).slice(2,0,lens[b])));
+    ks.push_back(Tensor::from(Kp.view().slice(0,b,1).slice(2,0,lens[b])));
+    vs.push_back(Tensor::from(Vp.view().slice(0,b,1).slice(2,0,lens[b])));
+    cu.push_back(cu.back() + lens[b]);
+  }
+  const Tensor Q = pack(qs,H,D), K = pack(ks,H,D), V = pack(vs,H,D);
+  for (bool causal : {false, true}) {
+    AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.causal = causal;
+    opts.dropout_prob = 0.5f; opts.dropout_seed = 11; opts.block_q = 8; opts.block_k = 16;
+    Tensor R = attention_forward(Qp, Kp, Vp, &M, opts);
+    Tensor O = attention_forward_varlen(Q.view(), K.view(), V.view(), cu, opts);
+    for (int b=0;b<B;++b) for (int n=0;n<lens[b];++n) for (int h=0;h<H;++h) for (int d=0;d<D;++d)
+      ASSERT_NEAR(at3(O,cu[b]+n,h,d), R.at(b,h,n,d), 1e-5f) << "seq " << b << " causal " << causal;
+    opts.num_threads = 3;
+    Tensor O3 = attention_forward_varlen(Q.view(), K.view(), V.view(), cu, opts);
+    for (long long i=0;i<O.numel();++i) ASSERT_EQ(O.at_index(i), O3.at_index(i));
+  }
+}
+
+// 3) Strided inputs: an (H,total,D) buffer viewed as (total,H,D), and a
+//    non-unit D stride that has to be packed
+TEST(AttentionVarlen, StridedViews) {
+  const int H=2,T=30,D=12;
+  const std::vector<int> cu = {0, 11, 30};
+  Tensor Q = Tensor::randn({T,H,D}, 4), K = Tensor::randn({T,H,D}, 5), V = Tensor::randn({T,H,D}, 6);
+  AttentionOpts opts; opts.causal = true;
+  Tensor O = attention_forward_varlen(Q.view(), K.view(), V.view(), cu, opts);
+
+  Tensor Qh({H,T,D}), Kh({H,T,D}), Vh({H,T,D});
+  for (int t=0;t<T;++t) for (int h=0;h<H;++h) for (int d=0;d<D;++d) {
+    at3(Qh,h,t,d) = at3(Q,t,h,d); at3(Kh,h,t,d) = at3(K,t,h,d); at3(Vh,h,t,d) = at3(V,t,h,d);
+  }
+  Tensor Ot = attention_forward_varlen(Qh.view().transpose(0,1), Kh.view().transpose(0,1),
+                                       Vh.view().transpose(0,1), cu, opts);
+  for (long long i=0;i<O.numel();++i) EXPECT_EQ(O.at_index(i), Ot.at_index(i));
+
+  Tensor Qd({T,D,H});
+  for (int t=0;t<T;++t) for (int h=0;h<H;++h) for (int d=0;d<D;++d) at3(Qd,t,d,h) = at3(Q,t,h,d);
+  Tensor Od = attention_forward_varlen(Qd.view().transpose(1,2), K.view(), V.view(), cu, opts);
+  for (long long i=0;i<O.numel();++i) EXPECT_EQ(O.at_index(i), Od.at_index(i));
+}
+
+// 4) Bad cu_seqlens / shapes throw
+TEST(AttentionVarlen, InvalidArgumentsThrow) {
+  Tensor X = Tensor::randn({10,2,4}, 7);
+  AttentionOpts opts;
+  EXPECT_THROW(attention_forward_varlen(X.view(), X.view(), X.view(), {0}, opts), std::invalid_argument);
+  EXPECT_THROW(attention_forward_varlen(X.view(), X.view(), X.view(), {1, 10}, opts), std::invalid_argument);
+  EXPECT_THROW(attention_forward_varlen(X.view(), X.view(), X.view(), {0, 9}, opts), std::invalid_argument);
+  EXPECT_THROW(attention_forward_varlen(X.view(), X.view(), X.view(), {0, 6, 4, 10}, opts), std::invalid_argument);
+  Tensor Y = Tensor::randn({10,2,5}, 8);
+  EXPECT_THROW(attention_forward_varlen(X.view(), Y.view(), X.view(), {0, 10}, opts), std::invalid_argument);
+  Tensor Z = Tensor::randn({1,10,2,4}, 9);
+  EXPECT_THROW(attention_forward_varlen(Z.view(), Z.view(), Z.view(), {0, 10}, opts), std::invalid_argument);
+  opts.temperature = -1.0f;
+  EXPECT_THROW(attention_forward_varlen(X.view(), X.view(), X.view(), {0, 10}, opts), std::invalid_argument);
+}
@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+#include "fa/autotune.hpp"
+#include "fa/attention.hpp"
+#include "fa/tensor.hpp"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+using namespace fa;
+
+static std::string temp_cache(const char* name) {
+  auto p = std::filesystem::temp_directory_path() / name;
+  std::remove(p.string().c_str());
+  return p.string();
+}
+
+// 1) Explicit odd tile sizes still match the reference
+TEST(Autotune, ExplicitBlockSizesMatchReference) {
+  Tensor Q = Tensor::randn({1,2,45,8}, 1);
+  Tensor K = Tensor::randn({1,2,45,8}, 2);
+  Tensor V = Tensor::randn({1,2,45,8}, 3);
+  AttentionOpts ref; ref.causal = true;
+  Tensor R = attention_forward(Q,K,V,nullptr,ref);
+  for (int bq : {1, 7, 64}) for (int bk : {3, 13, 45}) {
+    AttentionOpts t = ref; t.engine = AttentionEngine::Tiled; t.block_q = bq; t.block_k = bk;
+    Tensor O = attention_forward(Q,K,V,nullptr,t);
+    for (long long i=0;i<O.numel();++i) ASSERT_NEAR(O.at_index(i), R.at_index(i), 1e-5f);
+  }
+}
+
+// 2) Negative tile sizes are rejected
+TEST(Autotune, NegativeBlockSizeThrows) {
+  Tensor Q = Tensor::zeros({1,1,4,4});
+  AttentionOpts opts; opts.block_k = -1;
+  EXPECT_THROW(attention_forward(Q,Q,Q,nullptr,opts), std::invalid_argument);
+}
+
+// 3) Tuned choice is a candidate, persisted to disk and used by resolve_tiles
+TEST(Autotune, TunesPersistsAndReloads) {
+  const std::string path = temp_cache("fa_tiles_test.txt");
+  tune::AutotuneOpts ao;
+  ao.candidates_q = {8, 16};
+  ao.candidates_k = {16, 32};
+  ao.repeats = 1;
+  ao.cache_path = path;
+  tune::TileConfig best = tune::autotune_tiles(48, 8, ao);
+  EXPECT_TRUE(best.block_q == 8 || best.block_q == 16);
+  EXPECT_TRUE(best.block_k == 16 || best.block_k == 32);
+
+  tune::clear_tile_cache();
+  EXPECT_FALSE(tune::lookup_tiles(48, 8, nullptr));
+  tune::load_tile_cache(path);
+  tune::TileConfig got;
+  ASSERT_TRUE(tune::lookup_tiles(48, 8, &got));
+  EXPECT_EQ(got.block_q, best.block_q);
+  EXPECT_EQ(got.block_k, best.block_k);
+
+  AttentionOpts opts;
+  tune::TileConfig r = tune::resolve_tiles(opts, 48, 8);
+  EXPECT_EQ(r.block_q, best.block_q);
+  opts.block_q = 5;  // explicit field overrides the tuned one
+  EXPECT_EQ(tune::resolve_tiles(opts, 48, 8).block_q, 5);
+  tune::clear_tile_cache();
+  std::remove(path.c_str());
+}
+
+// 4) Malformed cache lines are ignored
+TEST(Autotune, MalformedCacheLinesIgnored) {
+  const std::string path = temp_cache("fa_tiles_bad.txt");
+  { std::ofstream f(path); f << "# fa tile cache v1\ngarbage\n12 4 -1 8\n12 4 4 8\n"; }
+  tune::clear_tile_cache();
+  tune::load_tile_cache(path);
+  tune::TileConfig got;
+  ASSERT_TRUE(tune::lookup_tiles(12, 4, &got));
+  EXPECT_EQ(got.block_q, 4);
+  EXPECT_EQ(got.block_k, 8);
+  tune::clear_tile_cache();
+  std::remove(path.c_str());
+}
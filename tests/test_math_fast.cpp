@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+#include "fa/math.hpp"
+#include "fa/simd.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+using namespace fa;
+
+// Documented bound in fa/math.hpp (normal-range results).
+static constexpr int kMaxUlp = 1;
+
+static int64_t ulp_distance(float a, float b) {
+  int32_t ia, ib;
+  std::memcpy(&ia, &a, 4); std::memcpy(&ib, &b, 4);
+  if (ia < 0) ia = int32_t(0x80000000u) - ia;
+  if (ib < 0) ib = int32_t(0x80000000u) - ib;
+  return std::llabs((int64_t)ia - (int64_t)ib);
+}
+
+static std::vector<simd::Isa> available_isas() {
+  std::vector<simd::Isa> out;
+  for (simd::Isa isa : {simd::Isa::Scalar, simd::Isa::AVX2, simd::Isa::AVX512})
+    if (simd::isa_supported(isa)) out.push_back(isa);
+  return out;
+}
+
+// 1) fast_exp and every ISA's batched exp stay within kMaxUlp of std::exp on
+//    a dense sample of the normal range (step 0.000731, ~240k inputs)
+TEST(MathFast, ExpUlpErrorVsStdExp) {
+  std::vector<float> x;
+  for (float v = -87.3f; v < 88.7f; v += 0.000731f) x.push_back(v);
+  std::vector<float> y(x.size());
+  for (simd::Isa isa : available_isas()) {
+    simd::kernels_for(isa).exp(x.data(), y.data(), (int)x.size());
+    int64_t worst = 0;
+    for (size_t i=0;i<x.size();++i) {
+      const float ref = (float)std::exp((double)x[i]);
+      worst = std::max(worst, ulp_distance(y[i], ref));
+      if (isa == simd::Isa::Scalar) ASSERT_EQ(y[i], math::fast_exp(x[i]));
+    }
+    EXPECT_LE(worst, kMaxUlp) << simd::isa_name(isa);
+  }
+}
+
+// 2) Saturation and special values, including odd-length tails
+TEST(MathFast, ExpSpecialValues) {
+  const float inf = std::numeric_limits<float>::infinity();
+  std::vector<float> x = {-inf, -200.0f, -104.5f, 0.0f, 89.0f, inf, std::nanf("")};
+  std::vector<float> y(x.size());
+  for (simd::Isa isa : available_isas()) {
+    simd::kernels_for(isa).exp(x.data(), y.data(), (int)x.size());
+    EXPECT_EQ(y[0], 0.0f); EXPECT_EQ(y[1], 0.0f); EXPECT_EQ(y[2], 0.0f);
+    EXPECT_EQ(y[3], 1.0f);
+    EXPECT_EQ(y[4], inf);  EXPECT_EQ(y[5], inf);
+    EXPECT_TRUE(std::isnan(y[6])) << simd::isa_name(isa);
+  }
+}
+
+// 3) Fused single-pass max+sumexp matches the two-pass helpers
+TEST(MathFast, FusedMaxSumExpMatchesTwoPass) {
+  const float ninf = math::neg_inf();
+  for (simd::Isa isa : available_isas()) {
+    const simd::MicroKernels& k = simd::kernels_for(isa);
+    for (int n : {1, 5, 16, 37, 200}) {
+      std::vector<float> x(n);
+      for (int i=0;i<n;++i) x[i] = (i%7==3) ? ninf : std::sin(0.37f*i)*9.0f + 0.01f*i;
+      float m, s;
+      k.max_sumexp(x.data(), n, &m, &s);
+      const float m2 = math::row_max(x.data(), n);
+      EXPECT_EQ(m, m2);
+      EXPECT_NEAR(s, math::row_sumexp_stable(x.data(), n, m2), 1e-5f * n) << simd::isa_name(isa);
+    }
+    std::vector<float> all(9, ninf);
+    float m = 0, s = 1;
+    k.max_sumexp(all.data(), 9, &m, &s);
+    EXPECT_EQ(m, ninf);
+    EXPECT_EQ(s, 0.0f);
+  }
+}
+
+// 4) softmax_weights: fused exp/normalize sums to one; masked row writes zeros
+TEST(MathFast, SoftmaxWeightsNormalizes) {
+  std::vector<float> x = {-2.0f, 0.0f, 3.0f, 1.0f, math::neg_inf(), 0.5f, -1.0f, 2.0f, 0.25f};
+  std::vector<float> w(x.size());
+  float m, s;
+  math::row_max_sumexp(x.data(), (int)x.size(), &m, &s);
+  math::softmax_weights(x.data(), (int)x.size(), m, s, w.data());
+  float total = 0;
+  for (size_t i=0;i<x.size();++i) {
+    total += w[i];
+    EXPECT_NEAR(w[i], std::exp(x[i]-m)/s, 1e-6f);
+  }
+  EXPECT_NEAR(total, 1.0f, 1e-6f);
+  math::softmax_weights(x.data(), (int)x.size(), math::neg_inf(), 0.0f, w.data());
+  for (float v : w) EXPECT_EQ(v, 0.0f);
+}
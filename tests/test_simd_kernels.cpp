@@ -0,0 +1,130 @@
+#include "gtest/gtest.h"
+#include "fa/simd.hpp"
+#include "fa/tensor.hpp"
+#include "fa/attention.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace fa;
+
+static std::vector<simd::Isa> available_isas() {
+  std::vector<simd::Isa> out;
+  for (simd::Isa isa : {simd::Isa::Scalar, simd::Isa::AVX2, simd::Isa::AVX512})
+    if (simd::isa_supported(isa)) out.push_back(isa);
+  return out;
+}
+
+// 1) QK and PV micro-kernels match a double-precision loop for odd D / nk
+TEST(SimdKernels, QkPvMatchScalarReference) {
+  for (simd::Isa isa : available_isas()) {
+    const simd::MicroKernels& k = simd::kernels_for(isa);
+    for (int D : {1, 7, 16, 33, 64, 80}) for (int nk : {1, 3, 4, 9}) {
+      const int ld = D + 3;
+      Tensor q = Tensor::randn({1,1,1,D}, 1);
+      Tensor kv = Tensor::randn({1,1,nk,ld}, 2);
+      Tensor p = Tensor::randn({1,1,1,nk}, 3);
+      std::vector<float> out(nk), acc(D, 0.5f);
+      k.qk(q.data(), kv.data(), ld, nk, D, out.data());
+      k.pv(p.data(), kv.data(), ld, nk, D, acc.data());
+      for (int c=0;c<nk;++c) {
+        double s = 0; for (int d=0;d<D;++d) s += (double)q.data()[d]*kv.data()[c*ld+d];
+        EXPECT_NEAR(out[c], s, 1e-4) << simd::isa_name(isa) << " D=" << D;
+      }
+      for (int d=0;d<D;++d) {
+        double a = 0.5; for (int c=0;c<nk;++c) a += (double)p.data()[c]*kv.data()[c*ld+d];
+        EXPECT_NEAR(acc[d], a, 1e-4) << simd::isa_name(isa) << " D=" << D;
+      }
+    }
+  }
+}
+
+// 1b) Panel QK over packed K equals qk on the same keys, full and partial panels
+TEST(SimdKernels, QkPanelsMatchQk) {
+  const int P = simd::kPanelKeys;
+  for (simd::Isa isa : available_isas()) {
+    const simd::MicroKernels& k = simd::kernels_for(isa);
+    for (int D : {1, 7, 64, 80}) for (int nk : {1, 15, 16, 17, 40, 64, 100}) {
+      Tensor q = Tensor::randn({1,1,1,D}, 1);
+      Tensor keys = Tensor::randn({1,1,nk,D}, 2);
+      const int np = (nk + P - 1) / P;
+      std::vector<float> kt((size_t)np*D*P, 0.0f), want(nk), got(nk + 1, -7.0f);
+      for (int c=0;c<nk;++c) for (int d=0;d<D;++d) kt[((size_t)(c/P)*D + d)*P + c%P] = keys.data()[c*D + d];
+      k.qk(q.data(), keys.data(), D, nk, D, want.data());
+      k.qk_panels(q.data(), kt.data(), nk, D, got.data());
+      for (int c=0;c<nk;++c) EXPECT_NEAR(got[c], want[c], 1e-4) << simd::isa_name(isa) << " D=" << D << " nk=" << nk;
+      EXPECT_EQ(got[nk], -7.0f) << "wrote past nk";
+    }
+  }
+}
+
+// 2) dot / axpy / scale
+TEST(SimdKernels, DotAxpyScale) {
+  for (simd::Isa isa : available_isas()) {
+    const simd::MicroKernels& k = simd::kernels_for(isa);
+    for (int n : {1, 8, 15, 16, 17, 100}) {
+      Tensor x = Tensor::randn({1,1,1,n}, 4);
+      Tensor y = Tensor::randn({1,1,1,n}, 5);
+      double ref = 0; for (int i=0;i<n;++i) ref += (double)x.data()[i]*y.data()[i];
+      EXPECT_NEAR(k.dot(x.data(), y.data(), n), ref, 1e-4);
+      std::vector<float> z(y.data(), y.data()+n);
+      k.axpy(2.0f, x.data(), z.data(), n);
+      k.scale(0.5f, z.data(), n);
+      for (int i=0;i<n;++i) EXPECT_NEAR(z[i], 0.5f*(y.data()[i]+2.0f*x.data()[i]), 1e-5);
+    }
+  }
+}
+
+// 3) Tiled attention with each ISA matches the reference engine
+TEST(SimdKernels, TiledAttentionPerIsaMatchesReference) {
+  Tensor Q = Tensor::randn({1,2,77,40}, 6);
+  Tensor K = Tensor::randn({1,2,77,40}, 7);
+  Tensor V = Tensor::randn({1,2,77,40}, 8);
+  AttentionOpts ref; ref.causal = true;
+  Tensor R = attention_forward(Q,K,V,nullptr,ref);
+  const simd::Isa prev = simd::kernels().isa;
+  for (simd::Isa isa : available_isas()) {
+    simd::select_isa(isa);
+    AttentionOpts t = ref; t.engine = AttentionEngine::Tiled; t.block_k = 16;
+    Tensor O = attention_forward(Q,K,V,nullptr,t);
+    for (long long i=0;i<O.numel();++i)
+      ASSERT_NEAR(O.at_index(i), R.at_index(i), 1e-5f) << simd::isa_name(isa);
+  }
+  simd::select_isa(prev);
+}
+
+// 3b) Zero weights skip their V row on every ISA: NaN / Inf in masked V rows
+//     never reach the output (kernel and whole tiled pass)
+TEST(SimdKernels, MaskedNonFiniteValueRowsIgnored) {
+  const float nan = std::nanf(""), inf = INFINITY;
+  const int N=40, D=80, len=29;   // D covers the wide blocks and the tails
+  Tensor Q = Tensor::randn({1,2,N,D}, 9), K = Tensor::randn({1,2,N,D}, 10);
+  Tensor V = Tensor::randn({1,2,N,D}, 11), Vbad = V;
+  Tensor M = Tensor::zeros({1,1,1,N});
+  for (int j=0;j<len;++j) M.at(0,0,0,j) = 1.0f;
+  for (int h=0;h<2;++h) for (int j=len;j<N;++j) for (int d=0;d<D;++d) Vbad.at(0,h,j,d) = j % 2 ? nan : inf;
+  AttentionOpts ref;
+  Tensor R = attention_forward(Q,K,V,&M,ref);
+  const simd::Isa prev = simd::kernels().isa;
+  for (simd::Isa isa : available_isas()) {
+    const simd::MicroKernels& k = simd::kernels_for(isa);
+    std::vector<float> p(N, 0.0f), acc(D, 1.0f);
+    for (int j=0;j<len;++j) p[j] = 0.5f;
+    k.pv(p.data(), Vbad.data(), D, N, D, acc.data());
+    for (int d=0;d<D;++d) ASSERT_TRUE(std::isfinite(acc[d])) << simd::isa_name(isa) << " pv d=" << d;
+
+    simd::select_isa(isa);
+    AttentionOpts t = ref; t.engine = AttentionEngine::Tiled; t.block_k = 16;
+    Tensor O = attention_forward(Q,K,Vbad,&M,t);
+    for (long long i=0;i<O.numel();++i)
+      ASSERT_NEAR(O.at_index(i), R.at_index(i), 1e-5f) << simd::isa_name(isa) << " @" << i;
+  }
+  simd::select_isa(prev);
+}
+
+// 4) Dispatch reports a supported ISA and rejects unavailable ones consistently
+TEST(SimdKernels, DispatchConsistency) {
+  EXPECT_TRUE(simd::isa_supported(simd::detected_isa()));
+  EXPECT_TRUE(simd::isa_supported(simd::kernels().isa));
+  for (simd::Isa isa : {simd::Isa::AVX2, simd::Isa::AVX512})
+    if (!simd::isa_supported(isa)) EXPECT_THROW(simd::kernels_for(isa), std::invalid_argument);
+}
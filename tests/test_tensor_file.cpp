@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+#include "fa/attention.hpp"
+#include "fa/tensor.hpp"
+#include "fa/tensor_file.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace fa;
+
+static std::string temp_path(const char* name) {
+  return ::testing::TempDir() + "fa_tensor_file_" + name + ".bin";
+}
+
+// 1) Round trip of several dtypes; views point into the mapping, aligned
+TEST(TensorFile, RoundTripZeroCopy) {
+  const std::string path = temp_path("roundtrip");
+  Tensor K = Tensor::randn({2,3,17,8}, 1);
+  TensorBF16 Kb = cast<bf16>(K);
+  std::vector<int8_t> q(5*7);
+  for (size_t i=0;i<q.size();++i) q[i] = int8_t(int(i) - 17);
+  {
+    io::TensorFileWriter w(path);
+    w.write("K", K);
+    w.write("K_bf16", Kb);
+    w.write("q8", TensorViewT<const int8_t>(q.data(), {5,7}));
+    w.close();
+  }
+  io::MappedTensorFile f(path);
+  EXPECT_EQ(f.version(), io::kTensorFileVersion);
+  ASSERT_EQ(f.records().size(), 3u);
+  EXPECT_TRUE(f.contains("K_bf16"));
+  EXPECT_FALSE(f.contains("V"));
+
+  ConstTensorView k = f.view<float>("K");
+  EXPECT_EQ(k.shape(), K.shape());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(k.data()) % mem::kAlignment, 0u);
+  EXPECT_EQ(0, std::memcmp(k.data(), K.data(), sizeof(float)*(size_t)K.numel()));
+  EXPECT_EQ(f.view<float>("K").data(), k.data());   // same mapping, no copy
+
+  TensorViewT<const bf16> kb = f.view<bf16>("K_bf16");
+  EXPECT_EQ(0, std::memcmp(kb.data(), Kb.data(), sizeof(bf16)*(size_t)Kb.numel()));
+  TensorViewT<const int8_t> q8 = f.view<int8_t>("q8");
+  EXPECT_EQ(q8.shape(), (std::vector<int>{5,7}));
+  EXPECT_EQ(0, std::memcmp(q8.data(), q.data(), q.size()));
+  EXPECT_THROW(f.view<float>("q8"), std::invalid_argument);
+  EXPECT_THROW(f.view<float>("missing"), std::invalid_argument);
+  std::remove(path.c_str());
+}
+
+// 2) Strided views are written row-major; attention over mapped K/V equals
+//    attention over the originals
+TEST(TensorFile, StridedWriteAndAttentionOnMappedKv) {
+  const std::string path = temp_path("strided");
+  const int B=1,H=2,N=40,D=16;
+  Tensor bnhd = Tensor::randn({B,N,H,D}, 2);
+  Tensor Q = Tensor::randn({B,H,N,D}, 3), V = Tensor::randn({B,H,N,D}, 4);
+  const ConstTensorView K = bnhd.view().transpose(1,2);
+  {
+    io::TensorFileWriter w(path, 4096);
+    w.write("K", K);
+    w.write("V", V);
+  }
+  io::MappedTensorFile f(path);
+  EXPECT_EQ(f.alignment(), 4096u);
+  ConstTensorView k = f.view<float>("K");
+  EXPECT_TRUE(k.contiguous());
+  for (int h=0;h<H;++h) for (int i=0;i<N;++i) for (int d=0;d<D;++d)
+    ASSERT_EQ(k.at(0,h,i,d), K.at(0,h,i,d));
+
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.causal = true;
+  Tensor want = attention_forward(Q.view(), K, V.view(), AttentionMask{}, opts);
+  Tensor got = attention_forward(Q.view(), k, f.view<float>("V"), AttentionMask{}, opts);
+  EXPECT_EQ(0, std::memcmp(want.data(), got.data(), sizeof(float)*(size_t)want.numel()));
+  std::remove(path.c_str());
+}
+
+// 3) Streaming: one tensor appended in pieces; misuse is rejected
+TEST(TensorFile, StreamingAppend) {
+  const std::string path = temp_path("stream");
+  Tensor X = Tensor::randn({1,1,1000,3}, 5);
+  {
+    io::TensorFileWriter w(path);
+    w.begin("X", io::DType::F32, X.shape());
+    for (int r=0; r<1000; r+=64)
+      w.append(X.data() + r*3, sizeof(float)*3*std::min(64, 1000 - r));
+    EXPECT_THROW(w.append(X.data(), 4), std::invalid_argument);   // past the end
+    w.end();
+    w.begin("short", io::DType::F16, {4});
+    w.append(X.data(), 2);
+    EXPECT_THROW(w.end(), std::invalid_argument);
+    w.append(X.data(), 6);
+    w.end();
+  }
+  io::MappedTensorFile f(path);
+  ConstTensorView x = f.view<float>("X");
+  EXPECT_EQ(0, std::memcmp(x.data(), X.data(), sizeof(float)*(size_t)X.numel()));
+  EXPECT_EQ(f.record("short").bytes, 8u);
+  std::remove(path.c_str());
+}
+
+// 4) Malformed files are rejected, never mapped past their end
+TEST(TensorFile, MalformedFilesThrow) {
+  const std::string path = temp_path("bad");
+  EXPECT_THROW(io::MappedTensorFile(temp_path("does_not_exist")), std::runtime_error);
+  { std::ofstream out(path, std::ios::binary); out << std::string(100, 'x'); }
+  EXPECT_THROW(io::MappedTensorFile f(path), std::runtime_error);
+
+  Tensor X = Tensor::randn({1,1,64,4}, 6);
+  { io::TensorFileWriter w(path); w.write("X", X); }
+  std::string bytes;
+  { std::ifstream in(path, std::ios::binary); bytes.assign(std::istreambuf_iterator<char>(in), {}); }
+  { std::ofstream out(path, std::ios::binary | std::ios::trunc); out.write(bytes.data(), (std::streamsize)bytes.size() - 100); }
+  EXPECT_THROW(io::MappedTensorFile f(path), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+// 5) Strides whose extent would wrap 64 bits are rejected, not mapped
+TEST(TensorFile, OverflowingStridesThrow) {
+  const std::string path = temp_path("overflow");
+  std::vector<float> x(9, 1.0f);
+  { io::TensorFileWriter w(path); w.write("X", TensorViewT<const float>(x.data(), {9})); }
+  std::string bytes;
+  { std::ifstream in(path, std::ios::binary); bytes.assign(std::istreambuf_iterator<char>(in), {}); }
+  // first record at 64: 32-byte record header, then dims[1], then strides[1]
+  int64_t dim = 0, stride = 0;
+  std::memcpy(&dim, bytes.data() + 64 + 32, sizeof dim);
+  std::memcpy(&stride, bytes.data() + 64 + 40, sizeof stride);
+  ASSERT_EQ(dim, 9);
+  ASSERT_EQ(stride, 1);
+  stride = int64_t(1) << 61;   // 1 + 8*2^61 wraps to 1 element
+  std::memcpy(&bytes[64 + 40], &stride, sizeof stride);
+  { std::ofstream out(path, std::ios::binary | std::ios::trunc); out.write(bytes.data(), (std::streamsize)bytes.size()); }
+  EXPECT_THROW(io::MappedTensorFile f(path), std::runtime_error);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "fa/tensor.hpp"
+#include "fa/tensor_view.hpp"
+#include "fa/attention.hpp"
+#include <cstring>
+#include <vector>
+
+using namespace fa;
+
+static bool bitwise_equal(const Tensor& A, const Tensor& B) {
+  return A.shape()==B.shape() &&
+         std::memcmp(A.data(), B.data(), sizeof(float)*(size_t)A.numel())==0;
+}
+
+// 1) Slice / transpose / permute only rewrite metadata and index correctly
+TEST(TensorView, SliceTransposePermute) {
+  std::vector<float> buf(2*3*4*5);
+  for (size_t i=0;i<buf.size();++i) buf[i] = (float)i;
+  TensorView v(buf.data(), {2,3,4,5});
+  EXPECT_TRUE(v.contiguous());
+  EXPECT_FLOAT_EQ(v.at(1,2,3,4), 119.0f);
+
+  TensorView s = v.slice(2, 1, 2);           // n in [1,3)
+  EXPECT_EQ(s.dim(2), 2);
+  EXPECT_FALSE(s.contiguous());
+  EXPECT_FLOAT_EQ(s.at(0,0,0,0), v.at(0,0,1,0));
+  EXPECT_FLOAT_EQ(s.at(1,2,1,3), v.at(1,2,2,3));
+
+  TensorView t = v.transpose(1, 2);          // (2,4,3,5)
+  EXPECT_EQ(t.dim(1), 4);
+  EXPECT_FLOAT_EQ(t.at(1,3,2,4), v.at(1,2,3,4));
+
+  TensorView p = v.permute({3,0,2,1});       // (5,2,4,3)
+  EXPECT_FLOAT_EQ(p.at(4,1,3,2), v.at(1,2,3,4));
+  EXPECT_EQ(p.data(), v.data());
+
+  Tensor c = Tensor::from(t);
+  EXPECT_TRUE(c.contiguous());
+  EXPECT_FLOAT_EQ(c.at(1,3,2,4), v.at(1,2,3,4));
+}
+
+// 2) Invalid views and accesses throw
+TEST(TensorView, InvalidArgumentsThrow) {
+  std::vector<float> buf(16);
+  EXPECT_THROW(TensorView(nullptr, {1,1,4,4}), std::invalid_argument);
+  EXPECT_THROW(TensorView(buf.data(), {1,1,4,4}, {16,16,4}), std::invalid_argument);
+  TensorView v(buf.data(), {1,1,4,4});
+  EXPECT_THROW(v.slice(2, 3, 2), std::out_of_range);
+  EXPECT_THROW(v.transpose(0, 4), std::out_of_range);
+  EXPECT_THROW(v.permute({0,0,1,2}), std::invalid_argument);
+  EXPECT_THROW(v.at(0,0,4,0), std::out_of_range);
+}
+
+// 3) (B,N,H,D) serving buffer attended as (B,H,N,D) without a copy
+TEST(TensorView, AttentionOnTransposedBuffer_BitwiseMatchesCopy) {
+  const int B=2,N=37,H=3,D=16;
+  Tensor Qb = Tensor::randn({B,N,H,D}, 1);
+  Tensor Kb = Tensor::randn({B,N,H,D}, 2);
+  Tensor Vb = Tensor::randn({B,N,H,D}, 3);
+  ConstTensorView Q = Qb.view().transpose(1,2);
+  ConstTensorView K = Kb.view().transpose(1,2);
+  ConstTensorView V = Vb.view().transpose(1,2);
+  Tensor Mt = Tensor::zeros({B,1,1,N});
+  for (int j=0;j<N;j+=2) { Mt.at(0,0,0,j)=1; Mt.at(1,0,0,N-1-j)=1; }
+
+  for (AttentionEngine e : {AttentionEngine::Reference, AttentionEngine::Tiled}) {
+    AttentionOpts opts; opts.engine = e; opts.causal = true;
+    ConstTensorView M = Mt.view();
+    Tensor O_view = attention_forward(Q,K,V,&M,opts);
+    Tensor O_copy = attention_forward(Tensor::from(Q), Tensor::from(K), Tensor::from(V), &Mt, opts);
+    EXPECT_TRUE(bitwise_equal(O_view, O_copy)) << (int)e;
+  }
+}
+
+// 4) Sliced heads/sequence and a non-unit D stride match the materialized copy
+TEST(TensorView, AttentionOnSlicesAndStridedD) {
+  Tensor Qt = Tensor::randn({1,4,40,8}, 4);
+  Tensor Kt = Tensor::randn({1,4,40,8}, 5);
+  Tensor Dt = Tensor::randn({1,4,8,40}, 6);          // V stored as (B,H,D,N)
+  ConstTensorView Q = Qt.view().slice(1,1,2).slice(2,5,30);
+  ConstTensorView K = Kt.view().slice(1,2,2).slice(2,10,30);
+  ConstTensorView V = Dt.view().transpose(2,3).slice(1,0,2).slice(2,0,30);   // D stride != 1
+  AttentionOpts opts; opts.engine = AttentionEngine::Tiled; opts.block_q = 8; opts.block_k = 16;
+  Tensor O = attention_forward(Q,K,V,nullptr,opts);
+  Tensor R = attention_forward(Tensor::from(Q), Tensor::from(K), Tensor::from(V), nullptr, opts);
+  EXPECT_TRUE(bitwise_equal(O, R));
+  ASSERT_EQ(O.dim(1), 2);
+  ASSERT_EQ(O.dim(2), 30);
+}